@@ -0,0 +1,45 @@
+#define _POSIX_C_SOURCE 199309L
+#include <stdarg.h>
+#include <time.h>
+
+#include "bench.h"
+
+/*
+Returns: Monotonic timestamp in seconds
+*/
+double bench_now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+/*
+Summary: Adds one row to results table with time per iteration in a human readable unit
+*/
+void bench_report(Table *results, const char *bench_case, const char *variant,
+    double seconds, size_t iterations, const char *notes_fmt, ...)
+{
+    double per_iter = seconds / (double)(iterations == 0 ? 1 : iterations);
+    add_cell_fmt(results, " %s ", bench_case);
+    add_cell_fmt(results, " %s ", variant);
+
+    if (per_iter < 1e-6)
+    {
+        add_cell_fmt(results, " %.1f ns ", per_iter * 1e9);
+    }
+    else if (per_iter < 1e-3)
+    {
+        add_cell_fmt(results, " %.2f us ", per_iter * 1e6);
+    }
+    else
+    {
+        add_cell_fmt(results, " %.2f ms ", per_iter * 1e3);
+    }
+
+    va_list args;
+    va_start(args, notes_fmt);
+    add_cell_vfmt(results, notes_fmt, args);
+    va_end(args);
+    next_row(results);
+}
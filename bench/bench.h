@@ -0,0 +1,17 @@
+#pragma once
+#include <stdlib.h>
+#include "../src/table/table.h"
+
+/*
+Benchmarks print their measurements into a shared results table.
+Every benchmark is a function adding any number of rows via bench_report.
+*/
+
+typedef struct {
+    void (*run)(Table *results);
+    const char *name;
+} Benchmark;
+
+double bench_now();
+void bench_report(Table *results, const char *bench_case, const char *variant,
+    double seconds, size_t iterations, const char *notes_fmt, ...);
@@ -0,0 +1,124 @@
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "../src/client/core/aggregate_kernels.h"
+#include "../src/util/alloc_wrappers.h"
+#include "bench_aggregates.h"
+
+#define NUM_VALUES 10000
+#define NUM_CALLS  1000
+
+static int asc_double_cmp(const void *a, const void *b)
+{
+    double x = *(const double*)a;
+    double y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+// Previous implementation: Sorts copy of values
+static double sorted_median(const double *values, double *buffer)
+{
+    memcpy(buffer, values, NUM_VALUES * sizeof(double));
+    qsort(buffer, NUM_VALUES, sizeof(double), asc_double_cmp);
+    return 0.5 * (buffer[NUM_VALUES / 2] + buffer[NUM_VALUES / 2 - 1]);
+}
+
+// Previous implementation: Mean in first pass, squared differences in second pass
+static double two_pass_variance(const double *values)
+{
+    double mean = 0;
+    for (size_t i = 0; i < NUM_VALUES; i++) mean += values[i];
+    mean /= NUM_VALUES;
+    double res = 0;
+    for (size_t i = 0; i < NUM_VALUES; i++) res += pow(values[i] - mean, 2);
+    return res / NUM_VALUES;
+}
+
+static double serial_sum(const double *values)
+{
+    double res = 0;
+    for (size_t i = 0; i < NUM_VALUES; i++) res += values[i];
+    return res;
+}
+
+static double serial_max(const double *values)
+{
+    double res = -INFINITY;
+    for (size_t i = 0; i < NUM_VALUES; i++)
+    {
+        if (values[i] > res) res = values[i];
+    }
+    return res;
+}
+
+static void aggregates_bench(Table *results)
+{
+    double *values = malloc_wrapper(NUM_VALUES * sizeof(double));
+    double *buffer = malloc_wrapper(NUM_VALUES * sizeof(double));
+    srand(42);
+    for (size_t i = 0; i < NUM_VALUES; i++) values[i] = (double)rand() / RAND_MAX * 1000;
+
+    volatile double res = 0;
+    double start = bench_now();
+    for (size_t i = 0; i < NUM_CALLS; i++) res = sorted_median(values, buffer);
+    bench_report(results, "median", "qsort", bench_now() - start, NUM_CALLS, " %g ", res);
+
+    start = bench_now();
+    for (size_t i = 0; i < NUM_CALLS; i++) res = agg_median(values, NUM_VALUES);
+    bench_report(results, "median", "Quickselect", bench_now() - start, NUM_CALLS, " %g ", res);
+
+    start = bench_now();
+    for (size_t i = 0; i < NUM_CALLS; i++) res = two_pass_variance(values);
+    bench_report(results, "var", "Two passes", bench_now() - start, NUM_CALLS, " %g ", res);
+
+    start = bench_now();
+    for (size_t i = 0; i < NUM_CALLS; i++) res = agg_variance(values, NUM_VALUES);
+    bench_report(results, "var", "Blocked Welford", bench_now() - start, NUM_CALLS, " %g ", res);
+
+    start = bench_now();
+    for (size_t i = 0; i < NUM_CALLS; i++) res = serial_sum(values);
+    bench_report(results, "sum", "Serial", bench_now() - start, NUM_CALLS, " %g ", res);
+
+    start = bench_now();
+    for (size_t i = 0; i < NUM_CALLS; i++) res = agg_sum(values, NUM_VALUES);
+    bench_report(results, "sum", "4 lanes", bench_now() - start, NUM_CALLS, " %g ", res);
+
+    start = bench_now();
+    for (size_t i = 0; i < NUM_CALLS; i++) res = serial_max(values);
+    bench_report(results, "max", "Serial", bench_now() - start, NUM_CALLS, " %g ", res);
+
+    start = bench_now();
+    for (size_t i = 0; i < NUM_CALLS; i++) res = agg_max(values, NUM_VALUES);
+    bench_report(results, "max", "4 lanes", bench_now() - start, NUM_CALLS, " %g ", res);
+
+    // avg, var, min and max of the same list
+    start = bench_now();
+    for (size_t i = 0; i < NUM_CALLS; i++)
+    {
+        double min = INFINITY;
+        for (size_t j = 0; j < NUM_VALUES; j++) min = values[j] < min ? values[j] : min;
+        res = serial_sum(values) / NUM_VALUES + two_pass_variance(values) + serial_max(values) + min;
+    }
+    bench_report(results, "avg, var, min, max", "Separate", bench_now() - start, NUM_CALLS, " %g ", res);
+
+    start = bench_now();
+    for (size_t i = 0; i < NUM_CALLS; i++)
+    {
+        AggregateStats stats;
+        agg_compute(values, NUM_VALUES, AGG_SINGLE_PASS, &stats);
+        res = stats.mean + stats.variance + stats.max + stats.min;
+    }
+    bench_report(results, "avg, var, min, max", "Single pass", bench_now() - start, NUM_CALLS, " %g ", res);
+
+    free(values);
+    free(buffer);
+}
+
+Benchmark get_aggregates_benchmark()
+{
+    return (Benchmark){
+        aggregates_bench,
+        "Aggregates"
+    };
+}
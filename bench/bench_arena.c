@@ -0,0 +1,110 @@
+#include <stdlib.h>
+
+#include "../src/engine/tree/node.h"
+#include "../src/engine/tree/tree_util.h"
+#include "../src/engine/parsing/parser.h"
+#include "../src/client/core/arith_context.h"
+#include "../src/client/simplification/simplification.h"
+#include "../tests/fuzzer.h"
+#include "bench_arena.h"
+
+#define ARENA_BLOCKSIZE    65536
+#define NUM_SIMPL_ROUNDS   50
+#define NUM_RANDOM_TREES   20000
+#define MAX_INNER_NODES    30
+
+static const size_t NUM_EXPRESSIONS = 8;
+static const char *expressions[] = {
+    "x+x+x+x+x",
+    "10x-x-x-x-10x",
+    "(x^2+x^3)x^4",
+    "sqrt(x)/sqrt(x y)",
+    "avg(a,a,b,b)",
+    "(10x^10)'''''''''''",
+    "deriv(x^y*sin(x)*cos(x), x)",
+    "log(x,2)'+sqrt(x)'"
+};
+
+// Parses and simplifies all expressions, intermediate nodes live in arena if not NULL
+static void simplify_all(Arena *arena)
+{
+    for (size_t i = 0; i < NUM_EXPRESSIONS; i++)
+    {
+        node_set_arena(arena);
+        Node *tree = parse_easy(g_ctx, expressions[i]);
+        simplify(&tree, NULL);
+        node_set_arena(NULL);
+
+        if (arena != NULL)
+        {
+            // Promote result, as arith_parse does
+            Node *result = tree_copy(tree);
+            arena_reset(arena);
+            tree = result;
+        }
+        free_tree(tree);
+    }
+}
+
+static void random_trees(Arena *arena)
+{
+    for (size_t i = 0; i < NUM_RANDOM_TREES; i++)
+    {
+        node_set_arena(arena);
+        Node *tree = NULL;
+        get_random_tree(MAX_INNER_NODES, &tree);
+        free_tree(tree);
+        node_set_arena(NULL);
+        if (arena != NULL) arena_reset(arena);
+    }
+}
+
+static void run(Table *results, const char *bench_case, void (*workload)(Arena*), size_t iterations)
+{
+    Arena arena = arena_create(ARENA_BLOCKSIZE);
+
+    node_set_recycling(false);
+    node_reset_alloc_stats();
+    double start = bench_now();
+    for (size_t i = 0; i < iterations; i++) workload(NULL);
+    double time = bench_now() - start;
+    NodeAllocStats stats = node_get_alloc_stats();
+    bench_report(results, bench_case, "malloc", time, iterations,
+        " %zu mallocs, %zu frees per iter ",
+        stats.heap_allocs / iterations, stats.frees / iterations);
+
+    node_set_recycling(true);
+    node_reset_alloc_stats();
+    start = bench_now();
+    for (size_t i = 0; i < iterations; i++) workload(NULL);
+    time = bench_now() - start;
+    stats = node_get_alloc_stats();
+    bench_report(results, bench_case, "recycled", time, iterations,
+        " %.1f%% recycled, %zu live at peak, %zu cached ",
+        100.0 * stats.recycled / stats.heap_allocs, stats.peak_live, stats.cached);
+
+    node_reset_alloc_stats();
+    start = bench_now();
+    for (size_t i = 0; i < iterations; i++) workload(&arena);
+    time = bench_now() - start;
+    stats = node_get_alloc_stats();
+    bench_report(results, bench_case, "arena", time, iterations,
+        " %zu mallocs, %zu arena allocs per iter, %zu blocks ",
+        stats.heap_allocs / iterations, stats.arena_allocs / iterations, arena.num_blocks);
+
+    arena_destroy(&arena);
+}
+
+void arena_bench(Table *results)
+{
+    run(results, "Parse and simplify", simplify_all, NUM_SIMPL_ROUNDS);
+    run(results, "Random trees", random_trees, 1);
+}
+
+Benchmark get_arena_benchmark()
+{
+    return (Benchmark){
+        arena_bench,
+        "Node arena"
+    };
+}
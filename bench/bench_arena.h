@@ -0,0 +1,3 @@
+#include "bench.h"
+
+Benchmark get_arena_benchmark();
@@ -0,0 +1,132 @@
+#include <stdlib.h>
+
+#include "../src/engine/tree/node.h"
+#include "../src/engine/tree/tree_util.h"
+#include "../src/engine/evaluation/bytecode.h"
+#include "../src/engine/evaluation/jit.h"
+#include "../src/client/core/arith_context.h"
+#include "../src/client/core/arith_evaluation.h"
+#include "../tests/fuzzer.h"
+#include "bench_jit.h"
+
+#define NUM_TREES       100
+#define NUM_EVALUATIONS 1000 // Per tree
+#define NUM_VARS        5
+
+static const size_t NUM_SIZES = 3;
+static const size_t sizes[] = { 10, 50, 200 };
+
+// Names of variables generated by fuzzer
+static const char *var_names[] = { "x", "y", "z", "abc", "def" };
+
+/*
+Summary: Evaluates every tree NUM_EVALUATIONS times, variables are replaced by constants beforehand
+Returns: Number of evaluations that succeeded
+*/
+static size_t evaluate_trees(Node **trees)
+{
+    size_t num_success = 0;
+    for (size_t i = 0; i < NUM_TREES; i++)
+    {
+        for (size_t j = 0; j < NUM_EVALUATIONS; j++)
+        {
+            double res = 0;
+            num_success += tree_reduce(trees[i], arith_op_evaluate, &res, NULL) == LISTENERERR_SUCCESS;
+        }
+    }
+    return num_success;
+}
+
+static size_t evaluate_bytecodes(Bytecode *bytecodes, const double *var_values)
+{
+    size_t num_success = 0;
+    for (size_t i = 0; i < NUM_TREES; i++)
+    {
+        for (size_t j = 0; j < NUM_EVALUATIONS; j++)
+        {
+            double res = 0;
+            num_success += bytecode_run(&bytecodes[i], arith_op_evaluate, var_values, &res, NULL) == LISTENERERR_SUCCESS;
+        }
+    }
+    return num_success;
+}
+
+static size_t evaluate_native(JitCode *codes, const double *var_values)
+{
+    size_t num_success = 0;
+    for (size_t i = 0; i < NUM_TREES; i++)
+    {
+        for (size_t j = 0; j < NUM_EVALUATIONS; j++)
+        {
+            double res = 0;
+            num_success += jit_run(&codes[i], var_values, &res, NULL) == LISTENERERR_SUCCESS;
+        }
+    }
+    return num_success;
+}
+
+static void jit_bench(Table *results)
+{
+    // All variables are 1 to make all encodings compute the same
+    Node *one = malloc_constant_node(1, 0);
+    const double var_values[] = { 1, 1, 1, 1, 1 };
+    size_t iterations = NUM_TREES * NUM_EVALUATIONS;
+
+    for (size_t i = 0; i < NUM_SIZES; i++)
+    {
+        Node *trees[NUM_TREES];
+        Bytecode bytecodes[NUM_TREES];
+        JitCode codes[NUM_TREES];
+        bool native = true;
+        size_t num_nodes = 0;
+        for (size_t j = 0; j < NUM_TREES; j++)
+        {
+            get_random_tree(sizes[i], &trees[j]);
+            num_nodes += get_info(trees[j]).num_nodes;
+            bytecode_compile(trees[j], arith_op_info, &bytecodes[j]);
+            native = native && jit_compile(&bytecodes[j], arith_op_evaluate, &codes[j]);
+            for (size_t k = 0; k < NUM_VARS; k++) replace_variable_nodes(&trees[j], one, var_names[k]);
+        }
+
+        char bench_case[30];
+        snprintf(bench_case, sizeof(bench_case), "%zu nodes avg.", num_nodes / NUM_TREES);
+
+        double start = bench_now();
+        size_t num_success = evaluate_trees(trees);
+        bench_report(results, bench_case, "tree_reduce", bench_now() - start, iterations,
+            " %zu succeeded ", num_success);
+
+        start = bench_now();
+        num_success = evaluate_bytecodes(bytecodes, var_values);
+        bench_report(results, bench_case, "Bytecode", bench_now() - start, iterations,
+            " %zu succeeded ", num_success);
+
+        if (native)
+        {
+            start = bench_now();
+            num_success = evaluate_native(codes, var_values);
+            bench_report(results, bench_case, "JIT", bench_now() - start, iterations,
+                " %zu succeeded ", num_success);
+        }
+        else
+        {
+            bench_report(results, bench_case, "JIT", 0, iterations, " not available, make bench JIT=1 ");
+        }
+
+        for (size_t j = 0; j < NUM_TREES; j++)
+        {
+            free_tree(trees[j]);
+            bytecode_destroy(&bytecodes[j]);
+            if (native) jit_destroy(&codes[j]);
+        }
+    }
+    free_tree(one);
+}
+
+Benchmark get_jit_benchmark()
+{
+    return (Benchmark){
+        jit_bench,
+        "JIT"
+    };
+}
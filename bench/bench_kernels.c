@@ -0,0 +1,60 @@
+#include <stdlib.h>
+
+#include "../src/client/core/integer_kernels.h"
+#include "bench_kernels.h"
+
+#define NUM_CALLS 100000
+
+typedef struct {
+    const char *bench_case;
+    const char *variant;
+    double (*unary)(double);
+    double (*binary)(double, double);
+    double a;
+    double b;
+} KernelCase;
+
+// Worst cases: Greatest exact arguments, consecutive Fibonacci numbers for gcd, floating-point fallbacks
+static const size_t NUM_KERNEL_CASES = 12;
+static const KernelCase kernel_cases[] = {
+    { "fib",       "fib(92), exact",        int_fib,       NULL,         92,                  0 },
+    { "fib",       "fib(1476), Binet",      int_fib,       NULL,         1476,                0 },
+    { "gcd",       "gcd(2^53, 1)",          NULL,          int_gcd,      9007199254740992.0,  1 },
+    { "gcd",       "gcd(F(77), F(76))",     NULL,          int_gcd,      5527939700884757.0,  3416454622906707.0 },
+    { "gcd",       "gcd(10^300, 1.87*10^286)",    NULL,          int_gcd,      1e300,               1.87e286 },
+    { "lcm",       "lcm(2^53-1, 2^52-1)",   NULL,          int_lcm,      9007199254740991.0,  4503599627370495.0 },
+    { "binomial",  "66 C 33, exact",        NULL,          int_binomial, 66,                  33 },
+    { "binomial",  "10^6 C 64, product",    NULL,          int_binomial, 1e6,                 64 },
+    { "binomial",  "10^6 C 5*10^5, lgamma", NULL,          int_binomial, 1e6,                 5e5 },
+    { "factorial", "20!, table",            int_factorial, NULL,         20,                  0 },
+    { "factorial", "170!",                  int_factorial, NULL,         170,                 0 },
+    { "factorial", "10^15!",                int_factorial, NULL,         1e15,                0 }
+};
+
+static void kernels_bench(Table *results)
+{
+    for (size_t i = 0; i < NUM_KERNEL_CASES; i++)
+    {
+        const KernelCase *kernel = &kernel_cases[i];
+        // Vary argument slightly to keep compiler from hoisting calls
+        volatile double offset = 0;
+        volatile double res = 0;
+        double start = bench_now();
+        for (size_t j = 0; j < NUM_CALLS; j++)
+        {
+            res = kernel->unary != NULL
+                ? kernel->unary(kernel->a + offset)
+                : kernel->binary(kernel->a + offset, kernel->b);
+        }
+        bench_report(results, kernel->bench_case, kernel->variant, bench_now() - start, NUM_CALLS,
+            " result %g ", res);
+    }
+}
+
+Benchmark get_kernels_benchmark()
+{
+    return (Benchmark){
+        kernels_bench,
+        "Integer kernels"
+    };
+}
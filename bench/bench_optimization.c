@@ -0,0 +1,71 @@
+#include <stdlib.h>
+
+#include "../src/util/alloc_wrappers.h"
+#include "../src/engine/tree/tree_util.h"
+#include "../src/engine/evaluation/bytecode.h"
+#include "../src/engine/parsing/parser.h"
+#include "../src/client/core/arith_context.h"
+#include "../src/client/core/arith_evaluation.h"
+#include "../src/client/core/arith_optimization.h"
+#include "bench_optimization.h"
+
+#define NUM_ROWS 100000
+
+static const size_t NUM_EXPRESSIONS = 3;
+static const char *expressions[] = {
+    "x^5-3x^4+2x^3-x^2/2+7x-1",
+    "sin(x)^2+cos(x)^2+sin(x)*cos(x)",
+    "log(x+1,10)/3+x^3"
+};
+
+// Evaluates cofunctions separately
+static OpInfo unfused_op_info(const Operator *op)
+{
+    OpInfo info = arith_op_info(op);
+    info.cofunction = NULL;
+    return info;
+}
+
+static void run_variant(Table *results, const char *expression, const char *variant, const Node *tree, OpClassifier classifier)
+{
+    double *values = malloc_wrapper(NUM_ROWS * sizeof(double));
+    double *out = malloc_wrapper(NUM_ROWS * sizeof(double));
+    ListenerError *errors = malloc_wrapper(NUM_ROWS * sizeof(ListenerError));
+    for (size_t i = 0; i < NUM_ROWS; i++) values[i] = i * 0.001;
+    const double *columns[] = { values };
+
+    Bytecode bytecode;
+    bytecode_compile(tree, classifier, &bytecode);
+    double start = bench_now();
+    bytecode_run_batch(&bytecode, arith_op_evaluate, columns, NUM_ROWS, out, errors);
+    double seconds = bench_now() - start;
+    double sum = 0;
+    for (size_t i = 0; i < NUM_ROWS; i++) sum += out[i];
+    bench_report(results, expression, variant, seconds, NUM_ROWS, " sum %.10g, %zu instructions ",
+        sum, bytecode.num_instructions);
+
+    bytecode_destroy(&bytecode);
+    free(values);
+    free(out);
+    free(errors);
+}
+
+static void optimization_bench(Table *results)
+{
+    for (size_t i = 0; i < NUM_EXPRESSIONS; i++)
+    {
+        Node *tree = parse_easy(g_ctx, expressions[i]);
+        run_variant(results, expressions[i], "Plain", tree, unfused_op_info);
+        arith_optimize(&tree);
+        run_variant(results, expressions[i], "Optimized", tree, arith_op_info);
+        free_tree(tree);
+    }
+}
+
+Benchmark get_optimization_benchmark()
+{
+    return (Benchmark){
+        optimization_bench,
+        "Evaluation-oriented optimization"
+    };
+}
@@ -0,0 +1,70 @@
+#include <stdlib.h>
+
+#include "../src/engine/tree/node.h"
+#include "../src/engine/tree/tree_util.h"
+#include "../src/engine/parsing/parser.h"
+#include "../src/client/core/arith_context.h"
+#include "../src/client/simplification/simplification.h"
+#include "../src/util/string_builder.h"
+#include "bench_simplification.h"
+
+#define NUM_REPETITIONS 5
+
+static const size_t NUM_SIZES = 3;
+static const size_t sizes[] = { 10, 20, 40 };
+
+static const size_t NUM_VARIABLES = 5;
+static const char *variables[] = { "a", "bb", "sin(c)", "d^2", "e f" };
+
+/*
+Summary: Builds sum or product of size many terms cycling through variables,
+    like "a+bb+sin(c)+d^2+e f+a+...". Rules combining equal terms compare each pair of terms.
+*/
+static char *build_expression(size_t size, const char *op)
+{
+    StringBuilder builder = strbuilder_create(100);
+    for (size_t i = 0; i < size; i++)
+    {
+        if (i > 0) strbuilder_append(&builder, "%s", op);
+        strbuilder_append(&builder, "(%s)", variables[i % NUM_VARIABLES]);
+    }
+    return builder.buffer;
+}
+
+static void run(Table *results, const char *name, const char *op)
+{
+    for (size_t i = 0; i < NUM_SIZES; i++)
+    {
+        char *expr = build_expression(sizes[i], op);
+
+        node_reset_alloc_stats();
+        double start = bench_now();
+        for (size_t j = 0; j < NUM_REPETITIONS; j++)
+        {
+            Node *tree = parse_easy(g_ctx, expr);
+            simplify(&tree, NULL);
+            free_tree(tree);
+        }
+        double time = bench_now() - start;
+
+        char bench_case[30];
+        snprintf(bench_case, sizeof(bench_case), "%s, %zu terms", name, sizes[i]);
+        bench_report(results, bench_case, "simplify", time, NUM_REPETITIONS,
+            " %zu node allocations per iter ", node_get_alloc_stats().heap_allocs / NUM_REPETITIONS);
+        free(expr);
+    }
+}
+
+static void simplification_bench(Table *results)
+{
+    run(results, "Sum", "+");
+    run(results, "Product", "*");
+}
+
+Benchmark get_simplification_benchmark()
+{
+    return (Benchmark){
+        simplification_bench,
+        "Simplification"
+    };
+}
@@ -0,0 +1,108 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../src/engine/tree/node.h"
+#include "../src/engine/tree/tree_util.h"
+#include "../src/engine/tree/tree_to_string.h"
+#include "../src/client/core/arith_context.h"
+#include "../src/client/core/arith_evaluation.h"
+#include "bench_traversal.h"
+
+#define MAX_NODES 4000000 // Total number of nodes per case, operations are repeated on smaller trees
+
+static const size_t NUM_DEPTHS = 4;
+static const size_t depths[] = { 1000, 10000, 100000, 1000000 };
+
+// Degenerated tree 1+1+...+1 as parsed from a long sum, every operator is the left child of its parent
+static Node *deep_sum(size_t depth)
+{
+    const Operator *plus = ctx_lookup_op(g_ctx, "+", OP_PLACE_INFIX);
+    Node *res = malloc_constant_node(1, 0);
+    for (size_t i = 0; i < depth; i++)
+    {
+        Node *parent = malloc_operator_node(plus, 2, 0);
+        set_child(parent, 0, res);
+        set_child(parent, 1, malloc_constant_node(1, 0));
+        res = parent;
+    }
+    return res;
+}
+
+// Balanced tree with the same number of nodes as deep_sum(depth)
+static Node *wide_sum(size_t depth)
+{
+    if (depth == 0) return malloc_constant_node(1, 0);
+    Node *res = malloc_operator_node(ctx_lookup_op(g_ctx, "+", OP_PLACE_INFIX), 2, 0);
+    set_child(res, 0, wide_sum((depth - 1) / 2));
+    set_child(res, 1, wide_sum(depth - 1 - (depth - 1) / 2));
+    return res;
+}
+
+static void run(Table *results, const char *bench_case, Node *(*construct)(size_t), size_t depth)
+{
+    size_t iterations = MAX_NODES / (2 * depth + 1);
+    Node **trees = malloc(iterations * sizeof(Node*));
+    Node **copies = malloc(iterations * sizeof(Node*));
+    for (size_t i = 0; i < iterations; i++) trees[i] = construct(depth);
+
+    double start = bench_now();
+    for (size_t i = 0; i < iterations; i++) copies[i] = tree_copy(trees[i]);
+    bench_report(results, bench_case, "tree_copy", bench_now() - start, iterations, "");
+
+    size_t num_equal = 0;
+    start = bench_now();
+    for (size_t i = 0; i < iterations; i++) num_equal += tree_equals(trees[i], copies[i]);
+    bench_report(results, bench_case, "tree_equals", bench_now() - start, iterations, " %zu equal ", num_equal);
+
+    double sum = 0;
+    start = bench_now();
+    for (size_t i = 0; i < iterations; i++)
+    {
+        double res = 0;
+        tree_reduce(trees[i], arith_op_evaluate, &res, NULL);
+        sum += res;
+    }
+    bench_report(results, bench_case, "tree_reduce", bench_now() - start, iterations, " sum %g ", sum);
+
+    size_t num_chars = 0;
+    start = bench_now();
+    for (size_t i = 0; i < iterations; i++)
+    {
+        char *str = tree_to_str(trees[i]);
+        num_chars += strlen(str);
+        free(str);
+    }
+    bench_report(results, bench_case, "tree_to_str", bench_now() - start, iterations, " %zu chars ", num_chars);
+
+    start = bench_now();
+    for (size_t i = 0; i < iterations; i++)
+    {
+        free_tree(trees[i]);
+        free_tree(copies[i]);
+    }
+    bench_report(results, bench_case, "free_tree (2x)", bench_now() - start, iterations, "");
+
+    free(trees);
+    free(copies);
+}
+
+static void traversal_bench(Table *results)
+{
+    for (size_t i = 0; i < NUM_DEPTHS; i++)
+    {
+        char bench_case[30];
+        snprintf(bench_case, sizeof(bench_case), "Depth %zu", depths[i]);
+        run(results, bench_case, deep_sum, depths[i]);
+    }
+    // Same number of nodes as largest degenerated tree, depth is logarithmic
+    run(results, "Balanced", wide_sum, depths[NUM_DEPTHS - 1]);
+}
+
+Benchmark get_traversal_benchmark()
+{
+    return (Benchmark){
+        traversal_bench,
+        "Traversal"
+    };
+}
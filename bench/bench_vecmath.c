@@ -0,0 +1,113 @@
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "../src/util/alloc_wrappers.h"
+#include "../src/engine/evaluation/bytecode.h"
+#include "../src/engine/evaluation/vecmath.h"
+#include "../src/engine/parsing/parser.h"
+#include "../src/client/core/arith_context.h"
+#include "../src/client/core/arith_evaluation.h"
+#include "bench_vecmath.h"
+
+#define NUM_REPETITIONS 4000
+#define NUM_ROWS        100000
+
+static const size_t NUM_FUNCTIONS = 4;
+static const struct {
+    const char *name;
+    void (*vectorized)(double*, size_t);
+    double (*scalar)(double);
+    double min;
+    double max;
+} functions[] = {
+    { "exp", vecmath_exp, exp, -20,  20 },
+    { "log", vecmath_log, log, 1e-3, 1e3 },
+    { "sin", vecmath_sin, sin, -100, 100 },
+    { "cos", vecmath_cos, cos, -100, 100 }
+};
+
+static const char *expression = "sin(x)*exp(-x/100)+cos(2x)+ln(x+1)";
+
+static OpInfo scalar_op_info(const Operator *op)
+{
+    OpInfo info = arith_op_info(op);
+    info.batch = NULL;
+    return info;
+}
+
+static double sum_batch(const Bytecode *bytecode, const double *values, double *out, ListenerError *errors)
+{
+    const double *columns[] = { values };
+    bytecode_run_batch(bytecode, arith_op_evaluate, columns, NUM_ROWS, out, errors);
+    double sum = 0;
+    for (size_t i = 0; i < NUM_ROWS; i++) sum += out[i];
+    return sum;
+}
+
+static void vecmath_bench(Table *results)
+{
+    // One column of batch evaluation
+    double args[BYTECODE_BATCH_SIZE];
+    double column[BYTECODE_BATCH_SIZE];
+    for (size_t i = 0; i < NUM_FUNCTIONS; i++)
+    {
+        for (size_t j = 0; j < BYTECODE_BATCH_SIZE; j++)
+        {
+            args[j] = functions[i].min + (functions[i].max - functions[i].min) * j / BYTECODE_BATCH_SIZE;
+        }
+
+        volatile double res = 0;
+        double start = bench_now();
+        for (size_t k = 0; k < NUM_REPETITIONS; k++)
+        {
+            for (size_t j = 0; j < BYTECODE_BATCH_SIZE; j++) column[j] = functions[i].scalar(args[j]);
+            res = column[k % BYTECODE_BATCH_SIZE];
+        }
+        bench_report(results, functions[i].name, "libm", bench_now() - start,
+            NUM_REPETITIONS * BYTECODE_BATCH_SIZE, " %g ", res);
+
+        start = bench_now();
+        for (size_t k = 0; k < NUM_REPETITIONS; k++)
+        {
+            memcpy(column, args, sizeof(column));
+            functions[i].vectorized(column, BYTECODE_BATCH_SIZE);
+            res = column[k % BYTECODE_BATCH_SIZE];
+        }
+        bench_report(results, functions[i].name, "vecmath", bench_now() - start,
+            NUM_REPETITIONS * BYTECODE_BATCH_SIZE, " %g, %s ", res, vecmath_get_isa());
+    }
+
+    // Table-like evaluation of whole expression
+    double *values = malloc_wrapper(NUM_ROWS * sizeof(double));
+    double *out = malloc_wrapper(NUM_ROWS * sizeof(double));
+    ListenerError *errors = malloc_wrapper(NUM_ROWS * sizeof(ListenerError));
+    for (size_t i = 0; i < NUM_ROWS; i++) values[i] = i * 0.01;
+    Node *tree = parse_easy(g_ctx, expression);
+
+    Bytecode bytecode;
+    bytecode_compile(tree, scalar_op_info, &bytecode);
+    double start = bench_now();
+    double sum = sum_batch(&bytecode, values, out, errors);
+    bench_report(results, expression, "Batch, libm", bench_now() - start, NUM_ROWS, " sum %.10g ", sum);
+    bytecode_destroy(&bytecode);
+
+    bytecode_compile(tree, arith_op_info, &bytecode);
+    start = bench_now();
+    sum = sum_batch(&bytecode, values, out, errors);
+    bench_report(results, expression, "Batch, vecmath", bench_now() - start, NUM_ROWS, " sum %.10g ", sum);
+    bytecode_destroy(&bytecode);
+
+    free_tree(tree);
+    free(values);
+    free(out);
+    free(errors);
+}
+
+Benchmark get_vecmath_benchmark()
+{
+    return (Benchmark){
+        vecmath_bench,
+        "Vectorized math"
+    };
+}
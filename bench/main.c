@@ -0,0 +1,65 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../src/table/table.h"
+#include "../src/client/commands/commands.h"
+#include "../src/client/version.h"
+
+#include "bench.h"
+#include "bench_arena.h"
+#include "bench_simplification.h"
+#include "bench_traversal.h"
+#include "bench_jit.h"
+#include "bench_kernels.h"
+#include "bench_aggregates.h"
+#include "bench_vecmath.h"
+#include "bench_optimization.h"
+
+#define FUZZER_SEED 21
+
+/*
+Benchmarks are compiled with optimizations and without DEBUG (make bench).
+Absolute numbers depend on the machine, compare variants within one run.
+*/
+
+static const size_t NUM_BENCHMARKS = 8;
+static Benchmark (*benchmark_getters[])() = {
+    get_arena_benchmark,
+    get_simplification_benchmark,
+    get_traversal_benchmark,
+    get_jit_benchmark,
+    get_kernels_benchmark,
+    get_aggregates_benchmark,
+    get_vecmath_benchmark,
+    get_optimization_benchmark
+};
+
+int main()
+{
+    srand(FUZZER_SEED);
+    init_commands();
+
+    for (size_t i = 0; i < NUM_BENCHMARKS; i++)
+    {
+        Benchmark benchmark = benchmark_getters[i]();
+        Table *results = get_empty_table();
+        set_default_alignments(results, 4,
+            (TableHAlign[]){ H_ALIGN_LEFT, H_ALIGN_LEFT, H_ALIGN_RIGHT, H_ALIGN_LEFT }, NULL);
+        add_cell_fmt(results, " %s ", benchmark.name);
+        add_cell(results, " Variant ");
+        add_cell(results, " Time/iter ");
+        add_cell(results, " Notes ");
+        next_row(results);
+        set_hline(results, BORDER_SINGLE);
+
+        benchmark.run(results);
+
+        make_boxed(results, BORDER_SINGLE);
+        print_table(results);
+        free_table(results);
+    }
+
+    unload_commands();
+    printf(COPYRIGHT_NOTICE);
+    return EXIT_SUCCESS;
+}
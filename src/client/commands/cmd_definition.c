@@ -73,7 +73,8 @@ static bool add_function(char *name, char *left, char *right, bool is_constant,
     const Operator *op = ctx_lookup_op(g_ctx, name, OP_PLACE_FUNCTION);
     if (op != NULL)
     {
-        if (op->id < NUM_ARITH_OPS)
+        // Only built-in operators have traits
+        if (op->traits != NULL)
         {
             report_error(ERR_BUILTIN_REDEFINITION);
         }
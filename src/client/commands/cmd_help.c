@@ -41,7 +41,7 @@ static const char *LICENSE =
 static const char *COMMAND_TABLE[NUM_COMMANDS][2] = {
     { "<func|const> = <after>",                  "Adds function or constant" },
     { "table <expr> ; <from> ; <to> ; <step>  \n"
-      "   [fold <expr> ; <init>]",               "Prints table of values" },
+      "   [fold <expr> ; <init>] [> <path>]",    "Prints table of values or exports them as .csv, .tsv or .f64" },
     { "load [simplification] <path>",            "Executes commands or loads simplification ruleset in file" },
     { "clear [<func>]",                          "Clears all or one function or constant" },
     { "help [operators]",                        "Shows this message or a verbose list of all operators" },
@@ -1,23 +1,50 @@
 #include <string.h>
+#include <errno.h>
+#include <math.h>
 
 #include "../../util/console_util.h"
 #include "../../util/string_util.h"
 #include "../../util/string_builder.h"
+#include "../../util/alloc_wrappers.h"
+#include "../../util/thread_pool.h"
 #include "../../engine/tree/tree_to_string.h"
 #include "../../engine/tree/tree_util.h"
-#include "../../table/table.h"
+#include "../../engine/evaluation/bytecode.h"
+#include "../../engine/evaluation/jit.h"
+#include "../../table/table_stream.h"
+#include "../../table/table_export.h"
 #include "../core/arith_context.h"
 #include "../core/history.h"
 #include "../core/arith_evaluation.h"
+#include "../core/arith_optimization.h"
 #include "cmd_table.h"
 
 #define COMMAND      "table "
 #define FOLD_KEYWORD " fold "
 #define FOLD_VAR_1   "x"
 #define FOLD_VAR_2   "y"
+#define EXPORT_KEYWORD '>'
 
 #define STRBUILDER_STARTSIZE 10
 #define DOUBLE_FMT "%f"
+#define ROWS_PER_TASK   16384 // Rows evaluated at once by a thread, multiple of BYTECODE_BATCH_SIZE
+#define RANGE_TOLERANCE 1e-9  // In steps, end of range is included despite rounding of (end - start) / step
+#define TABLE_WINDOW    1024  // Rows that fix column widths before they are printed
+
+// Batch of rows split into chunks of ROWS_PER_TASK for the thread pool
+typedef struct {
+    const Bytecode *bytecode;
+    double start;
+    double step;
+    size_t offset;   // Index of first row of batch
+    size_t num_rows; // Rows in batch
+    double *x_values;
+    double *results;
+    ListenerError *errors;
+    bool reduce;             // Fold is computed by a kernel, see arith_get_reduction
+    AggregateKind reduction;
+    double *partials;        // Reduction of each chunk of batch
+} RowChunks;
 
 int cmd_table_check(const char *input)
 {
@@ -34,15 +61,66 @@ bool check_if_constant(const char *offset, const char *string, const Node *node)
     return true;
 }
 
+static void evaluate_rows(void *state, size_t index)
+{
+    const RowChunks *chunks = state;
+    size_t first = index * ROWS_PER_TASK;
+    size_t count = chunks->num_rows - first < ROWS_PER_TASK ? chunks->num_rows - first : ROWS_PER_TASK;
+
+    // Values are computed from their index instead of being accumulated, so chunks are independent
+    for (size_t i = first; i < first + count; i++)
+    {
+        chunks->x_values[i] = chunks->start + (chunks->offset + i) * chunks->step;
+    }
+    // Expression contains at most one variable which has index 0
+    const double *x_column = chunks->x_values + first;
+    bytecode_run_batch(chunks->bytecode, arith_op_evaluate, &x_column, count,
+        chunks->results + first, chunks->errors + first);
+
+    if (chunks->reduce)
+    {
+        // Rows with errors are skipped by the fold, reduce runs of rows in between
+        AggregateStats stats;
+        agg_compute(NULL, 0, chunks->reduction, &stats);
+        double res = agg_get(&stats, chunks->reduction);
+        size_t run_start = first;
+        for (size_t i = first; i <= first + count; i++)
+        {
+            if (i == first + count || chunks->errors[i] != LISTENERERR_SUCCESS)
+            {
+                agg_compute(chunks->results + run_start, i - run_start, chunks->reduction, &stats);
+                res = agg_combine(chunks->reduction, res, agg_get(&stats, chunks->reduction));
+                run_start = i + 1;
+            }
+        }
+        chunks->partials[index] = res;
+    }
+}
+
 bool cmd_table_exec(char *input, __attribute__((unused)) int code)
 {
+    // Optionally: Split off path to export rows to instead of printing them
+    char *path = strchr(input + strlen(COMMAND), EXPORT_KEYWORD);
+    if (path != NULL)
+    {
+        *path = '\0';
+        path = strip(path + 1);
+    }
+
     char *args[6];
     size_t num_args = str_split(input + strlen(COMMAND), args, 5, ";", ";", ";", FOLD_KEYWORD, ";");
 
     if (num_args != 4 && num_args != 6)
     {
         report_error("Error: Invalid syntax. Syntax is:\n"
-               "table <expr> ; <from> ; <to> ; <step> [fold <expr> ; <init>]\n");
+               "table <expr> ; <from> ; <to> ; <step> [fold <expr> ; <init>] [> <path>]\n");
+        return false;
+    }
+
+    ExportFormat export_format = EXPORT_CSV;
+    if (path != NULL && !export_format_from_path(path, &export_format))
+    {
+        report_error_at(path - input, strlen(path), "Error: Unsupported format, use .csv, .tsv or .f64\n");
         return false;
     }
 
@@ -59,6 +137,7 @@ bool cmd_table_exec(char *input, __attribute__((unused)) int code)
     Node *fold_expr = NULL;
     Node *fold_init = NULL;
     char *expr_string = NULL;
+    char *expr_name = NULL;
 
     ParsingResult presult = { .error.type = PERR_NULL };
     if (!arith_parse_raw(args[0], (size_t)(args[0] - input), &presult))
@@ -72,6 +151,13 @@ bool cmd_table_exec(char *input, __attribute__((unused)) int code)
     tree_append_to_strbuilder(&builder, presult.tree, g_ctx, true);
     strbuilder_append(&builder, " ");
     expr_string = strbuilder_to_str(&builder);
+    if (path != NULL)
+    {
+        // Exported files are processed by other tools, don't color names of columns
+        Vector name_builder = strbuilder_create(STRBUILDER_STARTSIZE);
+        tree_append_to_strbuilder(&name_builder, presult.tree, g_ctx, false);
+        expr_name = strbuilder_to_str(&name_builder);
+    }
 
     expr = arith_simplify(&presult, args[0] - input);
     if (expr == NULL)
@@ -144,70 +230,193 @@ bool cmd_table_exec(char *input, __attribute__((unused)) int code)
     {
         step_val *= -1;
     }
+    double num_steps = floor((end_val - start_val) / step_val + RANGE_TOLERANCE);
+    if (!isfinite(num_steps))
+    {
+        report_error("Error: Infinite number of rows\n");
+        goto exit;
+    }
+    size_t num_rows = (size_t)num_steps + 1;
+
+    // Expressions are evaluated once per row, compile them
+    arith_optimize(&expr);
+    if (num_args == 6) arith_optimize(&fold_expr);
+    Bytecode compiled_expr;
+    Bytecode compiled_fold;
+    if (!bytecode_compile(expr, arith_op_info, &compiled_expr))
+    {
+        report_error_at(args[0] - input, strlen(args[0]), "Error: Too many distinct operators\n");
+        goto exit;
+    }
+    if (num_args == 6 && !bytecode_compile(fold_expr, arith_op_info, &compiled_fold))
+    {
+        bytecode_destroy(&compiled_expr);
+        report_error_at(args[4] - input, strlen(args[4]), "Error: Too many distinct operators\n");
+        goto exit;
+    }
+    ssize_t fold_x_index = num_args == 6 ? bytecode_lookup_variable(&compiled_fold, FOLD_VAR_1) : -1;
+    ssize_t fold_y_index = num_args == 6 ? bytecode_lookup_variable(&compiled_fold, FOLD_VAR_2) : -1;
 
-    Table *table = get_empty_table();
-    
-    // Print header row only if interactive
-    if (is_interactive())
+    // Rows are either exported to a file or printed while they are produced
+    TableExport *export = NULL;
+    TableStream *table = NULL;
+    if (path != NULL)
     {
-        add_empty_cell(table);
-        if (num_vars != 0)
+        export = open_table_export(path, export_format, 2);
+        if (export == NULL)
         {
-            add_cell_fmt(table, VAR_COLOR " %s " COL_RESET, var);
+            report_error("Error: Could not open '%s': %s\n", path, strerror(errno));
+            bytecode_destroy(&compiled_expr);
+            if (num_args == 6) bytecode_destroy(&compiled_fold);
+            goto exit;
         }
-        else
+        export_header(export, (const char*[]){ num_vars != 0 ? var : "", expr_name });
+    }
+
+    // Associative folds are reduced by all threads, others are evaluated sequentially, natively if possible
+    AggregateKind reduction = 0;
+    bool reduce = num_args == 6 && arith_get_reduction(fold_expr, FOLD_VAR_1, FOLD_VAR_2, &reduction);
+    JitCode native_fold;
+    bool use_native_fold = num_args == 6 && !reduce && jit_compile(&compiled_fold, arith_op_evaluate, &native_fold);
+
+    if (export == NULL)
+    {
+        // Index column is only printed if interactive
+        size_t x_col = is_interactive() ? 1 : 0;
+        table = get_table_stream(stdout, x_col + 2, TABLE_WINDOW);
+        stream_set_alignments(table, 3, (TableHAlign[]){ H_ALIGN_RIGHT, H_ALIGN_RIGHT, H_ALIGN_RIGHT });
+
+        // Widths of index and x-values are known in advance, x-values are monotonic so the widest is a bound
+        size_t widths[3] = { 0 };
+        widths[x_col] = snprintf(NULL, 0, " " DOUBLE_FMT " ", start_val);
+        size_t end_width = snprintf(NULL, 0, " " DOUBLE_FMT " ", start_val + (num_rows - 1) * step_val);
+        if (end_width > widths[x_col]) widths[x_col] = end_width;
+
+        if (is_interactive())
         {
-            // Expression is constant - don't print any variable
-            add_empty_cell(table);
+            widths[0] = snprintf(NULL, 0, " %zu ", num_rows);
+            char *var_cell = NULL;
+            if (num_vars != 0)
+            {
+                StringBuilder var_builder = strbuilder_create(STRBUILDER_STARTSIZE);
+                strbuilder_append(&var_builder, VAR_COLOR " %s " COL_RESET, var);
+                var_cell = strbuilder_to_str(&var_builder);
+            }
+            // When expression is constant, don't print any variable
+            stream_set_header(table, 3, (const char*[]){ "", var_cell != NULL ? var_cell : "", expr_string });
+            free(var_cell);
         }
-        add_cell(table, expr_string);
-        next_row(table);
+        stream_declare_widths(table, x_col + 1, widths);
     }
 
-    // Loop through all values and add them to table
-    for (size_t i = 1; step_val > 0 ? start_val <= end_val : start_val >= end_val; i++)
+    // Rows are evaluated in batches by all threads, batches are printed in order
+    size_t max_batch_size = ROWS_PER_TASK * pool_get_num_threads();
+    if (max_batch_size > num_rows) max_batch_size = num_rows;
+    double *x_values = malloc_wrapper(max_batch_size * sizeof(double));
+    double *results = malloc_wrapper(max_batch_size * sizeof(double));
+    ListenerError *errors = malloc_wrapper(max_batch_size * sizeof(ListenerError));
+    size_t max_tasks = (max_batch_size + ROWS_PER_TASK - 1) / ROWS_PER_TASK;
+    double *partials = reduce ? malloc_wrapper(max_tasks * sizeof(double)) : NULL;
+    RowChunks chunks = {
+        .bytecode  = &compiled_expr,
+        .start     = start_val,
+        .step      = step_val,
+        .x_values  = x_values,
+        .results   = results,
+        .errors    = errors,
+        .reduce    = reduce,
+        .reduction = reduction,
+        .partials  = partials
+    };
+
+    // First batch only fills the window so that the first rows are printed soon, later batches grow
+    size_t batch_size = TABLE_WINDOW < max_batch_size ? TABLE_WINDOW : max_batch_size;
+    for (size_t offset = 0; offset < num_rows; offset += chunks.num_rows)
     {
-        Node *current_expr = tree_copy(expr);
-        Node *current_val = malloc_constant_node(start_val, 0);
-        replace_variable_nodes(&current_expr, current_val, var);
-
-        double result = 0;
-        ListenerError err = tree_reduce(current_expr, arith_op_evaluate, &result, NULL);
+        chunks.offset = offset;
+        chunks.num_rows = num_rows - offset < batch_size ? num_rows - offset : batch_size;
+        size_t num_tasks = (chunks.num_rows + ROWS_PER_TASK - 1) / ROWS_PER_TASK;
+        pool_parallel_for(num_tasks, evaluate_rows, &chunks);
 
-        if (is_interactive()) add_cell_fmt(table, " %zu ", i);
-        add_cell_fmt(table, " " DOUBLE_FMT " ", start_val);
-
-        if (err == LISTENERERR_SUCCESS)
+        if (export != NULL)
         {
-            add_cell_fmt(table, " " DOUBLE_FMT " ", result);
-
-            if (num_args == 6)
+            for (size_t i = 0; i < chunks.num_rows; i++)
             {
-                Node *current_fold = tree_copy(fold_expr);
-                Node *current_fold_x = malloc_constant_node(fold_val, 0);
-                Node *current_fold_y = malloc_constant_node(result, 0);
-                replace_variable_nodes(&current_fold, current_fold_x, FOLD_VAR_1);
-                replace_variable_nodes(&current_fold, current_fold_y, FOLD_VAR_2);
-                fold_val = arith_evaluate(current_fold);
-                free_tree(current_fold);
-                free_tree(current_fold_x);
-                free_tree(current_fold_y);
+                if (errors[i] != LISTENERERR_SUCCESS) results[i] = NAN;
             }
+            export_rows(export, chunks.num_rows, (const double*[]){ x_values, results });
         }
         else
         {
-            add_cell_fmt(table, " Error ");
+            for (size_t i = 0; i < chunks.num_rows; i++)
+            {
+                if (is_interactive()) stream_add_cell_fmt(table, " %zu ", offset + i + 1);
+                stream_add_cell_fmt(table, " " DOUBLE_FMT " ", x_values[i]);
+                if (errors[i] == LISTENERERR_SUCCESS)
+                {
+                    stream_add_cell_fmt(table, " " DOUBLE_FMT " ", results[i]);
+                }
+                else
+                {
+                    stream_add_cell(table, " Error ");
+                }
+                stream_next_row(table);
+            }
         }
 
-        free_tree(current_expr);
-        free_tree(current_val);
-        next_row(table);
-        start_val += step_val;
+        if (reduce)
+        {
+            // Partial results are combined in order of rows
+            for (size_t i = 0; i < num_tasks; i++) fold_val = agg_combine(reduction, fold_val, partials[i]);
+        }
+        else if (num_args == 6)
+        {
+            for (size_t i = 0; i < chunks.num_rows; i++)
+            {
+                if (errors[i] != LISTENERERR_SUCCESS) continue;
+
+                double fold_args[2];
+                if (fold_x_index != -1) fold_args[fold_x_index] = fold_val;
+                if (fold_y_index != -1) fold_args[fold_y_index] = results[i];
+                // Like arith_evaluate, fold value is 0 on error
+                fold_val = 0;
+                if (use_native_fold)
+                {
+                    jit_run(&native_fold, fold_args, &fold_val, NULL);
+                }
+                else
+                {
+                    bytecode_run(&compiled_fold, arith_op_evaluate, fold_args, &fold_val, NULL);
+                }
+            }
+        }
+        batch_size = 2 * batch_size < max_batch_size ? 2 * batch_size : max_batch_size;
     }
+    free(x_values);
+    free(results);
+    free(errors);
+    free(partials);
 
-    set_default_alignments(table, 3, (TableHAlign[]){ H_ALIGN_RIGHT, H_ALIGN_RIGHT, H_ALIGN_RIGHT }, NULL);
-    print_table(table);
-    free_table(table);
+    bool exported = true;
+    if (export != NULL)
+    {
+        exported = close_table_export(export);
+        if (exported)
+        {
+            whisper("Exported %zu rows to %s\n", num_rows, path);
+        }
+        else
+        {
+            report_error("Error: Could not write '%s'\n", path);
+        }
+    }
+    else
+    {
+        free_table_stream(table);
+    }
+    bytecode_destroy(&compiled_expr);
+    if (num_args == 6) bytecode_destroy(&compiled_fold);
+    if (use_native_fold) jit_destroy(&native_fold);
 
     if (num_args == 6) // Contains fold expression
     {
@@ -215,10 +424,11 @@ bool cmd_table_exec(char *input, __attribute__((unused)) int code)
         history_add(fold_val);
     }
 
-    success = true;
+    success = exported;
     exit:
     free_tree(expr);
     free(expr_string);
+    free(expr_name);
     free_tree(start);
     free_tree(end);
     free_tree(step);
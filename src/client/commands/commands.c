@@ -3,6 +3,8 @@
 
 #include "../../util/string_util.h"
 #include "../../util/console_util.h"
+#include "../../util/thread_pool.h"
+#include "../../engine/tree/node.h"
 #include "../core/arith_context.h"
 #include "../core/history.h"
 #include "../simplification/simplification.h"
@@ -60,6 +62,8 @@ void unload_commands()
     unload_history();
     unload_arith_ctx();
     unload_propositional_ctx();
+    node_trim_free_lists();
+    pool_shutdown();
 }
 
 /*
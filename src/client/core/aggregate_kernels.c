@@ -0,0 +1,280 @@
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+#include "../../util/alloc_wrappers.h"
+#include "aggregate_kernels.h"
+
+#define NUM_LANES           4   // Independent accumulators per loop
+#define LOCAL_SELECT_SIZE   64  // Median of up to this many values does not allocate
+#define VARIANCE_BLOCK_SIZE 256 // Values per block of variance, fits in L1 cache
+
+double agg_sum(const double *values, size_t num_values)
+{
+    double lanes[NUM_LANES] = { 0 };
+    size_t i = 0;
+    for (; i + NUM_LANES <= num_values; i += NUM_LANES)
+    {
+        for (size_t j = 0; j < NUM_LANES; j++) lanes[j] += values[i + j];
+    }
+    for (; i < num_values; i++) lanes[0] += values[i];
+    return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+}
+
+double agg_prod(const double *values, size_t num_values)
+{
+    double lanes[NUM_LANES] = { 1, 1, 1, 1 };
+    size_t i = 0;
+    for (; i + NUM_LANES <= num_values; i += NUM_LANES)
+    {
+        for (size_t j = 0; j < NUM_LANES; j++) lanes[j] *= values[i + j];
+    }
+    for (; i < num_values; i++) lanes[0] *= values[i];
+    return (lanes[0] * lanes[1]) * (lanes[2] * lanes[3]);
+}
+
+double agg_min(const double *values, size_t num_values)
+{
+    double lanes[NUM_LANES] = { INFINITY, INFINITY, INFINITY, INFINITY };
+    size_t i = 0;
+    for (; i + NUM_LANES <= num_values; i += NUM_LANES)
+    {
+        for (size_t j = 0; j < NUM_LANES; j++) lanes[j] = values[i + j] < lanes[j] ? values[i + j] : lanes[j];
+    }
+    for (; i < num_values; i++) lanes[0] = values[i] < lanes[0] ? values[i] : lanes[0];
+    double res = lanes[0];
+    for (size_t j = 1; j < NUM_LANES; j++) res = lanes[j] < res ? lanes[j] : res;
+    return res;
+}
+
+double agg_max(const double *values, size_t num_values)
+{
+    double lanes[NUM_LANES] = { -INFINITY, -INFINITY, -INFINITY, -INFINITY };
+    size_t i = 0;
+    for (; i + NUM_LANES <= num_values; i += NUM_LANES)
+    {
+        for (size_t j = 0; j < NUM_LANES; j++) lanes[j] = values[i + j] > lanes[j] ? values[i + j] : lanes[j];
+    }
+    for (; i < num_values; i++) lanes[0] = values[i] > lanes[0] ? values[i] : lanes[0];
+    double res = lanes[0];
+    for (size_t j = 1; j < NUM_LANES; j++) res = lanes[j] > res ? lanes[j] : res;
+    return res;
+}
+
+// Running state of Welford's algorithm, updated by whole blocks instead of single values
+typedef struct {
+    double count;
+    double mean;
+    double m2; // Sum of squared differences from mean
+} Welford;
+
+// Combines two states (Chan et al.)
+static Welford welford_merge(Welford a, Welford b)
+{
+    double count = a.count + b.count;
+    if (count == 0) return a;
+    double delta = b.mean - a.mean;
+    return (Welford){
+        .count = count,
+        .mean  = a.mean + delta * b.count / count,
+        .m2    = a.m2 + b.m2 + delta * delta * a.count * b.count / count
+    };
+}
+
+/*
+Summary: Computes statistics of values in a single pass over them.
+    Variance is computed blockwise: Each block is small enough to stay in cache for an exact two-pass
+    computation of its mean and squared differences, blocks are then merged into the running state.
+    This is as stable as Welford's algorithm without a division per value.
+Params
+    kinds: Bitwise or of AggregateKinds to compute, other fields of out_stats are not written
+*/
+void agg_compute(const double *values, size_t num_values, int kinds, AggregateStats *out_stats)
+{
+    if (kinds & AGG_VARIANCE)
+    {
+        Welford all = { 0, 0, 0 };
+        double sums[NUM_LANES] = { 0 };
+        double prods[NUM_LANES] = { 1, 1, 1, 1 };
+        double mins[NUM_LANES] = { INFINITY, INFINITY, INFINITY, INFINITY };
+        double maxs[NUM_LANES] = { -INFINITY, -INFINITY, -INFINITY, -INFINITY };
+        for (size_t start = 0; start < num_values; start += VARIANCE_BLOCK_SIZE)
+        {
+            size_t size = num_values - start < VARIANCE_BLOCK_SIZE ? num_values - start : VARIANCE_BLOCK_SIZE;
+            const double *block = values + start;
+
+            // First pass collects other single-pass statistics
+            double block_sums[NUM_LANES] = { 0 };
+            size_t i = 0;
+            for (; i + NUM_LANES <= size; i += NUM_LANES)
+            {
+                for (size_t j = 0; j < NUM_LANES; j++)
+                {
+                    double value = block[i + j];
+                    block_sums[j] += value;
+                    prods[j] *= value;
+                    mins[j] = value < mins[j] ? value : mins[j];
+                    maxs[j] = value > maxs[j] ? value : maxs[j];
+                }
+            }
+            for (; i < size; i++)
+            {
+                block_sums[0] += block[i];
+                prods[0] *= block[i];
+                mins[0] = block[i] < mins[0] ? block[i] : mins[0];
+                maxs[0] = block[i] > maxs[0] ? block[i] : maxs[0];
+            }
+            double block_sum = (block_sums[0] + block_sums[1]) + (block_sums[2] + block_sums[3]);
+            for (size_t j = 0; j < NUM_LANES; j++) sums[j] += block_sums[j];
+
+            // Second pass over cached block
+            double mean = block_sum / size;
+            double m2s[NUM_LANES] = { 0 };
+            for (i = 0; i + NUM_LANES <= size; i += NUM_LANES)
+            {
+                for (size_t j = 0; j < NUM_LANES; j++) m2s[j] += (block[i + j] - mean) * (block[i + j] - mean);
+            }
+            for (; i < size; i++) m2s[0] += (block[i] - mean) * (block[i] - mean);
+
+            all = welford_merge(all, (Welford){
+                .count = size,
+                .mean  = mean,
+                .m2    = (m2s[0] + m2s[1]) + (m2s[2] + m2s[3])
+            });
+        }
+
+        out_stats->variance = num_values == 0 ? NAN : all.m2 / num_values;
+        out_stats->sum = (sums[0] + sums[1]) + (sums[2] + sums[3]);
+        out_stats->prod = (prods[0] * prods[1]) * (prods[2] * prods[3]);
+        out_stats->min = mins[0];
+        out_stats->max = maxs[0];
+        for (size_t j = 1; j < NUM_LANES; j++)
+        {
+            out_stats->min = mins[j] < out_stats->min ? mins[j] : out_stats->min;
+            out_stats->max = maxs[j] > out_stats->max ? maxs[j] : out_stats->max;
+        }
+    }
+    else
+    {
+        if (kinds & (AGG_SUM | AGG_MEAN)) out_stats->sum = agg_sum(values, num_values);
+        if (kinds & AGG_PROD) out_stats->prod = agg_prod(values, num_values);
+        if (kinds & AGG_MIN) out_stats->min = agg_min(values, num_values);
+        if (kinds & AGG_MAX) out_stats->max = agg_max(values, num_values);
+    }
+
+    if (kinds & AGG_MEAN) out_stats->mean = num_values == 0 ? 0 : out_stats->sum / num_values;
+    if (kinds & AGG_MEDIAN) out_stats->median = agg_median(values, num_values);
+}
+
+double agg_variance(const double *values, size_t num_values)
+{
+    AggregateStats stats;
+    agg_compute(values, num_values, AGG_VARIANCE, &stats);
+    return stats.variance;
+}
+
+double agg_get(const AggregateStats *stats, AggregateKind kind)
+{
+    switch (kind)
+    {
+        case AGG_SUM:      return stats->sum;
+        case AGG_PROD:     return stats->prod;
+        case AGG_MIN:      return stats->min;
+        case AGG_MAX:      return stats->max;
+        case AGG_MEAN:     return stats->mean;
+        case AGG_VARIANCE: return stats->variance;
+        case AGG_MEDIAN:   return stats->median;
+    }
+    return NAN;
+}
+
+/*
+Summary: Combines results of sum, prod, min or max of two lists to the result of their concatenation
+*/
+double agg_combine(AggregateKind kind, double a, double b)
+{
+    switch (kind)
+    {
+        case AGG_SUM:  return a + b;
+        case AGG_PROD: return a * b;
+        // Like the kernels, NaN is ignored
+        case AGG_MIN:  return b < a || isnan(a) ? b : a;
+        case AGG_MAX:  return b > a || isnan(a) ? b : a;
+        default:       return NAN;
+    }
+}
+
+static void swap(double *values, size_t a, size_t b)
+{
+    double temp = values[a];
+    values[a] = values[b];
+    values[b] = temp;
+}
+
+/*
+Summary: Quickselect with median-of-three pivot, reorders values such that values[k] is at its sorted position,
+    smaller values before it and greater ones after it. Expected linear time. Values must not be NaN.
+*/
+static void select_kth(double *values, size_t num_values, size_t k)
+{
+    size_t left = 0;
+    size_t right = num_values - 1;
+    while (left < right)
+    {
+        // Sort left, mid and right to use median as pivot, which is moved to right - 1
+        size_t mid = left + (right - left) / 2;
+        if (values[mid] < values[left]) swap(values, mid, left);
+        if (values[right] < values[left]) swap(values, right, left);
+        if (values[right] < values[mid]) swap(values, right, mid);
+        if (right - left < 3) return;
+        swap(values, mid, right - 1);
+        double pivot = values[right - 1];
+
+        // Hoare partition of inner range, sentinels at left and right
+        size_t i = left;
+        size_t j = right - 1;
+        while (true)
+        {
+            while (values[++i] < pivot);
+            while (values[--j] > pivot);
+            if (i >= j) break;
+            swap(values, i, j);
+        }
+        swap(values, i, right - 1);
+
+        if (k == i) return;
+        if (k < i) right = i - 1;
+        else left = i + 1;
+    }
+}
+
+/*
+Summary: Median by selection instead of sorting, values are not changed
+*/
+double agg_median(const double *values, size_t num_values)
+{
+    if (num_values == 0) return NAN;
+    for (size_t i = 0; i < num_values; i++)
+    {
+        if (isnan(values[i])) return NAN;
+    }
+
+    double local_buffer[LOCAL_SELECT_SIZE];
+    double *buffer = num_values <= LOCAL_SELECT_SIZE
+        ? local_buffer
+        : malloc_wrapper(num_values * sizeof(double));
+    memcpy(buffer, values, num_values * sizeof(double));
+
+    size_t k = num_values / 2;
+    select_kth(buffer, num_values, k);
+    double res = buffer[k];
+    if (num_values % 2 == 0)
+    {
+        // Lower middle value is greatest value before k
+        double lower = buffer[0];
+        for (size_t i = 1; i < k; i++) lower = buffer[i] > lower ? buffer[i] : lower;
+        res = 0.5 * (res + lower);
+    }
+
+    if (buffer != local_buffer) free(buffer);
+    return res;
+}
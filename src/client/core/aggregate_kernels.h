@@ -0,0 +1,42 @@
+#pragma once
+#include <stddef.h>
+
+/*
+Statistics of dynamic-arity functions of the arithmetic context, meant for long argument lists.
+Loops keep several independent accumulators so that the compiler can vectorize them and
+additions do not wait for each other. min and max ignore NaN, like a scalar comparison would.
+Several statistics of the same values can be computed in a single pass by agg_compute.
+*/
+
+typedef enum {
+    AGG_SUM      = 1 << 0,
+    AGG_PROD     = 1 << 1,
+    AGG_MIN      = 1 << 2,
+    AGG_MAX      = 1 << 3,
+    AGG_MEAN     = 1 << 4, // 0 for empty list
+    AGG_VARIANCE = 1 << 5, // Population variance, NaN for empty list
+    AGG_MEDIAN   = 1 << 6  // NaN for empty list or if any value is NaN
+} AggregateKind;
+
+// Statistics computed by the fused single pass
+#define AGG_SINGLE_PASS (AGG_SUM | AGG_PROD | AGG_MIN | AGG_MAX | AGG_MEAN | AGG_VARIANCE)
+
+typedef struct {
+    double sum;
+    double prod;
+    double min;
+    double max;
+    double mean;
+    double variance;
+    double median;
+} AggregateStats;
+
+double agg_sum(const double *values, size_t num_values);
+double agg_prod(const double *values, size_t num_values);
+double agg_min(const double *values, size_t num_values);
+double agg_max(const double *values, size_t num_values);
+double agg_variance(const double *values, size_t num_values);
+double agg_median(const double *values, size_t num_values);
+void agg_compute(const double *values, size_t num_values, int kinds, AggregateStats *out_stats);
+double agg_get(const AggregateStats *stats, AggregateKind kind);
+double agg_combine(AggregateKind kind, double a, double b);
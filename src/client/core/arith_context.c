@@ -11,9 +11,14 @@
 #include "arith_evaluation.h"
 #include "history.h"
 
+#define NODE_ARENA_BLOCKSIZE 65536
+
 ParsingContext __g_ctx;
 LinkedList __g_composite_functions;
 
+// Holds all intermediate nodes created while parsing and simplifying a single input
+static Arena node_arena;
+
 /*
 Summary: Sets arithmetic context stored in global variable
 */
@@ -22,6 +27,7 @@ void init_arith_ctx()
     srand(time(NULL));
     __g_ctx = get_arith_ctx();
     __g_composite_functions = list_create(sizeof(RewriteRule));
+    node_arena = arena_create(NODE_ARENA_BLOCKSIZE);
 }
 
 ParsingContext get_arith_ctx()
@@ -90,6 +96,7 @@ ParsingContext get_arith_ctx()
     {
         software_defect("[Arith] Inconsistent operator set.\n");
     }
+    ctx_set_traits(&res, arith_get_traits);
     // Set multiplication as glue-op
     ctx_set_glue_op(&res, ctx_lookup_op(&res, "*", OP_PLACE_INFIX));
     return res;
@@ -100,6 +107,8 @@ void unload_arith_ctx()
     clear_composite_functions();
     list_destroy(g_composite_functions);
     ctx_destroy(g_ctx);
+    arena_destroy(&node_arena);
+    unload_arith_evaluation();
 }
 
 void add_composite_function(RewriteRule rule)
@@ -261,16 +270,40 @@ static void report_parser_error(const Vector *tokens, ParserError error, size_t
     }
 }
 
+/*
+Summary: Directs subsequent node allocations into the node arena
+Returns: False if the arena is already in use by a caller, who is then responsible for leaving it
+*/
+static bool enter_node_arena()
+{
+    if (node_get_arena() != NULL) return false;
+    node_set_arena(&node_arena);
+    return true;
+}
+
+/*
+Summary: Promotes result to the heap and releases all other nodes allocated in the arena at once
+*/
+static Node *leave_node_arena(const Node *result)
+{
+    node_set_arena(NULL);
+    Node *res = tree_copy(result);
+    arena_reset(&node_arena);
+    return res;
+}
+
 bool arith_parse(char *input, size_t prompt_len, Node **out_res)
 {
-    ParsingResult res;
-    if (arith_parse_raw(input, prompt_len, &res))
+    bool own_arena = enter_node_arena();
+    Node *res = NULL;
+    ParsingResult p_result;
+    if (arith_parse_raw(input, prompt_len, &p_result))
     {
-        *out_res = arith_simplify(&res, prompt_len);
-        if (*out_res == NULL) return false;
-        return true;
+        res = arith_simplify(&p_result, prompt_len);
     }
-    return false;
+    if (own_arena) res = leave_node_arena(res);
+    *out_res = res;
+    return res != NULL;
 }
 
 /*
@@ -296,20 +329,31 @@ Summary: Replaces user-defined functions and simplifies
 */
 Node *arith_simplify(ParsingResult *p_result, size_t prompt_len)
 {
+    bool own_arena = enter_node_arena();
+    if (own_arena)
+    {
+        // Tree has been parsed onto the heap, move it into arena to not mix allocations
+        Node *arena_copy = tree_copy(p_result->tree);
+        free_tree(p_result->tree);
+        p_result->tree = arena_copy;
+    }
+
     LinkedListIterator iterator = list_get_iterator(g_composite_functions);
     apply_ruleset_by_iterator(&p_result->tree, (Iterator*)&iterator, NULL, SIZE_MAX);
     const Node *errnode = NULL;
+    Node *res = NULL;
     ListenerError l_err = simplify(&p_result->tree, &errnode);
     if (l_err != LISTENERERR_SUCCESS)
     {
         report_listener_error(&p_result->tokens, get_token_index(errnode), l_err, prompt_len);
         free_result(p_result, true);
-        return NULL;
     }
     else
     {
-        Node *res = p_result->tree;
+        res = p_result->tree;
         free_result(p_result, false);
-        return res;
     }
+
+    if (own_arena) res = leave_node_arena(res);
+    return res;
 }
@@ -1,409 +1,351 @@
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include <time.h>
 #include <float.h>
 #include <math.h>
 
 #include "../../engine/tree/tree_util.h"
+#include "../../engine/evaluation/vecmath.h"
+#include "../../util/alloc_wrappers.h"
 #include "../../util/console_util.h"
 #include "history.h"
+#include "integer_kernels.h"
+#include "aggregate_kernels.h"
 #include "arith_evaluation.h"
 #include "arith_context.h"
 
-static double variance(const double *args, size_t num_args)
+// Computes statistic of argument list
+static double aggregate(AggregateKind kind, const double *args, size_t num_args)
 {
-    double u = 0;
-    for (size_t i = 0; i < num_args; i++)
-    {
-        u += args[i];
-    }
-    u /= num_args;
+    AggregateStats stats;
+    agg_compute(args, num_args, kind, &stats);
+    return agg_get(&stats, kind);
+}
 
-    double res = 0;
-    for (size_t i = 0; i < num_args; i++)
+/*
+Summary: Shared function of aggregates for bytecode, bits of selection are AggregateKinds.
+    Statistics of the same argument list (e.g. avg and var) are computed together by agg_compute.
+*/
+static void aggregate_shared(const double *args, size_t num_args, uint32_t selection, double *out_results)
+{
+    AggregateStats stats;
+    agg_compute(args, num_args, selection, &stats);
+    for (uint32_t kinds = selection; kinds != 0; kinds &= kinds - 1)
     {
-        res += pow(args[i] - u, 2);
+        *out_results++ = agg_get(&stats, kinds & -kinds);
     }
+}
 
-    return res / num_args;
+/*
+Returns: Random natural number between min and max - 1 (i.e. max is exclusive)
+*/
+static double random_between(double min, double max)
+{
+    min = trunc(min);
+    max = trunc(max);
+    long diff = (long)(max - min);
+    if (diff < 1) return -1;
+    return rand() % diff + min;
 }
 
-static double euclid(double a, double b)
+static void sin_cos(double x, double *out_sin, double *out_cos)
 {
-    a = fabs(trunc(a));
-    b = fabs(trunc(b));
+    *out_sin = sin(x);
+    *out_cos = cos(x);
+}
 
-    if (a == 0)
-    {
-        return b;
-    }
-    else
-    {
-        while (b != 0)
-        {
-            if (a > b)
-            {
-                a = a - b;
-            }
-            else
-            {
-                b = b - a;
-            }
-        }
-        return a;
-    }
+static void cos_sin(double x, double *out_cos, double *out_sin)
+{
+    *out_cos = cos(x);
+    *out_sin = sin(x);
 }
 
-static double binomial(double n, double k)
+static double percent(double x)
 {
-    n = fabs(trunc(n));
-    k = fabs(trunc(k));
-
-    if (k == 0) return 1;
-    if ((2 * k) > n) k = n - k;
-    
-    double res = 1;
-    for (double i = 1; i <= k; i++)
-    {
-        res = (res * (n - k + i)) / i;
-    }
-    
-    return res;
+    return x / 100;
 }
 
-static long fib(long n)
+static double frac(double x)
 {
-    if (n == 0) return 0;
-    if (n == 1) return 1;
-    if (n == -1) return 1;
-    return fib(n - 1) + fib(n - 2); 
+    return x - floor(x);
 }
 
-static double fibonacci(double n)
+static double sgn(double x)
 {
-    long l = (long)n;
-    if (l < 0) // Generalization to negative numbers
-    {
-        if (l % 2 == 0)
-        {
-            return -fib(labs(l));
-        }
-        else
-        {
-            return fib(labs(l));
-        }
-    }
-    else
-    {
-        return fib(l);
-    }
+    return x < 0 ? -1 : (x > 0) ? 1 : 0;
+}
+
+// Signature of OpTraits.evaluate, not every evaluator needs every parameter
+#define EVALUATOR(name) static ListenerError name(\
+    __attribute__((unused)) const Operator *op,\
+    __attribute__((unused)) size_t num_args,\
+    __attribute__((unused)) const double *args,\
+    __attribute__((unused)) double *out)
+
+// Constants and operators that never fail
+#define SIMPLE_EVALUATOR(name, expr) EVALUATOR(name)\
+{\
+    *out = (expr);\
+    return LISTENERERR_SUCCESS;\
+}
+
+SIMPLE_EVALUATOR(eval_identity,  args[0])
+SIMPLE_EVALUATOR(eval_unary,     op->traits->unary(args[0]))
+SIMPLE_EVALUATOR(eval_add,       args[0] + args[1])
+SIMPLE_EVALUATOR(eval_sub,       args[0] - args[1])
+SIMPLE_EVALUATOR(eval_mul,       args[0] * args[1])
+SIMPLE_EVALUATOR(eval_binomial,  int_binomial(args[0], args[1]))
+SIMPLE_EVALUATOR(eval_mod,       fmod(args[0], args[1]))
+SIMPLE_EVALUATOR(eval_neg,       -args[0])
+SIMPLE_EVALUATOR(eval_factorial, int_factorial(args[0]))
+SIMPLE_EVALUATOR(eval_log,       log(args[0]) / log(args[1]))
+SIMPLE_EVALUATOR(eval_max,       aggregate(AGG_MAX, args, num_args))
+SIMPLE_EVALUATOR(eval_min,       aggregate(AGG_MIN, args, num_args))
+SIMPLE_EVALUATOR(eval_sum,       aggregate(AGG_SUM, args, num_args))
+SIMPLE_EVALUATOR(eval_prod,      aggregate(AGG_PROD, args, num_args))
+SIMPLE_EVALUATOR(eval_avg,       aggregate(AGG_MEAN, args, num_args))
+SIMPLE_EVALUATOR(eval_var,       aggregate(AGG_VARIANCE, args, num_args))
+SIMPLE_EVALUATOR(eval_gcd,       int_gcd(args[0], args[1]))
+SIMPLE_EVALUATOR(eval_lcm,       int_lcm(args[0], args[1]))
+SIMPLE_EVALUATOR(eval_rand,      random_between(args[0], args[1]))
+SIMPLE_EVALUATOR(eval_fib,       int_fib(args[0]))
+SIMPLE_EVALUATOR(eval_gamma,     tgamma(args[0]))
+SIMPLE_EVALUATOR(eval_pi,        3.14159265359)
+SIMPLE_EVALUATOR(eval_e,         2.71828182846)
+SIMPLE_EVALUATOR(eval_phi,       1.61803398874)
+SIMPLE_EVALUATOR(eval_clight,    299792458) // m/s
+SIMPLE_EVALUATOR(eval_csound,    343.2)     // m/s
+
+EVALUATOR(eval_history)
+{
+    return history_get((int)args[0], out) ? LISTENERERR_SUCCESS : LISTENERERR_HISTORY_NOT_SET;
+}
+
+EVALUATOR(eval_ans)
+{
+    return history_get(0, out) ? LISTENERERR_SUCCESS : LISTENERERR_HISTORY_NOT_SET;
+}
+
+EVALUATOR(eval_deriv)
+{
+    return LISTENERERR_IMPOSSIBLE_DERIV;
+}
+
+EVALUATOR(eval_div)
+{
+    if (args[1] == 0) return LISTENERERR_DIVISION_BY_ZERO;
+    *out = args[0] / args[1];
+    return LISTENERERR_SUCCESS;
+}
+
+EVALUATOR(eval_pow)
+{
+    if (args[0] == 0 && args[1] <= 0) return LISTENERERR_DIVISION_BY_ZERO;
+    if (args[0] < 0 && args[1] < 1) return LISTENERERR_COMPLEX_SOLUTION;
+    *out = pow(args[0], args[1]);
+    return LISTENERERR_SUCCESS;
+}
+
+EVALUATOR(eval_root)
+{
+    if (args[0] < 0) return LISTENERERR_COMPLEX_SOLUTION;
+    *out = pow(args[0], 1 / args[1]);
+    return LISTENERERR_SUCCESS;
+}
+
+EVALUATOR(eval_sqrt)
+{
+    if (args[0] < 0) return LISTENERERR_COMPLEX_SOLUTION;
+    *out = sqrt(args[0]);
+    return LISTENERERR_SUCCESS;
 }
 
+EVALUATOR(eval_median)
+{
+    if (num_args == 0) return LISTENERERR_EMPTY_PARAMS;
+    *out = aggregate(AGG_MEDIAN, args, num_args);
+    return LISTENERERR_SUCCESS;
+}
+
+#define UNARY(fn)            { .evaluate = eval_unary, .unary = fn }
+#define VECTORIZED(fn, vec)  { .evaluate = eval_unary, .unary = fn, .batch = vec }
+#define FUSED(fn, vec, co, fused_fn, fused_vec) \
+    { .evaluate = eval_unary, .unary = fn, .batch = vec, .cofunction = co, .fused = fused_fn, .fused_batch = fused_vec }
+#define SHARED(kind)         .shared = aggregate_shared, .shared_bit = kind
+#define GROUP                (OP_TRAIT_COMMUTATIVE | OP_TRAIT_ASSOCIATIVE)
+#define ADDITIVE(fn, bytecode)       { .evaluate = fn, .flags = GROUP | OP_TRAIT_IDENTITY, .identity = 0, .reduction = AGG_SUM, bytecode }
+#define MULTIPLICATIVE(fn, bytecode) { .evaluate = fn, .flags = GROUP | OP_TRAIT_IDENTITY | OP_TRAIT_ABSORBING, .identity = 1, .absorbing = 0, \
+    .reduction = AGG_PROD, bytecode }
+
+// Indexed by id of operator in g_ctx, i.e. in order of get_arith_ctx
+static const OpTraits arith_traits[NUM_ARITH_OPS] = {
+    { .evaluate = eval_identity, .kind = OPKIND_IDENTITY },                                 // $x
+    { .evaluate = eval_history, .flags = OP_TRAIT_IMPURE },                                 // @x
+    { .evaluate = eval_deriv },                                                             // x'
+    { .evaluate = eval_deriv },                                                             // deriv(x, y)
+    ADDITIVE(eval_add, .kind = OPKIND_ADD),                                                 // x+y
+    { .evaluate = eval_sub, .flags = OP_TRAIT_IDENTITY, .identity = 0, .kind = OPKIND_SUB }, // x-y
+    MULTIPLICATIVE(eval_mul, .kind = OPKIND_MUL),                                           // x*y
+    { .evaluate = eval_div, .flags = OP_TRAIT_IDENTITY, .identity = 1, .kind = OPKIND_DIV }, // x/y
+    { .evaluate = eval_pow, .flags = OP_TRAIT_IDENTITY, .identity = 1 },                    // x^y
+    { .evaluate = eval_binomial },                                                          // x C y
+    { .evaluate = eval_mod },                                                               // x mod y
+    { .evaluate = eval_identity, .kind = OPKIND_IDENTITY },                                 // +x
+    { .evaluate = eval_neg, .kind = OPKIND_NEG },                                           // -x
+    { .evaluate = eval_factorial },                                                         // x!
+    UNARY(percent),                                                                         // x%
+    VECTORIZED(exp, vecmath_exp),                                                           // exp(x)
+    { .evaluate = eval_root },                                                              // root(x, n)
+    { .evaluate = eval_sqrt },                                                              // sqrt(x)
+    { .evaluate = eval_log },                                                               // log(x, n)
+    VECTORIZED(log, vecmath_log),                                                           // ln(x)
+    UNARY(log2),                                                                            // ld(x)
+    UNARY(log10),                                                                           // lg(x)
+    FUSED(sin, vecmath_sin, "cos", sin_cos, vecmath_sincos),                                // sin(x)
+    FUSED(cos, vecmath_cos, "sin", cos_sin, vecmath_cossin),                                // cos(x)
+    UNARY(tan),                                                                             // tan(x)
+    UNARY(asin),                                                                            // asin(x)
+    UNARY(acos),                                                                            // acos(x)
+    UNARY(atan),                                                                            // atan(x)
+    UNARY(sinh),                                                                            // sinh(x)
+    UNARY(cosh),                                                                            // cosh(x)
+    UNARY(tanh),                                                                            // tanh(x)
+    UNARY(asinh),                                                                           // asinh(x)
+    UNARY(acosh),                                                                           // acosh(x)
+    UNARY(atanh),                                                                           // atanh(x)
+    { .evaluate = eval_max, .flags = GROUP, .reduction = AGG_MAX, SHARED(AGG_MAX) },        // max(x, y, ...)
+    { .evaluate = eval_min, .flags = GROUP, .reduction = AGG_MIN, SHARED(AGG_MIN) },        // min(x, y, ...)
+    UNARY(fabs),                                                                            // abs(x)
+    UNARY(ceil),                                                                            // ceil(x)
+    UNARY(floor),                                                                           // floor(x)
+    UNARY(round),                                                                           // round(x)
+    UNARY(trunc),                                                                           // trunc(x)
+    UNARY(frac),                                                                            // frac(x)
+    UNARY(sgn),                                                                             // sgn(x)
+    ADDITIVE(eval_sum, SHARED(AGG_SUM)),                                                    // sum(x, y, ...)
+    MULTIPLICATIVE(eval_prod, SHARED(AGG_PROD)),                                            // prod(x, y, ...)
+    { .evaluate = eval_avg, .flags = OP_TRAIT_COMMUTATIVE, SHARED(AGG_MEAN) },              // avg(x, y, ...)
+    { .evaluate = eval_median, .flags = OP_TRAIT_COMMUTATIVE },                             // median(x, y, ...)
+    { .evaluate = eval_gcd, .flags = GROUP },                                               // gcd(x, y)
+    { .evaluate = eval_lcm, .flags = GROUP },                                               // lcm(x, y)
+    { .evaluate = eval_rand, .flags = OP_TRAIT_IMPURE },                                    // rand(x, y)
+    { .evaluate = eval_fib },                                                               // fib(x)
+    { .evaluate = eval_gamma },                                                             // gamma(x)
+    { .evaluate = eval_var, .flags = OP_TRAIT_COMMUTATIVE, SHARED(AGG_VARIANCE) },          // var(x, y, ...)
+    { .evaluate = eval_pi },                                                                // pi
+    { .evaluate = eval_e },                                                                 // e
+    { .evaluate = eval_phi },                                                               // phi
+    { .evaluate = eval_clight },                                                            // clight
+    { .evaluate = eval_csound },                                                            // csound
+    { .evaluate = eval_ans, .flags = OP_TRAIT_IMPURE }                                      // ans
+};
+
+// Cofunctions named by traits of operators of g_ctx, looked up on first use
+static const Operator *cofunctions[NUM_ARITH_OPS];
+
 /*
-Returns: Random natural number between min and max - 1 (i.e. max is exclusive)
+Summary: Forgets operators of context
 */
-static double random_between(double min, double max)
+void unload_arith_evaluation()
 {
-    min = trunc(min);
-    max = trunc(max);
-    long diff = (long)(max - min);
-    if (diff < 1) return -1;
-    return rand() % diff + min;
+    for (size_t i = 0; i < NUM_ARITH_OPS; i++) cofunctions[i] = NULL;
 }
 
-static int asc_double_cmp(const void *a, const void *b)
+// Operators of the arithmetic context are those with its traits, user-defined functions have none
+static bool is_arith_op(const Operator *op)
 {
-    return *(double*)a - *(double*)b;
+    return op->id < NUM_ARITH_OPS && op->traits == &arith_traits[op->id];
 }
 
-static double median(size_t num_args, const double *args)
+/*
+Returns: Traits of built-in operator of arithmetic context (to be passed to ctx_set_traits)
+*/
+const OpTraits *arith_get_traits(const Operator *op)
 {
-    if (num_args == 0) return NAN;
-    qsort((void*)args, num_args, sizeof(double), asc_double_cmp);
-    if (num_args % 2 == 1)
-    {
-        return args[num_args / 2];
-    }
-    else
-    {
-        return 0.5 * (args[num_args / 2] + args[num_args / 2 - 1]);
-    }
+    return op->id < NUM_ARITH_OPS ? &arith_traits[op->id] : NULL;
 }
 
+/*
+Summary: Evaluates operator by its traits.
+    Results are not cached: For C, !, fib and gamma (see integer_kernels.h), a cache of results
+    shared by all threads was measured to cost more than it saved.
+*/
 ListenerError arith_op_evaluate(const Operator *op, size_t num_args, const double *args, double *out)
 {
-    switch (op->id)
+    if (op->traits == NULL || op->traits->evaluate == NULL) return LISTENERERR_UNKNOWN_OP;
+    return op->traits->evaluate(op, num_args, args, out);
+}
+
+/*
+Summary: Classifies operators of arithmetic context for bytecode compilation.
+    Must be consistent with arith_op_evaluate: Only operators that never fail are inlined.
+*/
+OpInfo arith_op_info(const Operator *op)
+{
+    if (!is_arith_op(op)) return (OpInfo){ .kind = OPKIND_CALL };
+    const OpTraits *traits = op->traits;
+    OpInfo res = {
+        .kind        = traits->unary != NULL ? OPKIND_UNARY : (OpKind)traits->kind,
+        .unary       = traits->unary,
+        .batch       = traits->batch,
+        .fused       = traits->fused,
+        .fused_batch = traits->fused_batch,
+        .shared      = traits->shared,
+        .shared_bit  = traits->shared_bit,
+        .impure      = traits->flags & OP_TRAIT_IMPURE
+    };
+
+    if (traits->cofunction != NULL)
     {
-        case 0: // $x
-            *out = args[0];
-            return LISTENERERR_SUCCESS;
-        case 1: // @x
-        {
-            bool res = history_get((int)args[0], out);
-            if (res)
-            {
-                return LISTENERERR_SUCCESS;
-            }
-            else
-            {
-                return LISTENERERR_HISTORY_NOT_SET;
-            }
-        }
-        case 2: // deriv(x, y)
-        case 3: // x'
-            return LISTENERERR_IMPOSSIBLE_DERIV;
-        case 4: // x+y
-            *out = args[0] + args[1];
-            return LISTENERERR_SUCCESS;
-        case 5: // x-y
-            *out = args[0] - args[1];
-            return LISTENERERR_SUCCESS;
-        case 6: // x*y
-            *out = args[0] * args[1];
-            return LISTENERERR_SUCCESS;
-        case 7: // x/y
-            if (args[1] != 0)
-            {
-                *out = args[0] / args[1];
-                return LISTENERERR_SUCCESS;
-            }
-            else
-            {
-                return LISTENERERR_DIVISION_BY_ZERO;
-            }
-        case 8: // x^y
-            if (args[0] == 0 && args[1] <= 0) return LISTENERERR_DIVISION_BY_ZERO;
-            if (args[0] < 0 && args[1] < 1) return LISTENERERR_COMPLEX_SOLUTION;
-            *out = pow(args[0], args[1]);
-            return LISTENERERR_SUCCESS;
-        case 9: // x C y
-            *out = binomial(args[0], args[1]);
-            return LISTENERERR_SUCCESS;
-        case 10: // x mod y
-            *out = fmod(args[0], args[1]);
-            return LISTENERERR_SUCCESS;
-        case 11: // +x
-            *out = args[0];
-            return LISTENERERR_SUCCESS;
-        case 12: // -x
-            *out = -args[0];
-            return LISTENERERR_SUCCESS;
-        case 13: // x!
-        {
-            if (isinf(args[0]))
-            {
-                *out = INFINITY;
-            }
-            else
-            {
-                double res = 1;
-                for (double i = trunc(args[0]); i > 1; i--)
-                {
-                    res *= i;
-                }
-                *out = res;
-            }
-            return LISTENERERR_SUCCESS;
-        }
-        case 14: // x%
-            *out = args[0] / 100;
-            return LISTENERERR_SUCCESS;
-        case 15: // exp(x)
-            *out = exp(args[0]);
-            return LISTENERERR_SUCCESS;
-        case 16: // root(x, n)
-            if (args[0] >= 0)
-            {
-                *out = pow(args[0], 1 / args[1]);
-                return LISTENERERR_SUCCESS;
-            }
-            else
-            {
-                return LISTENERERR_COMPLEX_SOLUTION;
-            }
-        case 17: // sqrt(x)
-            if (args[0] >= 0)
-            {
-                *out = sqrt(args[0]);
-                return LISTENERERR_SUCCESS;
-            }
-            else
-            {
-                return LISTENERERR_COMPLEX_SOLUTION;
-            }
-        case 18: // log(x, n)
-            *out = log(args[0]) / log(args[1]);
-            return LISTENERERR_SUCCESS;
-        case 19: // ln(x)
-            *out = log(args[0]);
-            return LISTENERERR_SUCCESS;
-        case 20: // ld(x)
-            *out = log2(args[0]);
-            return LISTENERERR_SUCCESS;
-        case 21: // log(x)
-            *out = log10(args[0]);
-            return LISTENERERR_SUCCESS;
-        case 22: // sin(x)
-            *out = sin(args[0]);
-            return LISTENERERR_SUCCESS;
-        case 23: // cos(x)
-            *out = cos(args[0]);
-            return LISTENERERR_SUCCESS;
-        case 24: // tan(x)
-            *out = tan(args[0]);
-            return LISTENERERR_SUCCESS;
-        case 25: // asin(x)
-            *out = asin(args[0]);
-            return LISTENERERR_SUCCESS;
-        case 26: // acos(x)
-            *out = acos(args[0]);
-            return LISTENERERR_SUCCESS;
-        case 27: // atan(x)
-            *out = atan(args[0]);
-            return LISTENERERR_SUCCESS;
-        case 28: // sinh(x)
-            *out = sinh(args[0]);
-            return LISTENERERR_SUCCESS;
-        case 29: // cosh(x)
-            *out = cosh(args[0]);
-            return LISTENERERR_SUCCESS;
-        case 30: // tanh(x)
-            *out = tanh(args[0]);
-            return LISTENERERR_SUCCESS;
-        case 31: // asinh(x)
-            *out = asinh(args[0]);
-            return LISTENERERR_SUCCESS;
-        case 32: // acosh(x)
-            *out = acosh(args[0]);
-            return LISTENERERR_SUCCESS;
-        case 33: // atanh(x)
-            *out = atanh(args[0]);
-            return LISTENERERR_SUCCESS;
-        case 34: // max(x, y, ...)
-        {
-            double res = -INFINITY;
-            for (size_t i = 0; i < num_args; i++)
-            {
-                double child_val = args[i];
-                if (child_val > res) res = child_val;
-            }
-            *out = res;
-            return LISTENERERR_SUCCESS;
-        }
-        case 35: // min(x, y, ...)
+        if (cofunctions[op->id] == NULL)
         {
-            double res = INFINITY;
-            for (size_t i = 0; i < num_args; i++)
-            {
-                double child_val = args[i];
-                if (child_val < res) res = child_val;
-            }
-            *out = res;
-            return LISTENERERR_SUCCESS;
-        }
-        case 36: // abs(x)
-            *out = fabs(args[0]);
-            return LISTENERERR_SUCCESS;
-        case 37: // ceil(x)
-            *out = ceil(args[0]);
-            return LISTENERERR_SUCCESS;
-        case 38: // floor(x)
-            *out = floor(args[0]);
-            return LISTENERERR_SUCCESS;
-        case 39: // round(x)
-            *out = round(args[0]);
-            return LISTENERERR_SUCCESS;
-        case 40: // trunc(x)
-            *out = trunc(args[0]);
-            return LISTENERERR_SUCCESS;
-        case 41: // frac(x)
-            *out = args[0] - floor(args[0]);
-            return LISTENERERR_SUCCESS;
-        case 42: // sgn(x)
-            *out = args[0] < 0 ? -1 : (args[0] > 0) ? 1 : 0;
-            return LISTENERERR_SUCCESS;
-        case 43: // sum(x, y, ...)
-        {
-            double res = 0;
-            for (size_t i = 0; i < num_args; i++) res += args[i];
-            *out = res;
-            return LISTENERERR_SUCCESS;
-        }
-        case 44: // prod(x, y, ...)
-        {
-            double res = 1;
-            for (size_t i = 0; i < num_args; i++) res *= args[i];
-            *out = res;
-            return LISTENERERR_SUCCESS;
-        }
-        case 45: // avg(x, y, ...)
-        {
-            if (num_args == 0)
-            {
-                *out = 0;
-                return LISTENERERR_SUCCESS;
-            }
-            double res = 0;
-            for (size_t i = 0; i < num_args; i++) res += args[i];
-            *out = res / num_args;
-            return LISTENERERR_SUCCESS;
-        }
-        case 46: // median(x, y, ...)
-            if (num_args == 0) return LISTENERERR_EMPTY_PARAMS;
-            *out = median(num_args, args);
-            return LISTENERERR_SUCCESS;
-        case 47: // gcd(x, y)
-            *out = euclid(args[0], args[1]);
-            return LISTENERERR_SUCCESS;
-        case 48: // lcm(x, y)
-            *out = fabs(trunc(args[0]) * trunc(args[1])) / euclid(args[0], args[1]);
-            return LISTENERERR_SUCCESS;
-        case 49: // rand(x, y)
-            *out = random_between(args[0], args[1]);
-            return LISTENERERR_SUCCESS;
-        case 50: // fib(x)
-            *out = fibonacci(args[0]);
-            return LISTENERERR_SUCCESS;
-        case 51: // gamma(x)
-            *out = tgamma(args[0]);
-            return LISTENERERR_SUCCESS;
-        case 52:
-            *out = variance(args, num_args);
-            return LISTENERERR_SUCCESS;
-        case 53: // pi
-            *out = 3.14159265359;
-            return LISTENERERR_SUCCESS;
-        case 54: // e
-            *out = 2.71828182846;
-            return LISTENERERR_SUCCESS;
-        case 55: // phi
-            *out = 1.61803398874;
-            return LISTENERERR_SUCCESS;
-        case 56: // clight (m/s)
-            *out = 299792458;
-            return LISTENERERR_SUCCESS;
-        case 57: // csound (m/s)
-            *out = 343.2;
-            return LISTENERERR_SUCCESS;
-        case 58: // ans
-        {
-            bool res = history_get(0, out);
-            if (res)
-            {
-                return LISTENERERR_SUCCESS;
-            }
-            else
-            {
-                return LISTENERERR_HISTORY_NOT_SET;
-            }
+            cofunctions[op->id] = ctx_lookup_op(g_ctx, traits->cofunction, OP_PLACE_FUNCTION);
         }
+        res.cofunction = cofunctions[op->id];
     }
-    return LISTENERERR_UNKNOWN_OP;
+    return res;
+}
+
+/*
+Summary: Recognizes folds that combine accumulator and value by a single associative operator with a kernel,
+    e.g. x+y, y*x, max(x, y) or sum(x, y). Such a fold over values equals the operator applied
+    to the initial value and the kernel's reduction of the values, up to rounding.
+Returns: False if fold needs to be evaluated step by step
+*/
+bool arith_get_reduction(const Node *fold, const char *acc_var, const char *value_var, AggregateKind *out_kind)
+{
+    if (get_type(fold) != NTYPE_OPERATOR || get_num_children(fold) != 2) return false;
+    const Operator *op = get_op(fold);
+    if (!is_arith_op(op) || op->traits->reduction == 0) return false;
+    if (!op_has_trait(op, OP_TRAIT_ASSOCIATIVE)) return false;
+
+    const Node *left = get_child(fold, 0);
+    const Node *right = get_child(fold, 1);
+    if (get_type(left) != NTYPE_VARIABLE || get_type(right) != NTYPE_VARIABLE) return false;
+
+    // When accumulator is on the right, values are combined in reverse order
+    bool in_order = strcmp(get_var_name(left), acc_var) == 0 && strcmp(get_var_name(right), value_var) == 0;
+    bool reversed = strcmp(get_var_name(left), value_var) == 0 && strcmp(get_var_name(right), acc_var) == 0;
+    if (!in_order && !(reversed && op_has_trait(op, OP_TRAIT_COMMUTATIVE))) return false;
+
+    *out_kind = op->traits->reduction;
+    return true;
 }
 
+/*
+Summary: Evaluates tree via bytecode, 0 on error
+*/
 double arith_evaluate(const Node *tree)
 {
     double res = 0;
-    tree_reduce(tree, arith_op_evaluate, &res, NULL);
+    Bytecode bytecode;
+    if (!bytecode_compile(tree, arith_op_info, &bytecode))
+    {
+        tree_reduce(tree, arith_op_evaluate, &res, NULL);
+        return res;
+    }
+    bytecode_run(&bytecode, arith_op_evaluate, NULL, &res, NULL);
+    bytecode_destroy(&bytecode);
     return res;
 }
@@ -3,6 +3,8 @@
 #include "../../engine/tree/operator.h"
 #include "../../engine/tree/node.h"
 #include "../../engine/tree/tree_util.h"
+#include "../../engine/evaluation/bytecode.h"
+#include "aggregate_kernels.h"
 
 #define LISTENERERR_HISTORY_NOT_SET   1
 #define LISTENERERR_IMPOSSIBLE_DERIV  2
@@ -13,5 +15,9 @@
 #define LISTENERERR_COMPLEX_SOLUTION  7
 #define LISTENERERR_EMPTY_PARAMS      8
 
+const OpTraits *arith_get_traits(const Operator *op);
 ListenerError arith_op_evaluate(const Operator *op, size_t num_args, const double *args, double *out);
+OpInfo arith_op_info(const Operator *op);
 double arith_evaluate(const Node *node);
+bool arith_get_reduction(const Node *fold, const char *acc_var, const char *value_var, AggregateKind *out_kind);
+void unload_arith_evaluation();
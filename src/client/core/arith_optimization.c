@@ -0,0 +1,344 @@
+#include <math.h>
+#include "../../util/alloc_wrappers.h"
+#include "../../util/vector.h"
+#include "../../engine/tree/tree_util.h"
+#include "../../engine/tree/tree_traversal.h"
+#include "arith_context.h"
+#include "arith_optimization.h"
+
+#define MAX_POWER_CHAIN    8  // Greater powers are left to pow, rounding error of a product grows with its length
+#define MAX_DEGREE         16 // Polynomials of greater degree are not rewritten
+#define MAX_MONOMIAL_DEPTH 32 // Deeper products are not considered to be monomials
+#define VECTOR_STARTSIZE   8
+
+typedef struct {
+    const Operator *add;
+    const Operator *sub;
+    const Operator *mul;
+    const Operator *div;
+    const Operator *pow;
+    const Operator *neg;
+    const Operator *log;
+    const Operator *ln;
+} Optimizer;
+
+// Coefficients of monomials in a single variable, collected from a sum
+typedef struct {
+    const Node *var; // First occurrence of variable, NULL as long as only constants have been found
+    size_t degree;
+    size_t num_terms;
+    double coeffs[MAX_DEGREE + 1];
+} Polynomial;
+
+// Summand of a sum, subtrahends are negative
+typedef struct {
+    const Node *node;
+    bool negative;
+} Term;
+
+static bool is_op(const Node *node, const Operator *op)
+{
+    return get_type(node) == NTYPE_OPERATOR && get_op(node) == op;
+}
+
+static bool is_const(const Node *node)
+{
+    return get_type(node) == NTYPE_CONSTANT;
+}
+
+// Impure subtrees must not be copied or reordered, every copy would be evaluated separately
+static bool contains_impure(const Node *node)
+{
+    if (get_type(node) != NTYPE_OPERATOR) return false;
+    if (op_has_trait(get_op(node), OP_TRAIT_IMPURE)) return true;
+    for (size_t i = 0; i < get_num_children(node); i++)
+    {
+        if (contains_impure(get_child(node, i))) return true;
+    }
+    return false;
+}
+
+static Node *binary(const Operator *op, Node *left, Node *right, size_t token_index)
+{
+    Node *res = malloc_operator_node(op, 2, token_index);
+    set_child(res, 0, left);
+    set_child(res, 1, right);
+    return res;
+}
+
+static Node *unary(const Operator *op, Node *child, size_t token_index)
+{
+    Node *res = malloc_operator_node(op, 1, token_index);
+    set_child(res, 0, child);
+    return res;
+}
+
+/*
+Summary: Matches c*x^k built from constants, the variable of poly, products, negation,
+    division by non-zero constants and positive integer powers
+Returns: False if node is not such a monomial, poly is not changed in this case
+*/
+static bool get_monomial(const Optimizer *opt,
+    const Node *node,
+    size_t depth,
+    Polynomial *poly,
+    double *out_coeff,
+    size_t *out_degree)
+{
+    if (depth > MAX_MONOMIAL_DEPTH) return false;
+    const Node *var = poly->var;
+    double coeff = 1;
+    size_t degree = 0;
+    bool success = false;
+
+    switch (get_type(node))
+    {
+        case NTYPE_CONSTANT:
+            coeff = get_const_value(node);
+            success = true;
+            break;
+
+        case NTYPE_VARIABLE:
+            if (poly->var == NULL) poly->var = node;
+            degree = 1;
+            success = get_var_symbol(poly->var) == get_var_symbol(node);
+            break;
+
+        case NTYPE_OPERATOR:
+        {
+            double right_coeff = 1;
+            size_t right_degree = 0;
+            if (is_op(node, opt->neg))
+            {
+                success = get_monomial(opt, get_child(node, 0), depth + 1, poly, &coeff, &degree);
+                coeff = -coeff;
+            }
+            else if (is_op(node, opt->mul))
+            {
+                success = get_monomial(opt, get_child(node, 0), depth + 1, poly, &coeff, &degree)
+                    && get_monomial(opt, get_child(node, 1), depth + 1, poly, &right_coeff, &right_degree);
+                coeff *= right_coeff;
+                degree += right_degree;
+            }
+            else if (is_op(node, opt->div) && is_const(get_child(node, 1)) && get_const_value(get_child(node, 1)) != 0)
+            {
+                success = get_monomial(opt, get_child(node, 0), depth + 1, poly, &coeff, &degree);
+                coeff /= get_const_value(get_child(node, 1));
+            }
+            else if (is_op(node, opt->pow) && is_const(get_child(node, 1)))
+            {
+                // Zero and negative exponents are errors for zero base
+                double exponent = get_const_value(get_child(node, 1));
+                success = exponent >= 1 && exponent <= MAX_DEGREE && exponent == trunc(exponent)
+                    && get_monomial(opt, get_child(node, 0), depth + 1, poly, &coeff, &degree);
+                coeff = pow(coeff, exponent);
+                degree *= (size_t)exponent;
+            }
+            break;
+        }
+    }
+
+    if (!success || degree > MAX_DEGREE || !isfinite(coeff))
+    {
+        poly->var = var;
+        return false;
+    }
+    *out_coeff = coeff;
+    *out_degree = degree;
+    return true;
+}
+
+// Flattens sums and differences without recursion
+static void collect_terms(const Optimizer *opt, const Node *sum, Vector *out_terms)
+{
+    Vector stack = vec_create(sizeof(Term), VECTOR_STARTSIZE);
+    VEC_PUSH_ELEM(&stack, Term, ((Term){ .node = sum, .negative = false }));
+    while (vec_count(&stack) > 0)
+    {
+        Term term = *(Term*)vec_pop(&stack);
+        if (is_op(term.node, opt->add) || is_op(term.node, opt->sub))
+        {
+            // Pushed in reverse to keep order of summands
+            bool negate_right = is_op(term.node, opt->sub) ? !term.negative : term.negative;
+            VEC_PUSH_ELEM(&stack, Term, ((Term){ .node = get_child(term.node, 1), .negative = negate_right }));
+            VEC_PUSH_ELEM(&stack, Term, ((Term){ .node = get_child(term.node, 0), .negative = term.negative }));
+        }
+        else if (is_op(term.node, opt->neg))
+        {
+            VEC_PUSH_ELEM(&stack, Term, ((Term){ .node = get_child(term.node, 0), .negative = !term.negative }));
+        }
+        else
+        {
+            vec_push(out_terms, &term);
+        }
+    }
+    vec_destroy(&stack);
+}
+
+static Node *build_horner(const Optimizer *opt, const Polynomial *poly, size_t token_index)
+{
+    double lead = poly->coeffs[poly->degree];
+    Node *res = tree_copy(poly->var);
+    if (lead == -1) res = unary(opt->neg, res, token_index);
+    else if (lead != 1) res = binary(opt->mul, malloc_constant_node(lead, token_index), res, token_index);
+
+    for (size_t i = poly->degree; i-- > 0;)
+    {
+        double coeff = poly->coeffs[i];
+        if (coeff > 0) res = binary(opt->add, res, malloc_constant_node(coeff, token_index), token_index);
+        if (coeff < 0) res = binary(opt->sub, res, malloc_constant_node(-coeff, token_index), token_index);
+        if (i > 0) res = binary(opt->mul, res, tree_copy(poly->var), token_index);
+    }
+    return res;
+}
+
+/*
+Summary: Replaces monomials of a sum by their polynomial in Horner form, other summands keep their order
+Returns: False if sum does not contain a polynomial of at least two terms and degree 2, or is impure
+*/
+static bool optimize_sum(const Optimizer *opt, Node **sum)
+{
+    if (contains_impure(*sum)) return false;
+
+    Vector terms = vec_create(sizeof(Term), VECTOR_STARTSIZE);
+    collect_terms(opt, *sum, &terms);
+    Polynomial poly = { .var = NULL, .degree = 0, .num_terms = 0, .coeffs = { 0 } };
+    bool *is_monomial = malloc_wrapper(vec_count(&terms) * sizeof(bool));
+    for (size_t i = 0; i < vec_count(&terms); i++)
+    {
+        Term *term = vec_get(&terms, i);
+        double coeff;
+        size_t degree;
+        is_monomial[i] = get_monomial(opt, term->node, 0, &poly, &coeff, &degree);
+        if (!is_monomial[i]) continue;
+        poly.coeffs[degree] += term->negative ? -coeff : coeff;
+        if (degree > poly.degree) poly.degree = degree;
+        poly.num_terms++;
+    }
+
+    bool finite = true;
+    for (size_t i = 0; i <= poly.degree; i++) finite &= isfinite(poly.coeffs[i]);
+    bool success = poly.var != NULL && poly.num_terms >= 2 && poly.degree >= 2 && poly.coeffs[poly.degree] != 0 && finite;
+    if (success)
+    {
+        Node *res = NULL;
+        size_t token_index = get_token_index(*sum);
+        for (size_t i = 0; i < vec_count(&terms); i++)
+        {
+            if (is_monomial[i]) continue;
+            Term *term = vec_get(&terms, i);
+            Node *copy = tree_copy(term->node);
+            if (res == NULL) res = term->negative ? unary(opt->neg, copy, token_index) : copy;
+            else res = binary(term->negative ? opt->sub : opt->add, res, copy, token_index);
+        }
+        Node *horner = build_horner(opt, &poly, token_index);
+        tree_replace(sum, res != NULL ? binary(opt->add, res, horner, token_index) : horner);
+    }
+
+    free(is_monomial);
+    vec_destroy(&terms);
+    return success;
+}
+
+static TraversalAction optimize_pre(Node **node, Traversal *traversal, void *state)
+{
+    // Whole sums are rewritten at once from their topmost operator
+    const Optimizer *opt = state;
+    const Node *parent = traversal_parent(traversal);
+    if ((is_op(*node, opt->add) || is_op(*node, opt->sub) || is_op(*node, opt->neg))
+        && (parent == NULL || !(is_op(parent, opt->add) || is_op(parent, opt->sub) || is_op(parent, opt->neg))))
+    {
+        optimize_sum(opt, node);
+    }
+    return TRAVERSAL_CONTINUE;
+}
+
+// x^k as product of squares, equal factors are computed once by bytecode
+static Node *build_power(const Optimizer *opt, const Node *base, size_t exponent, size_t token_index)
+{
+    if (exponent == 1) return tree_copy(base);
+    Node *half = build_power(opt, base, exponent / 2, token_index);
+    Node *res = binary(opt->mul, half, tree_copy(half), token_index);
+    if (exponent % 2 == 1) res = binary(opt->mul, res, tree_copy(base), token_index);
+    return res;
+}
+
+// Returns true if node is a constant or ln of a constant, out_value is its value
+static bool get_const_operand(const Optimizer *opt, const Node *node, double *out_value)
+{
+    if (is_op(node, opt->ln) && is_const(get_child(node, 0)))
+    {
+        *out_value = log(get_const_value(get_child(node, 0)));
+        return true;
+    }
+    if (is_const(node))
+    {
+        *out_value = get_const_value(node);
+        return true;
+    }
+    return false;
+}
+
+static TraversalAction optimize_post(Node **node, __attribute__((unused)) Traversal *traversal, void *state)
+{
+    const Optimizer *opt = state;
+    if (get_type(*node) != NTYPE_OPERATOR || get_num_children(*node) != 2) return TRAVERSAL_CONTINUE;
+    size_t token_index = get_token_index(*node);
+    const Node *left = get_child(*node, 0);
+    const Node *right = get_child(*node, 1);
+    double value;
+
+    // x^k -> x*x*...
+    if (is_op(*node, opt->pow) && is_const(right))
+    {
+        double exponent = get_const_value(right);
+        if (exponent >= 1 && exponent <= MAX_POWER_CHAIN && exponent == trunc(exponent) && !contains_impure(left))
+        {
+            tree_replace(node, build_power(opt, left, (size_t)exponent, token_index));
+        }
+    }
+
+    // x/c -> x*(1/c), x/ln(c) -> x*(1/ln(c))
+    if (is_op(*node, opt->div) && get_const_operand(opt, right, &value))
+    {
+        double reciprocal = 1 / value;
+        if (value != 0 && isfinite(reciprocal) && reciprocal != 0)
+        {
+            Node *res = binary(opt->mul, tree_copy(left), malloc_constant_node(reciprocal, token_index), token_index);
+            tree_replace(node, res);
+        }
+    }
+
+    // log(x, c) -> ln(x)*(1/ln(c))
+    if (is_op(*node, opt->log) && is_const(right))
+    {
+        double reciprocal = 1 / log(get_const_value(right));
+        if (isfinite(reciprocal))
+        {
+            Node *res = binary(opt->mul,
+                unary(opt->ln, tree_copy(left), token_index),
+                malloc_constant_node(reciprocal, token_index),
+                token_index);
+            tree_replace(node, res);
+        }
+    }
+    return TRAVERSAL_CONTINUE;
+}
+
+/*
+Summary: Rewrites tree for faster numeric evaluation, see arith_optimization.h
+*/
+void arith_optimize(Node **tree)
+{
+    Optimizer opt = {
+        .add = ctx_lookup_op(g_ctx, "+", OP_PLACE_INFIX),
+        .sub = ctx_lookup_op(g_ctx, "-", OP_PLACE_INFIX),
+        .mul = ctx_lookup_op(g_ctx, "*", OP_PLACE_INFIX),
+        .div = ctx_lookup_op(g_ctx, "/", OP_PLACE_INFIX),
+        .pow = ctx_lookup_op(g_ctx, "^", OP_PLACE_INFIX),
+        .neg = ctx_lookup_op(g_ctx, "-", OP_PLACE_PREFIX),
+        .log = ctx_lookup_op(g_ctx, "log", OP_PLACE_FUNCTION),
+        .ln  = ctx_lookup_op(g_ctx, "ln", OP_PLACE_FUNCTION)
+    };
+    tree_traverse(tree, optimize_pre, optimize_post, &opt);
+}
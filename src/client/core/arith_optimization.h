@@ -0,0 +1,14 @@
+#pragma once
+#include "../../engine/tree/node.h"
+
+/*
+Rewrites trees of the arithmetic context to be evaluated many times, e.g. by table, not to be displayed:
+    Small positive integer powers become products (x^3 -> x*x*x, x^4 -> (x*x)*(x*x)),
+    sums of monomials in one variable become Horner form (x^3-2x^2+x/8 -> ((x-2)*x+0.125)*x),
+    division by a constant becomes multiplication by its reciprocal,
+    logarithms to a constant base become ln times a constant (log(x, 10) and ln(x)/ln(10) -> ln(x)*0.434...).
+Subtrees that are repeated by this are computed once by bytecode.
+Results may differ from the original tree in rounding, but errors occur for the same variable values.
+*/
+
+void arith_optimize(Node **tree);
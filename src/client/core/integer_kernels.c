@@ -0,0 +1,180 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <math.h>
+#include "integer_kernels.h"
+
+#define MAX_EXACT         9007199254740992.0 // 2^53, all integers up to this are representable
+#define MAX_EXACT_FIB     92                 // F(93) exceeds INT64_MAX
+#define MAX_FIB           1476               // F(1477) exceeds DBL_MAX
+#define MAX_FACTORIAL     170                // 171! exceeds DBL_MAX
+#define MAX_BINOMIAL_PROD 64                 // Running product of more factors loses more precision than lgamma
+
+static const size_t NUM_FACTORIALS = 21; // 20! is the greatest factorial within int64
+static const uint64_t factorials[] = {
+    1, 1, 2, 6, 24, 120, 720, 5040, 40320, 362880, 3628800, 39916800, 479001600, 6227020800,
+    87178291200, 1307674368000, 20922789888000, 355687428096000, 6402373705728000,
+    121645100408832000, 2432902008176640000
+};
+
+/*
+Summary: Fast doubling, uses F(2k) = F(k)(2F(k+1) - F(k)) and F(2k+1) = F(k)^2 + F(k+1)^2
+    while scanning bits of n from most significant one. Needs log(n) steps.
+*/
+static uint64_t fib_exact(uint64_t n)
+{
+    uint64_t a = 0; // F(k)
+    uint64_t b = 1; // F(k+1)
+    for (int bit = 63 - __builtin_clzll(n | 1); bit >= 0; bit--)
+    {
+        uint64_t c = a * (2 * b - a);
+        uint64_t d = a * a + b * b;
+        if ((n >> bit) & 1)
+        {
+            a = d;
+            b = c + d;
+        }
+        else
+        {
+            a = c;
+            b = d;
+        }
+    }
+    return a;
+}
+
+/*
+Summary: Fibonacci numbers, generalized to negative numbers by F(-n) = (-1)^(n+1) F(n)
+*/
+double int_fib(double n)
+{
+    if (isnan(n)) return NAN;
+    n = trunc(n);
+    double abs_n = fabs(n);
+    double sign = n < 0 && fmod(abs_n, 2) == 0 ? -1 : 1;
+
+    if (abs_n <= MAX_EXACT_FIB) return sign * (double)fib_exact((uint64_t)abs_n);
+    if (abs_n > MAX_FIB) return sign * INFINITY;
+    // Binet's formula, the other term vanishes for large n. phi^n itself would overflow for the greatest n.
+    double phi = (1 + sqrt(5)) / 2;
+    return sign * round(pow(phi, abs_n - 2) * (phi * phi / sqrt(5)));
+}
+
+/*
+Summary: Binary GCD after one modulo step, which balances arguments of very different magnitude
+*/
+static uint64_t gcd_exact(uint64_t a, uint64_t b)
+{
+    if (a < b)
+    {
+        uint64_t temp = a;
+        a = b;
+        b = temp;
+    }
+    if (b == 0) return a;
+    a %= b;
+    if (a == 0) return b;
+
+    int shift = __builtin_ctzll(a | b);
+    a >>= __builtin_ctzll(a);
+    while (b != 0)
+    {
+        b >>= __builtin_ctzll(b);
+        if (a > b)
+        {
+            uint64_t temp = a;
+            a = b;
+            b = temp;
+        }
+        b -= a;
+    }
+    return a << shift;
+}
+
+double int_gcd(double a, double b)
+{
+    a = fabs(trunc(a));
+    b = fabs(trunc(b));
+    if (!isfinite(a) || !isfinite(b)) return NAN;
+    if (a <= MAX_EXACT && b <= MAX_EXACT) return (double)gcd_exact((uint64_t)a, (uint64_t)b);
+
+    // Beyond 2^53 every double is an integer and fmod is exact
+    while (b != 0)
+    {
+        double rem = fmod(a, b);
+        a = b;
+        b = rem;
+    }
+    return a;
+}
+
+double int_lcm(double a, double b)
+{
+    a = fabs(trunc(a));
+    b = fabs(trunc(b));
+    double gcd = int_gcd(a, b);
+    if (isnan(gcd) || gcd == 0) return NAN;
+
+    uint64_t res;
+    if (a <= MAX_EXACT && b <= MAX_EXACT
+        && !__builtin_mul_overflow((uint64_t)(a / gcd), (uint64_t)b, &res))
+    {
+        return (double)res;
+    }
+    return a / gcd * b;
+}
+
+/*
+Summary: Computes n C k by multiplicative formula, reduces every step by gcd to keep intermediate results exact
+Returns: False on overflow
+*/
+static bool binomial_exact(uint64_t n, uint64_t k, uint64_t *out)
+{
+    uint64_t res = 1;
+    for (uint64_t i = 1; i <= k; i++)
+    {
+        // res * (n - k + i) is divisible by i, and i / gcd(res, i) divides n - k + i
+        uint64_t gcd = gcd_exact(res, i);
+        if (__builtin_mul_overflow(res / gcd, (n - k + i) / (i / gcd), &res)) return false;
+    }
+    *out = res;
+    return true;
+}
+
+double int_binomial(double n, double k)
+{
+    n = fabs(trunc(n));
+    k = fabs(trunc(k));
+    if (isnan(n) || isnan(k)) return NAN;
+    if (k > n) return 0;
+    if (2 * k > n) k = n - k;
+    if (k == 0) return 1;
+
+    uint64_t res;
+    if (n <= MAX_EXACT && binomial_exact((uint64_t)n, (uint64_t)k, &res)) return (double)res;
+
+    if (k <= MAX_BINOMIAL_PROD)
+    {
+        double prod = 1;
+        for (double i = 1; i <= k; i++) prod = prod * (n - k + i) / i;
+        return round(prod);
+    }
+    return round(exp(lgamma(n + 1) - lgamma(k + 1) - lgamma(n - k + 1)));
+}
+
+/*
+Summary: Factorial of truncated n, 1 for n < 2
+*/
+double int_factorial(double n)
+{
+    if (isinf(n)) return INFINITY;
+    if (isnan(n)) return NAN;
+    n = trunc(n);
+    if (n < 2) return 1;
+    if (n < NUM_FACTORIALS) return (double)factorials[(size_t)n];
+    if (n > MAX_FACTORIAL) return INFINITY;
+
+    double res = (double)factorials[NUM_FACTORIALS - 1];
+    for (double i = NUM_FACTORIALS; i <= n; i++) res *= i;
+    return res;
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+/*
+Number-theoretic functions of the arithmetic context. Arguments are truncated to integers.
+As long as arguments are exactly representable (at most 2^53) and results do not overflow,
+they are computed in exact 64-bit integer arithmetic, otherwise in floating point.
+Every function takes at most a few hundred steps, regardless of its arguments.
+*/
+
+double int_fib(double n);
+double int_gcd(double a, double b);
+double int_lcm(double a, double b);
+double int_binomial(double n, double k);
+double int_factorial(double n);
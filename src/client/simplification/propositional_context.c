@@ -1,5 +1,6 @@
 #include "../../util/console_util.h"
 #include "../core/arith_context.h"
+#include "propositional_evaluation.h"
 #include "propositional_context.h"
 
 #define NUM_PROPOSITIONAL_OPS 18
@@ -31,6 +32,7 @@ void init_propositional_ctx()
     {
         software_defect("[Prop] Inconsistent operator set.\n");
     }
+    ctx_set_traits(g_propositional_ctx, prop_get_traits);
     // Remove glue-op to detect malformed syntax
     ctx_set_glue_op(g_propositional_ctx, NULL);
 }
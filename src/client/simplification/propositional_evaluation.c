@@ -12,62 +12,94 @@
 #define EVAL_TRUE       1
 #define EVAL_FALSE      0
 
-ListenerError prop_op_evaluate(const Operator *op, size_t num_args, const double *args, double *out)
+// Signature of OpTraits.evaluate
+#define EVALUATOR(name) static ListenerError name(\
+    __attribute__((unused)) const Operator *op,\
+    __attribute__((unused)) size_t num_args,\
+    __attribute__((unused)) const double *args,\
+    double *out)
+
+#define SIMPLE_EVALUATOR(name, expr) EVALUATOR(name)\
+{\
+    *out = (expr) ? EVAL_TRUE : EVAL_FALSE;\
+    return LISTENERERR_SUCCESS;\
+}
+
+SIMPLE_EVALUATOR(eval_equal,         args[0] == args[1])
+SIMPLE_EVALUATOR(eval_not_equal,     args[0] != args[1])
+SIMPLE_EVALUATOR(eval_greater,       args[0] > args[1])
+SIMPLE_EVALUATOR(eval_less,          args[0] < args[1])
+SIMPLE_EVALUATOR(eval_greater_equal, args[0] >= args[1])
+SIMPLE_EVALUATOR(eval_less_equal,    args[0] <= args[1])
+SIMPLE_EVALUATOR(eval_or,            args[0] != EVAL_FALSE || args[1] != EVAL_FALSE)
+SIMPLE_EVALUATOR(eval_and,           args[0] != EVAL_FALSE && args[1] != EVAL_FALSE)
+SIMPLE_EVALUATOR(eval_true,          true)
+SIMPLE_EVALUATOR(eval_false,         false)
+SIMPLE_EVALUATOR(eval_not,           args[0] == EVAL_FALSE)
+
+EVALUATOR(eval_type_const)
 {
-    // Propositional context is an extension of the arithmetic context
-    if (op->id < NUM_ARITH_OPS)
-    {
-        return arith_op_evaluate(op, num_args, args, out);
-    }
+    *out = EVAL_TYPE_CONST;
+    return LISTENERERR_SUCCESS;
+}
+
+EVALUATOR(eval_type_var)
+{
+    *out = EVAL_TYPE_VAR;
+    return LISTENERERR_SUCCESS;
+}
 
-    switch (op->id)
+EVALUATOR(eval_type_op)
+{
+    *out = EVAL_TYPE_OP;
+    return LISTENERERR_SUCCESS;
+}
+
+#define LOGICAL (OP_TRAIT_COMMUTATIVE | OP_TRAIT_ASSOCIATIVE | OP_TRAIT_IDENTITY)
+
+// Indexed by id of operator minus NUM_ARITH_OPS, i.e. in order of init_propositional_ctx
+// Functions on subtrees (type, equal, count, contains) are reduced by propositional_checker beforehand
+static const OpTraits prop_traits[] = {
+    { .evaluate = NULL },                                              // type(x)
+    { .evaluate = NULL },                                              // equal(x, y)
+    { .evaluate = eval_equal, .flags = OP_TRAIT_COMMUTATIVE },         // x == y
+    { .evaluate = eval_not_equal, .flags = OP_TRAIT_COMMUTATIVE },     // x != y
+    { .evaluate = eval_type_const },                                   // CONST
+    { .evaluate = eval_type_var },                                     // VAR
+    { .evaluate = eval_type_op },                                      // OP
+    { .evaluate = eval_greater },                                      // x > y
+    { .evaluate = eval_less },                                         // x < y
+    { .evaluate = eval_greater_equal },                                // x >= y
+    { .evaluate = eval_less_equal },                                   // x <= y
+    { .evaluate = eval_or, .flags = LOGICAL, .identity = EVAL_FALSE }, // x || y
+    { .evaluate = eval_and, .flags = LOGICAL, .identity = EVAL_TRUE }, // x && y
+    { .evaluate = eval_true },                                         // TRUE
+    { .evaluate = eval_false },                                        // FALSE
+    { .evaluate = eval_not },                                          // !x
+    { .evaluate = NULL },                                              // count(x, ...)
+    { .evaluate = NULL }                                               // contains(x, y)
+};
+
+/*
+Returns: Traits of operator of propositional context (to be passed to ctx_set_traits)
+*/
+const OpTraits *prop_get_traits(const Operator *op)
+{
+    if (op->id < NUM_ARITH_OPS) return arith_get_traits(op);
+    if (op->id - NUM_ARITH_OPS < sizeof(prop_traits) / sizeof(OpTraits)) return &prop_traits[op->id - NUM_ARITH_OPS];
+    return NULL;
+}
+
+/*
+Summary: Evaluates operators of propositional context, which is an extension of the arithmetic context
+*/
+ListenerError prop_op_evaluate(const Operator *op, size_t num_args, const double *args, double *out)
+{
+    if (op->traits == NULL || op->traits->evaluate == NULL)
     {
-        case NUM_ARITH_OPS + 2: // ==
-            *out = (args[0] == args[1]) ? EVAL_TRUE : EVAL_FALSE;
-            return LISTENERERR_SUCCESS;
-        case NUM_ARITH_OPS + 3: // !=
-            *out = (args[0] != args[1]) ? EVAL_TRUE : EVAL_FALSE;
-            return LISTENERERR_SUCCESS;
-        case NUM_ARITH_OPS + 4: // CONST
-            *out = EVAL_TYPE_CONST;
-            return LISTENERERR_SUCCESS;
-        case NUM_ARITH_OPS + 5: // VAR
-            *out = EVAL_TYPE_VAR;
-            return LISTENERERR_SUCCESS;
-        case NUM_ARITH_OPS + 6: // OP
-            *out = EVAL_TYPE_OP;
-            return LISTENERERR_SUCCESS;
-        case NUM_ARITH_OPS + 7: // >
-            *out = (args[0] > args[1]) ? EVAL_TRUE : EVAL_FALSE;
-            return LISTENERERR_SUCCESS;
-        case NUM_ARITH_OPS + 8: // <
-            *out = (args[0] < args[1]) ? EVAL_TRUE : EVAL_FALSE;
-            return LISTENERERR_SUCCESS;
-        case NUM_ARITH_OPS + 9: // >=
-            *out = (args[0] >= args[1]) ? EVAL_TRUE : EVAL_FALSE;
-            return LISTENERERR_SUCCESS;
-        case NUM_ARITH_OPS + 10: // <=
-            *out = (args[0] <= args[1]) ? EVAL_TRUE : EVAL_FALSE;
-            return LISTENERERR_SUCCESS;
-        case NUM_ARITH_OPS + 11: // ||
-            *out = (args[0] != EVAL_FALSE || args[1] != EVAL_FALSE) ? EVAL_TRUE : EVAL_FALSE;
-            return LISTENERERR_SUCCESS;
-        case NUM_ARITH_OPS + 12: // &&
-            *out = (args[0] != EVAL_FALSE && args[1] != EVAL_FALSE) ? EVAL_TRUE : EVAL_FALSE;
-            return LISTENERERR_SUCCESS;
-        case NUM_ARITH_OPS + 13: // TRUE
-            *out = EVAL_TRUE;
-            return LISTENERERR_SUCCESS;
-        case NUM_ARITH_OPS + 14: // FALSE
-            *out = EVAL_FALSE;
-            return LISTENERERR_SUCCESS;
-        case NUM_ARITH_OPS + 15: // !
-            *out = (args[0] != EVAL_FALSE) ? EVAL_FALSE : EVAL_TRUE;
-            return LISTENERERR_SUCCESS;
+        software_defect("[Prop] No reduction possible for operator %s.\n", op->name);
     }
-
-    software_defect("[Prop] No reduction possible for operator %s.\n", op->name);
-    return LISTENERERR_UNKNOWN_OP; // To make compiler happy
+    return arith_op_evaluate(op, num_args, args, out);
 }
 
 double equal_eval(__attribute__((unused)) size_t num_children, const Node * const *children)
@@ -4,5 +4,6 @@
 #include "../../engine/tree/node.h"
 #include "../../engine/tree/tree_util.h"
 
+const OpTraits *prop_get_traits(const Operator *op);
 ListenerError prop_op_evaluate(const Operator *op, size_t num_args, const double *args, double *out);
 bool propositional_checker(Node **tree);
@@ -3,6 +3,7 @@
 #include <stdio.h>
 #include <unistd.h>
 
+#include "../../engine/tree/tree_traversal.h"
 #include "../../engine/tree/tree_util.h"
 #include "../../engine/tree/tree_to_string.h"
 #include "../../engine/transformation/rewrite_rule.h"
@@ -42,28 +43,24 @@ bool simplification_is_initialized()
     return initialized;
 }
 
-// Replaces single constant nodes of negative value by an "-"-operator node with child that is a positive constant node
-static void replace_negative_consts(Node **tree)
+// Replaces single constant node of negative value by an "-"-operator node with child that is a positive constant node
+static TraversalAction replace_negative_const(Node **node,
+    __attribute__((unused)) Traversal *traversal,
+    __attribute__((unused)) void *state)
 {
-    if (get_type(*tree) == NTYPE_CONSTANT)
+    if (get_type(*node) == NTYPE_CONSTANT && get_const_value(*node) < 0)
     {
-        if (get_const_value(*tree) < 0)
-        {
-            Node *minus_op = malloc_operator_node(ctx_lookup_op(g_ctx, "-", OP_PLACE_PREFIX), 1, get_token_index(*tree));
-            set_child(minus_op, 0, malloc_constant_node(fabs(get_const_value(*tree)), get_token_index(*tree)));
-            tree_replace(tree, minus_op);
-        }
-    }
-    else
-    {
-        if (get_type(*tree) == NTYPE_OPERATOR)
-        {
-            for (size_t i = 0; i < get_num_children(*tree); i++)
-            {
-                replace_negative_consts(get_child_addr(*tree, i));
-            }
-        }
+        Node *minus_op = malloc_operator_node(ctx_lookup_op(g_ctx, "-", OP_PLACE_PREFIX), 1, get_token_index(*node));
+        set_child(minus_op, 0, malloc_constant_node(fabs(get_const_value(*node)), get_token_index(*node)));
+        tree_replace(node, minus_op);
     }
+    return TRAVERSAL_CONTINUE;
+}
+
+static void replace_negative_consts(Node **tree)
+{
+    // In post-order, replacements are not visited
+    tree_traverse(tree, NULL, replace_negative_const, NULL);
 }
 
 /*
@@ -137,7 +134,7 @@ ListenerError apply_derivatives(Node **tree, const Node **errnode)
     Matching matching;
     Node **matched;
     // Transform shorthand derivative to deriv(expr, x)
-    while ((matched = find_matching((const Node**)tree, &deriv_before, NULL, &matching)) != NULL)
+    while ((matched = find_matching(tree, &deriv_before, NULL, &matching)) != NULL)
     {
         // Check if there is more than one variable in within derivative shorthand
         const char *vars[2];
@@ -161,7 +158,7 @@ ListenerError apply_derivatives(Node **tree, const Node **errnode)
     }
 
     // Check for deriv(x, y) WHERE !(type(y) == VAR)
-    if ((matched = find_matching((const Node**)tree, &malformed_deriv, propositional_checker, &matching)) != NULL)
+    if ((matched = find_matching(tree, &malformed_deriv, propositional_checker, &matching)) != NULL)
     {
         if (errnode != NULL) *errnode = *matched;
         return LISTENERERR_MALFORMED_DERIV_B;
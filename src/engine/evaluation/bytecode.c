@@ -0,0 +1,843 @@
+#include <string.h>
+#include "../../util/alloc_wrappers.h"
+#include "../../util/vector.h"
+#include "../tree/tree_traversal.h"
+#include "bytecode.h"
+
+#define VECTOR_STARTSIZE 8
+
+// Distinct subtree that is computed once and then held in a temporary
+typedef struct {
+    const Node *tree; // NULL when slot is empty
+    size_t count;     // Number of occurrences
+    ssize_t temp;     // Temporary that holds its value, -1 as long as it has not been computed
+} Subexpr;
+
+// Application of unary operator that has a cofunction, and application of the cofunction to the same argument
+typedef struct {
+    const Node *node;       // NULL when slot is empty
+    const Node *cofunction; // NULL as long as it has not been found
+} FusedPair;
+
+// Argument list of operators with the same shared function, and which of them are applied to it
+typedef struct {
+    const Node *node;   // First application, NULL when slot is empty
+    SharedFn fn;
+    uint32_t selection; // Bits of operators applied to the list
+    ssize_t temp;       // First temporary of results, -1 as long as they have not been computed
+} SharedList;
+
+// Intermediate state while tree is compiled in post-order
+typedef struct {
+    OpClassifier classifier;
+    size_t curr_stack; // Stack size after the instruction emitted last
+    size_t max_stack;
+    size_t num_temps;
+    Subexpr *subexprs; // Hash table with linear probing, NULL if subexpressions are not eliminated
+    size_t subexprs_capacity;
+    FusedPair *pairs;  // Hash table with linear probing by argument, same capacity as subexprs
+    SharedList *lists; // Hash table with linear probing by arguments, same capacity as subexprs
+    Vector purity;     // Stack of bools while counting subexpressions: Whether subtree contains impure operator
+    Vector instructions;
+    Vector token_indices;
+    Vector ops;
+    Vector unary_fns;
+    Vector batch_fns;
+    Vector fused_fns;
+    Vector fused_batch_fns;
+    Vector shared_fns;
+    Vector shared_calls;
+    Vector values;
+    Vector vars;
+} Compiler;
+
+// Functions of inline unary operators and shared functions are taken from info, NULL for other operators
+static size_t lookup_op(Compiler *compiler, const Operator *op, const OpInfo *info)
+{
+    for (size_t i = 0; i < vec_count(&compiler->ops); i++)
+    {
+        if (*(const Operator**)vec_get(&compiler->ops, i) == op) return i;
+    }
+    OpInfo fns = info != NULL ? *info : (OpInfo){ .kind = OPKIND_CALL };
+    vec_push(&compiler->ops, &op);
+    vec_push(&compiler->unary_fns, &fns.unary);
+    vec_push(&compiler->batch_fns, &fns.batch);
+    vec_push(&compiler->fused_fns, &fns.fused);
+    vec_push(&compiler->fused_batch_fns, &fns.fused_batch);
+    vec_push(&compiler->shared_fns, &fns.shared);
+    return vec_count(&compiler->ops) - 1;
+}
+
+static size_t lookup_var(Compiler *compiler, Symbol symbol)
+{
+    for (size_t i = 0; i < vec_count(&compiler->vars); i++)
+    {
+        if (*(Symbol*)vec_get(&compiler->vars, i) == symbol) return i;
+    }
+    vec_push(&compiler->vars, &symbol);
+    return vec_count(&compiler->vars) - 1;
+}
+
+/*
+Summary: Appends instruction and tracks stack size
+Params
+    num_popped: Number of values consumed by instruction, every instruction pushes one value
+*/
+static void emit(Compiler *compiler, Opcode opcode, size_t op, size_t arg, size_t num_popped, size_t token_index)
+{
+    Instruction instr = { .opcode = opcode, .op = op, .arg = arg };
+    vec_push(&compiler->instructions, &instr);
+    vec_push(&compiler->token_indices, &token_index);
+    compiler->curr_stack = compiler->curr_stack - num_popped + 1;
+    if (compiler->curr_stack > compiler->max_stack) compiler->max_stack = compiler->curr_stack;
+}
+
+// Maps kind of operator to inline opcode, returns BC_CALL when it can not be inlined for this number of children
+static Opcode get_inline_opcode(OpKind kind, size_t num_children)
+{
+    switch (kind)
+    {
+        case OPKIND_ADD: return num_children == 2 ? BC_ADD : BC_CALL;
+        case OPKIND_SUB: return num_children == 2 ? BC_SUB : BC_CALL;
+        case OPKIND_MUL: return num_children == 2 ? BC_MUL : BC_CALL;
+        case OPKIND_DIV: return num_children == 2 ? BC_DIV : BC_CALL;
+        case OPKIND_NEG: return num_children == 1 ? BC_NEG : BC_CALL;
+        case OPKIND_UNARY: return num_children == 1 ? BC_UNARY : BC_CALL;
+        default: return BC_CALL;
+    }
+}
+
+static OpInfo classify(const Compiler *compiler, const Operator *op)
+{
+    return compiler->classifier != NULL ? compiler->classifier(op) : (OpInfo){ .kind = OPKIND_CALL };
+}
+
+// Subtrees that are worth to be held in a temporary
+static bool is_subexpr_candidate(const Compiler *compiler, const Node *node)
+{
+    return get_type(node) == NTYPE_OPERATOR
+        && get_num_children(node) > 0
+        && !(classify(compiler, get_op(node)).kind == OPKIND_IDENTITY && get_num_children(node) == 1);
+}
+
+static Subexpr *lookup_subexpr(Compiler *compiler, const Node *tree)
+{
+    size_t index = get_hash(tree) & (compiler->subexprs_capacity - 1);
+    while (compiler->subexprs[index].tree != NULL && !tree_equals(compiler->subexprs[index].tree, tree))
+    {
+        index = (index + 1) & (compiler->subexprs_capacity - 1);
+    }
+    return &compiler->subexprs[index];
+}
+
+// Operators that are computed together with their cofunction
+static bool has_cofunction(const Node *node, const OpInfo *info)
+{
+    return get_type(node) == NTYPE_OPERATOR
+        && get_num_children(node) == 1
+        && info->kind == OPKIND_UNARY
+        && info->cofunction != NULL
+        && info->fused != NULL;
+}
+
+// Finds slot of application of op or cofunction to the same argument as node
+static FusedPair *lookup_pair(Compiler *compiler, const Node *node, const Operator *cofunction)
+{
+    const Node *arg = get_child(node, 0);
+    size_t index = get_hash(arg) & (compiler->subexprs_capacity - 1);
+    while (compiler->pairs[index].node != NULL)
+    {
+        const Node *other = compiler->pairs[index].node;
+        if ((get_op(other) == get_op(node) || get_op(other) == cofunction) && tree_equals(get_child(other, 0), arg))
+        {
+            break;
+        }
+        index = (index + 1) & (compiler->subexprs_capacity - 1);
+    }
+    return &compiler->pairs[index];
+}
+
+// Operators whose value is computed by a shared function
+static bool has_shared(const Node *node, const OpInfo *info)
+{
+    return get_type(node) == NTYPE_OPERATOR
+        && get_num_children(node) > 0
+        && info->kind == OPKIND_CALL
+        && info->shared != NULL
+        && !info->impure;
+}
+
+static bool args_equal(const Node *a, const Node *b)
+{
+    if (get_num_children(a) != get_num_children(b)) return false;
+    for (size_t i = 0; i < get_num_children(a); i++)
+    {
+        if (!tree_equals(get_child(a, i), get_child(b, i))) return false;
+    }
+    return true;
+}
+
+// Finds slot of argument list of node among those of operators with the same shared function
+static SharedList *lookup_list(Compiler *compiler, const Node *node, SharedFn fn)
+{
+    size_t hash = get_num_children(node);
+    for (size_t i = 0; i < get_num_children(node); i++) hash = hash * 31 + get_hash(get_child(node, i));
+
+    size_t index = hash & (compiler->subexprs_capacity - 1);
+    while (compiler->lists[index].node != NULL
+        && !(compiler->lists[index].fn == fn && args_equal(compiler->lists[index].node, node)))
+    {
+        index = (index + 1) & (compiler->subexprs_capacity - 1);
+    }
+    return &compiler->lists[index];
+}
+
+// Index of temporary that holds result of operator selected by bit, relative to first temporary of list
+static size_t get_shared_result(const SharedList *list, uint32_t bit)
+{
+    return __builtin_popcount(list->selection & (bit - 1));
+}
+
+static TraversalAction count_pre(__attribute__((unused)) Node **node,
+    __attribute__((unused)) Traversal *traversal,
+    void *state)
+{
+    Compiler *compiler = state;
+    bool pure = true;
+    vec_push(&compiler->purity, &pure);
+    return TRAVERSAL_CONTINUE;
+}
+
+// Counts occurrences of every pure subtree
+static TraversalAction count_post(Node **node, __attribute__((unused)) Traversal *traversal, void *state)
+{
+    Compiler *compiler = state;
+    bool pure = *(bool*)vec_pop(&compiler->purity);
+    OpInfo info = get_type(*node) == NTYPE_OPERATOR ? classify(compiler, get_op(*node)) : (OpInfo){ .kind = OPKIND_CALL };
+    if (info.impure) pure = false;
+
+    if (pure && is_subexpr_candidate(compiler, *node))
+    {
+        Subexpr *subexpr = lookup_subexpr(compiler, *node);
+        if (subexpr->tree == NULL) *subexpr = (Subexpr){ .tree = *node, .count = 0, .temp = -1 };
+        subexpr->count++;
+    }
+
+    // Remember first application of operator and of its cofunction to each argument
+    if (pure && has_cofunction(*node, &info))
+    {
+        FusedPair *pair = lookup_pair(compiler, *node, info.cofunction);
+        if (pair->node == NULL) pair->node = *node;
+        else if (pair->cofunction == NULL && get_op(pair->node) != get_op(*node)) pair->cofunction = *node;
+    }
+
+    // Collect operators applied to each argument list
+    if (pure && has_shared(*node, &info))
+    {
+        SharedList *list = lookup_list(compiler, *node, info.shared);
+        if (list->node == NULL) *list = (SharedList){ .node = *node, .fn = info.shared, .selection = 0, .temp = -1 };
+        list->selection |= info.shared_bit;
+    }
+
+    // Impurity propagates to parent
+    if (!pure && vec_count(&compiler->purity) > 0) *(bool*)vec_peek(&compiler->purity) = false;
+    return TRAVERSAL_CONTINUE;
+}
+
+static Subexpr *get_common_subexpr(Compiler *compiler, const Node *node)
+{
+    if (compiler->subexprs == NULL || !is_subexpr_candidate(compiler, node)) return NULL;
+    Subexpr *subexpr = lookup_subexpr(compiler, node);
+    return subexpr->tree != NULL && subexpr->count > 1 ? subexpr : NULL;
+}
+
+/*
+Summary: Looks for cofunction of same argument whose value can be computed together with node
+Returns: Subexpression of cofunction without temporary yet, NULL if there is none
+*/
+static Subexpr *get_fusable_cofunction(Compiler *compiler, const Node *node, const OpInfo *info)
+{
+    if (compiler->pairs == NULL || !has_cofunction(node, info)) return NULL;
+    FusedPair *pair = lookup_pair(compiler, node, info->cofunction);
+    if (pair->node == NULL || pair->cofunction == NULL) return NULL;
+
+    const Node *partner = get_op(pair->node) == get_op(node) ? pair->cofunction : pair->node;
+    Subexpr *subexpr = lookup_subexpr(compiler, partner);
+    return subexpr->tree != NULL && subexpr->temp == -1 ? subexpr : NULL;
+}
+
+/*
+Summary: Looks for argument list of node that is shared with other operators and has not been computed yet
+Returns: NULL if node is computed on its own
+*/
+static SharedList *get_shareable_list(Compiler *compiler, const Node *node, const OpInfo *info)
+{
+    if (compiler->lists == NULL || !has_shared(node, info)) return NULL;
+    SharedList *list = lookup_list(compiler, node, info->shared);
+    return list->node != NULL && list->temp == -1 && __builtin_popcount(list->selection) > 1 ? list : NULL;
+}
+
+// Loads value of subtree from temporary instead of computing it again
+static TraversalAction compile_pre(Node **node, __attribute__((unused)) Traversal *traversal, void *state)
+{
+    Compiler *compiler = state;
+    if (compiler->subexprs == NULL || !is_subexpr_candidate(compiler, *node)) return TRAVERSAL_CONTINUE;
+    // Temporary is also set when subtree has been computed by fused call of its cofunction
+    Subexpr *subexpr = lookup_subexpr(compiler, *node);
+    if (subexpr->tree != NULL && subexpr->temp != -1)
+    {
+        emit(compiler, BC_LOAD, 0, subexpr->temp, 0, get_token_index(*node));
+        return TRAVERSAL_SKIP;
+    }
+
+    // Result of shared call at another application to the same arguments
+    OpInfo info = classify(compiler, get_op(*node));
+    if (!has_shared(*node, &info)) return TRAVERSAL_CONTINUE;
+    SharedList *list = lookup_list(compiler, *node, info.shared);
+    if (list->node == NULL || list->temp == -1) return TRAVERSAL_CONTINUE;
+
+    emit(compiler, BC_LOAD, 0, list->temp + get_shared_result(list, info.shared_bit), 0, get_token_index(*node));
+    return TRAVERSAL_SKIP;
+}
+
+static TraversalAction compile_post(Node **node, __attribute__((unused)) Traversal *traversal, void *state)
+{
+    Compiler *compiler = state;
+    switch (get_type(*node))
+    {
+        case NTYPE_CONSTANT:
+        {
+            double value = get_const_value(*node);
+            vec_push(&compiler->values, &value);
+            emit(compiler, BC_CONST, 0, vec_count(&compiler->values) - 1, 0, get_token_index(*node));
+            break;
+        }
+
+        case NTYPE_VARIABLE:
+            emit(compiler, BC_VAR, 0, lookup_var(compiler, get_var_symbol(*node)), 0, get_token_index(*node));
+            break;
+
+        case NTYPE_OPERATOR:
+        {
+            size_t num_children = get_num_children(*node);
+            OpInfo info = classify(compiler, get_op(*node));
+
+            // Value of child is already on top of the stack
+            if (info.kind == OPKIND_IDENTITY && num_children == 1) break;
+
+            Opcode opcode = get_inline_opcode(info.kind, num_children);
+            bool uses_fns = opcode == BC_UNARY || has_shared(*node, &info);
+            size_t op = lookup_op(compiler, get_op(*node), uses_fns ? &info : NULL);
+            Subexpr *cofunction = opcode == BC_UNARY ? get_fusable_cofunction(compiler, *node, &info) : NULL;
+            SharedList *list = get_shareable_list(compiler, *node, &info);
+            if (cofunction != NULL)
+            {
+                cofunction->temp = compiler->num_temps++;
+                emit(compiler, BC_FUSED, op, cofunction->temp, 1, get_token_index(*node));
+            }
+            else if (list != NULL)
+            {
+                // First application to argument list computes all operators applied to it
+                list->temp = compiler->num_temps;
+                compiler->num_temps += __builtin_popcount(list->selection);
+                SharedCall call = {
+                    .num_args  = num_children,
+                    .selection = list->selection,
+                    .temp      = list->temp,
+                    .result    = list->temp + get_shared_result(list, info.shared_bit)
+                };
+                vec_push(&compiler->shared_calls, &call);
+                emit(compiler, BC_SHARED, op, vec_count(&compiler->shared_calls) - 1, num_children, get_token_index(*node));
+            }
+            else
+            {
+                emit(compiler, opcode, op, num_children, num_children, get_token_index(*node));
+            }
+
+            // First occurrence of common subexpression, keep its value for the others
+            Subexpr *subexpr = get_common_subexpr(compiler, *node);
+            if (subexpr != NULL)
+            {
+                subexpr->temp = compiler->num_temps++;
+                emit(compiler, BC_STORE, 0, subexpr->temp, 1, get_token_index(*node));
+            }
+            break;
+        }
+    }
+    return TRAVERSAL_CONTINUE;
+}
+
+/*
+Summary: Compiles tree to bytecode, tree can be freed afterwards.
+    Subtrees are looked up by their hashes, so infos of tree are cached first (see update_info).
+    Apart from that, tree is not changed.
+Params
+    classifier: Tells which operators can be executed inline and which are impure.
+                Allowed to be NULL: Listener evaluates every operator and every occurrence of a subtree.
+Returns: False if tree has more than BYTECODE_MAX_OPS distinct operators, out_bytecode is not initialized in this case
+*/
+bool bytecode_compile(const Node *tree, OpClassifier classifier, Bytecode *out_bytecode)
+{
+    // Otherwise, the hash of each subtree would be computed from scratch at every lookup
+    update_info((Node*)tree);
+    size_t num_nodes = get_info(tree).num_nodes;
+    Compiler compiler = {
+        .classifier      = classifier,
+        .curr_stack      = 0,
+        .max_stack       = 0,
+        .num_temps       = 0,
+        .subexprs        = NULL,
+        .pairs           = NULL,
+        .lists           = NULL,
+        .instructions    = vec_create(sizeof(Instruction), num_nodes),
+        .token_indices   = vec_create(sizeof(size_t), num_nodes),
+        .ops             = vec_create(sizeof(const Operator*), VECTOR_STARTSIZE),
+        .unary_fns       = vec_create(sizeof(double (*)(double)), VECTOR_STARTSIZE),
+        .batch_fns       = vec_create(sizeof(BatchFn), VECTOR_STARTSIZE),
+        .fused_fns       = vec_create(sizeof(FusedFn), VECTOR_STARTSIZE),
+        .fused_batch_fns = vec_create(sizeof(FusedBatchFn), VECTOR_STARTSIZE),
+        .shared_fns      = vec_create(sizeof(SharedFn), VECTOR_STARTSIZE),
+        .shared_calls    = vec_create(sizeof(SharedCall), VECTOR_STARTSIZE),
+        .values          = vec_create(sizeof(double), VECTOR_STARTSIZE),
+        .vars            = vec_create(sizeof(Symbol), VECTOR_STARTSIZE)
+    };
+
+    // Count subexpressions first to know which ones occur more than once
+    if (classifier != NULL)
+    {
+        compiler.subexprs_capacity = 2;
+        while (compiler.subexprs_capacity < 2 * num_nodes) compiler.subexprs_capacity *= 2;
+        compiler.subexprs = calloc_wrapper(compiler.subexprs_capacity, sizeof(Subexpr));
+        compiler.pairs = calloc_wrapper(compiler.subexprs_capacity, sizeof(FusedPair));
+        compiler.lists = calloc_wrapper(compiler.subexprs_capacity, sizeof(SharedList));
+        compiler.purity = vec_create(sizeof(bool), VECTOR_STARTSIZE);
+        tree_traverse((Node**)&tree, count_pre, count_post, &compiler);
+        vec_destroy(&compiler.purity);
+    }
+
+    tree_traverse((Node**)&tree, compile_pre, compile_post, &compiler);
+    free(compiler.subexprs);
+    free(compiler.pairs);
+    free(compiler.lists);
+
+    // Buffers of vectors are owned by bytecode from now on
+    *out_bytecode = (Bytecode){
+        .num_instructions = vec_count(&compiler.instructions),
+        .instructions     = compiler.instructions.buffer,
+        .token_indices    = compiler.token_indices.buffer,
+        .num_ops          = vec_count(&compiler.ops),
+        .ops              = compiler.ops.buffer,
+        .unary_fns        = compiler.unary_fns.buffer,
+        .batch_fns        = compiler.batch_fns.buffer,
+        .fused_fns        = compiler.fused_fns.buffer,
+        .fused_batch_fns  = compiler.fused_batch_fns.buffer,
+        .shared_fns       = compiler.shared_fns.buffer,
+        .num_shared_calls = vec_count(&compiler.shared_calls),
+        .shared_calls     = compiler.shared_calls.buffer,
+        .num_values       = vec_count(&compiler.values),
+        .values           = compiler.values.buffer,
+        .num_vars         = vec_count(&compiler.vars),
+        .vars             = compiler.vars.buffer,
+        .stack_size       = compiler.max_stack,
+        .num_temps        = compiler.num_temps
+    };
+
+    if (out_bytecode->num_ops > BYTECODE_MAX_OPS)
+    {
+        bytecode_destroy(out_bytecode);
+        return false;
+    }
+    return true;
+}
+
+void bytecode_destroy(Bytecode *bytecode)
+{
+    free(bytecode->instructions);
+    free(bytecode->token_indices);
+    free(bytecode->ops);
+    free(bytecode->unary_fns);
+    free(bytecode->batch_fns);
+    free(bytecode->fused_fns);
+    free(bytecode->fused_batch_fns);
+    free(bytecode->shared_fns);
+    free(bytecode->shared_calls);
+    free(bytecode->values);
+    free(bytecode->vars);
+}
+
+/*
+Returns: Index of variable in var_values of bytecode_run, -1 if bytecode does not contain variable
+*/
+ssize_t bytecode_lookup_variable(const Bytecode *bytecode, const char *var_name)
+{
+    Symbol symbol;
+    if (!symbol_lookup(var_name, &symbol)) return -1;
+    for (size_t i = 0; i < bytecode->num_vars; i++)
+    {
+        if (bytecode->vars[i] == symbol) return i;
+    }
+    return -1;
+}
+
+/*
+Summary: Executes bytecode, equivalent to tree_reduce of the compiled tree (given a consistent classifier)
+Params
+    var_values:          Values of variables by index (see bytecode_lookup_variable), variables are an error when NULL
+    out:                 Result, only written on success
+    out_err_instruction: Index of instruction in which error occurred, allowed to be NULL.
+                         Its token index is bytecode->token_indices[*out_err_instruction].
+*/
+ListenerError bytecode_run(const Bytecode *bytecode,
+    TreeListener listener,
+    const double *var_values,
+    double *out,
+    size_t *out_err_instruction)
+{
+    // Temporaries are stored after the stack
+    double local_stack[BYTECODE_LOCAL_STACK_SIZE];
+    size_t num_slots = bytecode->stack_size + bytecode->num_temps;
+    double *stack = num_slots <= BYTECODE_LOCAL_STACK_SIZE
+        ? local_stack
+        : malloc_wrapper(num_slots * sizeof(double));
+    double *temps = stack + bytecode->stack_size;
+    size_t top = 0;
+    ListenerError err = LISTENERERR_SUCCESS;
+    const Instruction *instructions = bytecode->instructions;
+
+    for (size_t i = 0; i < bytecode->num_instructions; i++)
+    {
+        const Instruction *instr = &instructions[i];
+        size_t num_args = instr->arg;
+        switch ((Opcode)instr->opcode)
+        {
+            case BC_CONST:
+                stack[top++] = bytecode->values[instr->arg];
+                continue;
+
+            case BC_VAR:
+                if (var_values == NULL)
+                {
+                    err = LISTENERERR_VARIABLE_ENCOUNTERED;
+                    break;
+                }
+                stack[top++] = var_values[instr->arg];
+                continue;
+
+            case BC_ADD:
+                top--;
+                stack[top - 1] += stack[top];
+                continue;
+
+            case BC_SUB:
+                top--;
+                stack[top - 1] -= stack[top];
+                continue;
+
+            case BC_MUL:
+                top--;
+                stack[top - 1] *= stack[top];
+                continue;
+
+            case BC_DIV:
+                if (stack[top - 1] != 0)
+                {
+                    top--;
+                    stack[top - 1] /= stack[top];
+                    continue;
+                }
+                // Listener reports division by zero
+                num_args = 2;
+                break;
+
+            case BC_NEG:
+                stack[top - 1] = -stack[top - 1];
+                continue;
+
+            case BC_UNARY:
+                stack[top - 1] = bytecode->unary_fns[instr->op](stack[top - 1]);
+                continue;
+
+            case BC_FUSED:
+                bytecode->fused_fns[instr->op](stack[top - 1], &stack[top - 1], &temps[instr->arg]);
+                continue;
+
+            case BC_CALL:
+                break;
+
+            case BC_SHARED:
+            {
+                const SharedCall *call = &bytecode->shared_calls[instr->arg];
+                top -= call->num_args;
+                bytecode->shared_fns[instr->op](stack + top, call->num_args, call->selection, &temps[call->temp]);
+                stack[top++] = temps[call->result];
+                continue;
+            }
+
+            case BC_STORE:
+                temps[instr->arg] = stack[top - 1];
+                continue;
+
+            case BC_LOAD:
+                stack[top++] = temps[instr->arg];
+                continue;
+        }
+
+        if (err == LISTENERERR_SUCCESS)
+        {
+            // Arguments are the topmost values on the stack
+            double res;
+            top -= num_args;
+            err = listener(bytecode->ops[instr->op], num_args, stack + top, &res);
+            stack[top++] = res;
+        }
+
+        if (err != LISTENERERR_SUCCESS)
+        {
+            if (out_err_instruction != NULL) *out_err_instruction = i;
+            break;
+        }
+    }
+
+    if (err == LISTENERERR_SUCCESS) *out = stack[0];
+    if (stack != local_stack) free(stack);
+    return err;
+}
+
+// Stack slot of batch evaluation, one value per row
+typedef double Column[BYTECODE_BATCH_SIZE];
+
+// Loops over whole columns to be vectorized, lanes beyond the last row hold arbitrary values
+static void column_add(double *restrict a, const double *restrict b)
+{
+    for (size_t j = 0; j < BYTECODE_BATCH_SIZE; j++) a[j] += b[j];
+}
+
+static void column_sub(double *restrict a, const double *restrict b)
+{
+    for (size_t j = 0; j < BYTECODE_BATCH_SIZE; j++) a[j] -= b[j];
+}
+
+static void column_mul(double *restrict a, const double *restrict b)
+{
+    for (size_t j = 0; j < BYTECODE_BATCH_SIZE; j++) a[j] *= b[j];
+}
+
+static void column_div(double *restrict a, const double *restrict b)
+{
+    for (size_t j = 0; j < BYTECODE_BATCH_SIZE; j++) a[j] /= b[j];
+}
+
+static void column_neg(double *a)
+{
+    for (size_t j = 0; j < BYTECODE_BATCH_SIZE; j++) a[j] = -a[j];
+}
+
+/*
+Summary: Invokes listener for a single row, args are gathered from the topmost columns of the stack
+Returns: Error of listener, result is written to stack[top][lane] on success
+*/
+static ListenerError call_lane(TreeListener listener,
+    const Operator *op,
+    Column *stack,
+    size_t top,
+    size_t num_args,
+    size_t lane,
+    double *args)
+{
+    for (size_t k = 0; k < num_args; k++) args[k] = stack[top + k][lane];
+    double res;
+    ListenerError err = listener(op, num_args, args, &res);
+    if (err == LISTENERERR_SUCCESS) stack[top][lane] = res;
+    return err;
+}
+
+// Executes bytecode for up to BYTECODE_BATCH_SIZE rows, see bytecode_run_batch
+static void run_chunk(const Bytecode *bytecode,
+    TreeListener listener,
+    const double *const *var_columns,
+    size_t num_lanes,
+    Column *stack,
+    double *args,
+    ListenerError *errors)
+{
+    Column *temps = stack + bytecode->stack_size;
+    size_t top = 0;
+    for (size_t i = 0; i < bytecode->num_instructions; i++)
+    {
+        const Instruction *instr = &bytecode->instructions[i];
+        switch ((Opcode)instr->opcode)
+        {
+            case BC_CONST:
+                for (size_t j = 0; j < BYTECODE_BATCH_SIZE; j++) stack[top][j] = bytecode->values[instr->arg];
+                top++;
+                break;
+
+            case BC_VAR:
+                for (size_t j = 0; j < BYTECODE_BATCH_SIZE; j++)
+                {
+                    stack[top][j] = var_columns != NULL && j < num_lanes ? var_columns[instr->arg][j] : 0;
+                }
+                if (var_columns == NULL)
+                {
+                    for (size_t j = 0; j < num_lanes; j++)
+                    {
+                        if (errors[j] == LISTENERERR_SUCCESS) errors[j] = LISTENERERR_VARIABLE_ENCOUNTERED;
+                    }
+                }
+                top++;
+                break;
+
+            case BC_ADD:
+                top--;
+                column_add(stack[top - 1], stack[top]);
+                break;
+
+            case BC_SUB:
+                top--;
+                column_sub(stack[top - 1], stack[top]);
+                break;
+
+            case BC_MUL:
+                top--;
+                column_mul(stack[top - 1], stack[top]);
+                break;
+
+            case BC_DIV:
+                top--;
+                // Rows with zero divisor are evaluated by listener (like bytecode_run does),
+                // the divisor is then set to 1 to leave its result untouched by the vectorized division
+                for (size_t j = 0; j < num_lanes; j++)
+                {
+                    if (stack[top][j] != 0) continue;
+                    if (errors[j] == LISTENERERR_SUCCESS)
+                    {
+                        errors[j] = call_lane(listener, bytecode->ops[instr->op], stack, top - 1, 2, j, args);
+                    }
+                    stack[top][j] = 1;
+                }
+                column_div(stack[top - 1], stack[top]);
+                break;
+
+            case BC_NEG:
+                column_neg(stack[top - 1]);
+                break;
+
+            case BC_UNARY:
+            {
+                if (bytecode->batch_fns[instr->op] != NULL)
+                {
+                    bytecode->batch_fns[instr->op](stack[top - 1], num_lanes);
+                    break;
+                }
+                double (*fn)(double) = bytecode->unary_fns[instr->op];
+                for (size_t j = 0; j < num_lanes; j++) stack[top - 1][j] = fn(stack[top - 1][j]);
+                break;
+            }
+
+            case BC_FUSED:
+            {
+                if (bytecode->fused_batch_fns[instr->op] != NULL)
+                {
+                    bytecode->fused_batch_fns[instr->op](stack[top - 1], temps[instr->arg], num_lanes);
+                    break;
+                }
+                FusedFn fn = bytecode->fused_fns[instr->op];
+                for (size_t j = 0; j < num_lanes; j++) fn(stack[top - 1][j], &stack[top - 1][j], &temps[instr->arg][j]);
+                break;
+            }
+
+            case BC_CALL:
+                // Arguments are the topmost columns on the stack, rows that already failed are not evaluated further
+                top -= instr->arg;
+                for (size_t j = 0; j < num_lanes; j++)
+                {
+                    if (errors[j] != LISTENERERR_SUCCESS) continue;
+                    errors[j] = call_lane(listener, bytecode->ops[instr->op], stack, top, instr->arg, j, args);
+                }
+                top++;
+                break;
+
+            case BC_SHARED:
+            {
+                // Results of each row are scattered to the temporaries
+                const SharedCall *call = &bytecode->shared_calls[instr->arg];
+                size_t num_results = __builtin_popcount(call->selection);
+                double results[BYTECODE_MAX_SHARED];
+                top -= call->num_args;
+                for (size_t j = 0; j < num_lanes; j++)
+                {
+                    if (errors[j] != LISTENERERR_SUCCESS) continue;
+                    for (size_t k = 0; k < call->num_args; k++) args[k] = stack[top + k][j];
+                    bytecode->shared_fns[instr->op](args, call->num_args, call->selection, results);
+                    for (size_t k = 0; k < num_results; k++) temps[call->temp + k][j] = results[k];
+                }
+                memcpy(stack[top], temps[call->result], sizeof(Column));
+                top++;
+                break;
+            }
+
+            case BC_STORE:
+                memcpy(temps[instr->arg], stack[top - 1], sizeof(Column));
+                break;
+
+            case BC_LOAD:
+                memcpy(stack[top], temps[instr->arg], sizeof(Column));
+                top++;
+                break;
+        }
+    }
+}
+
+/*
+Summary: Executes bytecode for many assignments of variables at once, each row is equivalent to bytecode_run
+Params
+    var_columns: Values of variables by index (see bytecode_lookup_variable), each an array of num_rows values.
+                 Variables are an error when NULL.
+    out:         Result of each row, only meaningful when row succeeded
+    out_errors:  Error of each row, LISTENERERR_SUCCESS if it succeeded
+Returns: Number of rows in which an error occurred
+*/
+size_t bytecode_run_batch(const Bytecode *bytecode,
+    TreeListener listener,
+    const double *const *var_columns,
+    size_t num_rows,
+    double *out,
+    ListenerError *out_errors)
+{
+    if (num_rows == 0) return 0;
+    Column *stack = malloc_wrapper((bytecode->stack_size + bytecode->num_temps) * sizeof(Column));
+    double *args = malloc_wrapper(bytecode->stack_size * sizeof(double));
+    const double **chunk_columns = bytecode->num_vars > 0 && var_columns != NULL
+        ? malloc_wrapper(bytecode->num_vars * sizeof(double*))
+        : NULL;
+    size_t num_errors = 0;
+
+    for (size_t offset = 0; offset < num_rows; offset += BYTECODE_BATCH_SIZE)
+    {
+        size_t num_lanes = num_rows - offset < BYTECODE_BATCH_SIZE ? num_rows - offset : BYTECODE_BATCH_SIZE;
+        for (size_t k = 0; chunk_columns != NULL && k < bytecode->num_vars; k++)
+        {
+            chunk_columns[k] = var_columns[k] + offset;
+        }
+        for (size_t j = 0; j < num_lanes; j++) out_errors[offset + j] = LISTENERERR_SUCCESS;
+
+        run_chunk(bytecode,
+            listener,
+            var_columns != NULL ? chunk_columns : NULL,
+            num_lanes,
+            stack,
+            args,
+            out_errors + offset);
+
+        for (size_t j = 0; j < num_lanes; j++)
+        {
+            out[offset + j] = stack[0][j];
+            if (out_errors[offset + j] != LISTENERERR_SUCCESS) num_errors++;
+        }
+    }
+
+    free(stack);
+    free(args);
+    free(chunk_columns);
+    return num_errors;
+}
@@ -0,0 +1,125 @@
+#pragma once
+#include <stdint.h>
+#include <sys/types.h>
+#include "../tree/node.h"
+#include "../tree/tree_util.h"
+
+/*
+Linear bytecode for repeated numeric evaluation of a tree, executed by a stack machine.
+Instructions are emitted in post-order: Operands are pushed, operations replace their arguments on the stack by their result.
+Operators are evaluated by the TreeListener (BC_CALL), except for operators a client classifies as
+elementary arithmetic or pure unary function (see OpInfo), these are executed inline without any call.
+Given a classifier, equal subtrees are computed only once per evaluation (common-subexpression elimination):
+The first occurrence leaves a copy of its value in a numbered temporary, further occurrences just load it.
+The VM does not allocate for stacks (including temporaries) up to BYTECODE_LOCAL_STACK_SIZE values.
+bytecode_run_batch executes each instruction for BYTECODE_BATCH_SIZE rows at once, its stack slots are
+columns, so inline arithmetic becomes loops the compiler can vectorize. Errors are tracked per row.
+Unary functions with a vectorized variant (OpInfo.batch, e.g. from vecmath.h) are applied to whole columns.
+When a unary function and its cofunction (e.g. sin and cos) are applied to the same argument, both are computed
+by one fused call at the first of them, the other one is held in a temporary.
+Likewise, operators with a shared function (e.g. avg and var) that are applied to equal argument lists
+are computed by one call of it at the first of them (BC_SHARED), the others load their results from temporaries.
+*/
+
+#define BYTECODE_MAX_OPS          UINT16_MAX
+#define BYTECODE_LOCAL_STACK_SIZE 64
+#define BYTECODE_BATCH_SIZE       256
+#define BYTECODE_MAX_SHARED       32 // Operators of one shared function, one bit each
+
+typedef enum {
+    BC_CONST, // Push value at arg in value pool
+    BC_VAR,   // Push value of variable at arg in variable table
+    BC_ADD,
+    BC_SUB,
+    BC_MUL,
+    BC_DIV,   // Falls back to BC_CALL when divisor is zero, so that listener reports error
+    BC_NEG,
+    BC_UNARY, // Apply function of operator to top value
+    BC_FUSED, // Like BC_UNARY, also writes cofunction of top value to temporary at arg
+    BC_CALL,  // Invoke listener with operator and arg many topmost values
+    BC_SHARED, // Invoke shared function of operator as described by shared call at arg
+    BC_STORE, // Copy top value to temporary at arg, value stays on stack
+    BC_LOAD   // Push value of temporary at arg
+} Opcode;
+
+// How an operator can be executed, supplied by client
+typedef enum {
+    OPKIND_CALL,     // Not known to bytecode, evaluated by listener
+    OPKIND_IDENTITY, // Unary operator that returns its argument
+    OPKIND_ADD,      // Binary operators, error-free except for division by zero
+    OPKIND_SUB,
+    OPKIND_MUL,
+    OPKIND_DIV,
+    OPKIND_NEG,
+    OPKIND_UNARY     // Unary function that never fails, e.g. sin
+} OpKind;
+
+typedef void (*BatchFn)(double *values, size_t num_values); // Applies function to values in place
+typedef void (*FusedFn)(double x, double *out, double *out_cofunction);
+typedef void (*FusedBatchFn)(double *values, double *out_cofunction, size_t num_values);
+// Computes operators of selection (bits) for the same arguments, writes one result per bit in order of bits
+typedef void (*SharedFn)(const double *args, size_t num_args, uint32_t selection, double *out_results);
+
+typedef struct {
+    OpKind kind;
+    double (*unary)(double);    // Only for OPKIND_UNARY
+    BatchFn batch;              // Optional for OPKIND_UNARY, used by bytecode_run_batch, may differ from unary in rounding
+    const Operator *cofunction; // Optional for OPKIND_UNARY, its value for the same argument is computed by fused
+    FusedFn fused;              // Required when cofunction is set
+    FusedBatchFn fused_batch;   // Optional vectorized variant of fused
+    SharedFn shared;            // Optional for OPKIND_CALL that never fails, computes it together with others
+    uint32_t shared_bit;        // Single bit that selects operator in shared, required when shared is set
+    bool impure;                // Result may differ for same arguments (e.g. random numbers), never computed once for many calls
+} OpInfo;
+
+typedef OpInfo (*OpClassifier)(const Operator *op);
+
+typedef struct {
+    uint8_t opcode;
+    uint16_t op;  // Index in operator table, for BC_DIV, BC_UNARY, BC_CALL and BC_SHARED
+    uint32_t arg; // Meaning depends on opcode
+} Instruction;
+
+// Operands of BC_SHARED
+typedef struct {
+    uint32_t num_args;
+    uint32_t selection; // Operators computed at once, see SharedFn
+    uint32_t temp;      // First of the temporaries that receive the results, one per operator
+    uint32_t result;    // Temporary whose value is pushed
+} SharedCall;
+
+typedef struct {
+    size_t num_instructions;
+    Instruction *instructions;
+    size_t *token_indices; // Side table, parallel to instructions
+    size_t num_ops;
+    const Operator **ops;
+    double (**unary_fns)(double); // Parallel to ops
+    BatchFn *batch_fns;           // Parallel to ops, NULL entries when there is no vectorized variant
+    FusedFn *fused_fns;           // Parallel to ops
+    FusedBatchFn *fused_batch_fns;
+    SharedFn *shared_fns;         // Parallel to ops
+    size_t num_shared_calls;
+    SharedCall *shared_calls;
+    size_t num_values;
+    double *values;
+    size_t num_vars;
+    Symbol *vars;
+    size_t stack_size;
+    size_t num_temps;
+} Bytecode;
+
+bool bytecode_compile(const Node *tree, OpClassifier classifier, Bytecode *out_bytecode);
+void bytecode_destroy(Bytecode *bytecode);
+ssize_t bytecode_lookup_variable(const Bytecode *bytecode, const char *var_name);
+ListenerError bytecode_run(const Bytecode *bytecode,
+    TreeListener listener,
+    const double *var_values,
+    double *out,
+    size_t *out_err_instruction);
+size_t bytecode_run_batch(const Bytecode *bytecode,
+    TreeListener listener,
+    const double *const *var_columns,
+    size_t num_rows,
+    double *out,
+    ListenerError *out_errors);
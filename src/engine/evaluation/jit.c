@@ -0,0 +1,405 @@
+#define _DEFAULT_SOURCE // MAP_ANONYMOUS
+#include <string.h>
+#include "jit.h"
+
+#if defined(USE_JIT) && defined(__x86_64__)
+
+#include <sys/mman.h>
+#include "../../util/vector.h"
+
+#define CODE_STARTSIZE   256
+#define JUMPS_STARTSIZE  8
+#define SIGN_MASK        0x8000000000000000
+
+// SSE2 opcodes (second byte after 0x0F), all used with F2 prefix (scalar double)
+#define SSE_LOAD  0x10 // movsd xmm, m64
+#define SSE_STORE 0x11 // movsd m64, xmm
+#define SSE_ADD   0x58
+#define SSE_MUL   0x59
+#define SSE_SUB   0x5C
+#define SSE_DIV   0x5E
+
+/*
+Generated code follows the System V ABI: JitEntry(var_values: rdi, out: rsi, out_err_instruction: rdx).
+These are kept in callee-saved registers (rbx, r12, r13) to survive calls.
+Slot k of the VM stack is at [rsp + 8k], followed by one slot for results of listener calls and the temporaries.
+*/
+
+typedef struct {
+    Vector code;        // Bytes of machine code
+    Vector error_jumps; // Positions of rel32-operands to be patched to jump to error exit
+    uint32_t frame_size;
+    uint32_t result_slot;
+    size_t first_temp;  // Slot of first temporary
+} Emitter;
+
+static void emit_bytes(Emitter *emitter, size_t num_bytes, uint8_t *bytes)
+{
+    vec_push_many(&emitter->code, num_bytes, bytes);
+}
+
+#define EMIT(emitter, ...) emit_bytes(emitter, sizeof((uint8_t[]){ __VA_ARGS__ }), (uint8_t[]){ __VA_ARGS__ })
+
+static void emit_u32(Emitter *emitter, uint32_t value)
+{
+    for (size_t i = 0; i < 4; i++) EMIT(emitter, (uint8_t)(value >> (8 * i)));
+}
+
+static void emit_u64(Emitter *emitter, uint64_t value)
+{
+    for (size_t i = 0; i < 8; i++) EMIT(emitter, (uint8_t)(value >> (8 * i)));
+}
+
+static size_t code_pos(const Emitter *emitter)
+{
+    return vec_count(&emitter->code);
+}
+
+// Emits rel32-operand of jump whose target is not known yet, returns its position for patch_jump
+static size_t emit_jump_operand(Emitter *emitter)
+{
+    size_t pos = code_pos(emitter);
+    emit_u32(emitter, 0);
+    return pos;
+}
+
+static void patch_jump(Emitter *emitter, size_t operand_pos, size_t target)
+{
+    uint32_t rel = (uint32_t)(target - (operand_pos + 4));
+    for (size_t i = 0; i < 4; i++)
+    {
+        *(uint8_t*)vec_get(&emitter->code, operand_pos + i) = (uint8_t)(rel >> (8 * i));
+    }
+}
+
+static uint32_t slot(size_t index)
+{
+    return (uint32_t)(index * sizeof(double));
+}
+
+// <sse_op> xmm, [rsp + disp32] or (for SSE_STORE) movsd [rsp + disp32], xmm
+static void emit_sse_stack(Emitter *emitter, uint8_t sse_op, uint8_t xmm, uint32_t disp)
+{
+    EMIT(emitter, 0xF2, 0x0F, sse_op, 0x84 | (xmm << 3), 0x24);
+    emit_u32(emitter, disp);
+}
+
+// mov rax, imm64
+static void emit_mov_rax(Emitter *emitter, uint64_t value)
+{
+    EMIT(emitter, 0x48, 0xB8);
+    emit_u64(emitter, value);
+}
+
+// Address of function pointer variable to integer, ISO C does not allow to cast function pointers to object pointers
+static uint64_t fn_address(const void *fn_variable, size_t size)
+{
+    uint64_t res = 0;
+    memcpy(&res, fn_variable, size);
+    return res;
+}
+
+#define FN_ADDRESS(fn) fn_address(&(fn), sizeof(fn))
+
+/*
+Summary: Calls listener with topmost values of stack as arguments, jumps to error exit when it fails
+Params
+    base: Slot of first argument, result is stored there
+*/
+static void emit_listener_call(Emitter *emitter,
+    TreeListener listener,
+    const Operator *op,
+    size_t num_args,
+    size_t base,
+    size_t instruction)
+{
+    EMIT(emitter, 0x48, 0xBF); // mov rdi, op
+    emit_u64(emitter, (uint64_t)(uintptr_t)op);
+    EMIT(emitter, 0xBE); // mov esi, num_args
+    emit_u32(emitter, (uint32_t)num_args);
+    EMIT(emitter, 0x48, 0x8D, 0x94, 0x24); // lea rdx, [rsp + base]
+    emit_u32(emitter, slot(base));
+    EMIT(emitter, 0x48, 0x8D, 0x8C, 0x24); // lea rcx, [rsp + result_slot]
+    emit_u32(emitter, emitter->result_slot);
+    emit_mov_rax(emitter, FN_ADDRESS(listener));
+    EMIT(emitter, 0xFF, 0xD0); // call rax
+
+    // On error, pass index of instruction in esi and keep error in eax
+    EMIT(emitter, 0x85, 0xC0, 0x0F, 0x84); // test eax, eax; jz over error branch
+    emit_u32(emitter, 10);
+    EMIT(emitter, 0xBE); // mov esi, instruction
+    emit_u32(emitter, (uint32_t)instruction);
+    EMIT(emitter, 0xE9); // jmp error exit
+    size_t error_jump = emit_jump_operand(emitter);
+    vec_push(&emitter->error_jumps, &error_jump);
+
+    emit_sse_stack(emitter, SSE_LOAD, 0, emitter->result_slot);
+    emit_sse_stack(emitter, SSE_STORE, 0, slot(base));
+}
+
+static void emit_binary(Emitter *emitter, uint8_t sse_op, size_t top)
+{
+    emit_sse_stack(emitter, SSE_LOAD, 0, slot(top - 2));
+    emit_sse_stack(emitter, sse_op, 0, slot(top - 1));
+    emit_sse_stack(emitter, SSE_STORE, 0, slot(top - 2));
+}
+
+static void emit_division(Emitter *emitter, TreeListener listener, const Operator *op, size_t top, size_t instruction)
+{
+    emit_sse_stack(emitter, SSE_LOAD, 1, slot(top - 1));
+    EMIT(emitter, 0x66, 0x0F, 0x57, 0xD2); // xorpd xmm2, xmm2
+    EMIT(emitter, 0x66, 0x0F, 0x2E, 0xCA); // ucomisd xmm1, xmm2
+    // Divisor is NaN (parity) or not zero: divide
+    EMIT(emitter, 0x0F, 0x8A);
+    size_t jump_nan = emit_jump_operand(emitter);
+    EMIT(emitter, 0x0F, 0x85);
+    size_t jump_nonzero = emit_jump_operand(emitter);
+
+    // Listener reports division by zero
+    emit_listener_call(emitter, listener, op, 2, top - 2, instruction);
+    EMIT(emitter, 0xE9);
+    size_t jump_done = emit_jump_operand(emitter);
+
+    patch_jump(emitter, jump_nan, code_pos(emitter));
+    patch_jump(emitter, jump_nonzero, code_pos(emitter));
+    emit_sse_stack(emitter, SSE_LOAD, 0, slot(top - 2));
+    EMIT(emitter, 0xF2, 0x0F, SSE_DIV, 0xC1); // divsd xmm0, xmm1
+    emit_sse_stack(emitter, SSE_STORE, 0, slot(top - 2));
+    patch_jump(emitter, jump_done, code_pos(emitter));
+}
+
+static void emit_instruction(Emitter *emitter,
+    const Bytecode *bytecode,
+    TreeListener listener,
+    size_t index,
+    size_t *top)
+{
+    const Instruction *instr = &bytecode->instructions[index];
+    switch ((Opcode)instr->opcode)
+    {
+        case BC_CONST:
+        {
+            uint64_t bits;
+            memcpy(&bits, &bytecode->values[instr->arg], sizeof(bits));
+            emit_mov_rax(emitter, bits);
+            EMIT(emitter, 0x48, 0x89, 0x84, 0x24); // mov [rsp + slot], rax
+            emit_u32(emitter, slot(*top));
+            (*top)++;
+            break;
+        }
+
+        case BC_VAR:
+            EMIT(emitter, 0xF2, 0x0F, SSE_LOAD, 0x83); // movsd xmm0, [rbx + disp32]
+            emit_u32(emitter, slot(instr->arg));
+            emit_sse_stack(emitter, SSE_STORE, 0, slot(*top));
+            (*top)++;
+            break;
+
+        case BC_ADD:
+            emit_binary(emitter, SSE_ADD, *top);
+            (*top)--;
+            break;
+
+        case BC_SUB:
+            emit_binary(emitter, SSE_SUB, *top);
+            (*top)--;
+            break;
+
+        case BC_MUL:
+            emit_binary(emitter, SSE_MUL, *top);
+            (*top)--;
+            break;
+
+        case BC_DIV:
+            emit_division(emitter, listener, bytecode->ops[instr->op], *top, index);
+            (*top)--;
+            break;
+
+        case BC_NEG:
+            emit_sse_stack(emitter, SSE_LOAD, 0, slot(*top - 1));
+            emit_mov_rax(emitter, SIGN_MASK);
+            EMIT(emitter, 0x66, 0x48, 0x0F, 0x6E, 0xC8); // movq xmm1, rax
+            EMIT(emitter, 0x66, 0x0F, 0x57, 0xC1);       // xorpd xmm0, xmm1
+            emit_sse_stack(emitter, SSE_STORE, 0, slot(*top - 1));
+            break;
+
+        case BC_UNARY:
+            emit_sse_stack(emitter, SSE_LOAD, 0, slot(*top - 1));
+            emit_mov_rax(emitter, FN_ADDRESS(bytecode->unary_fns[instr->op]));
+            EMIT(emitter, 0xFF, 0xD0); // call rax
+            emit_sse_stack(emitter, SSE_STORE, 0, slot(*top - 1));
+            break;
+
+        case BC_FUSED:
+            emit_sse_stack(emitter, SSE_LOAD, 0, slot(*top - 1));
+            EMIT(emitter, 0x48, 0x8D, 0xBC, 0x24); // lea rdi, [rsp + slot]
+            emit_u32(emitter, slot(*top - 1));
+            EMIT(emitter, 0x48, 0x8D, 0xB4, 0x24); // lea rsi, [rsp + temp]
+            emit_u32(emitter, slot(emitter->first_temp + instr->arg));
+            emit_mov_rax(emitter, FN_ADDRESS(bytecode->fused_fns[instr->op]));
+            EMIT(emitter, 0xFF, 0xD0); // call rax
+            break;
+
+        case BC_CALL:
+            *top -= instr->arg;
+            emit_listener_call(emitter, listener, bytecode->ops[instr->op], instr->arg, *top, index);
+            (*top)++;
+            break;
+
+        case BC_SHARED:
+        {
+            const SharedCall *call = &bytecode->shared_calls[instr->arg];
+            *top -= call->num_args;
+            EMIT(emitter, 0x48, 0x8D, 0xBC, 0x24); // lea rdi, [rsp + slot]
+            emit_u32(emitter, slot(*top));
+            EMIT(emitter, 0xBE); // mov esi, num_args
+            emit_u32(emitter, call->num_args);
+            EMIT(emitter, 0xBA); // mov edx, selection
+            emit_u32(emitter, call->selection);
+            EMIT(emitter, 0x48, 0x8D, 0x8C, 0x24); // lea rcx, [rsp + temp]
+            emit_u32(emitter, slot(emitter->first_temp + call->temp));
+            emit_mov_rax(emitter, FN_ADDRESS(bytecode->shared_fns[instr->op]));
+            EMIT(emitter, 0xFF, 0xD0); // call rax
+            emit_sse_stack(emitter, SSE_LOAD, 0, slot(emitter->first_temp + call->result));
+            emit_sse_stack(emitter, SSE_STORE, 0, slot(*top));
+            (*top)++;
+            break;
+        }
+
+        case BC_STORE:
+            emit_sse_stack(emitter, SSE_LOAD, 0, slot(*top - 1));
+            emit_sse_stack(emitter, SSE_STORE, 0, slot(emitter->first_temp + instr->arg));
+            break;
+
+        case BC_LOAD:
+            emit_sse_stack(emitter, SSE_LOAD, 0, slot(emitter->first_temp + instr->arg));
+            emit_sse_stack(emitter, SSE_STORE, 0, slot(*top));
+            (*top)++;
+            break;
+    }
+}
+
+static void emit_function(Emitter *emitter, const Bytecode *bytecode, TreeListener listener)
+{
+    // Prologue: After three pushes, rsp is 16-byte aligned as frame size is
+    EMIT(emitter, 0x53, 0x41, 0x54, 0x41, 0x55);        // push rbx; push r12; push r13
+    EMIT(emitter, 0x48, 0x89, 0xFB, 0x49, 0x89, 0xF4);  // mov rbx, rdi; mov r12, rsi
+    EMIT(emitter, 0x49, 0x89, 0xD5, 0x48, 0x81, 0xEC);  // mov r13, rdx; sub rsp, frame_size
+    emit_u32(emitter, emitter->frame_size);
+
+    size_t top = 0;
+    for (size_t i = 0; i < bytecode->num_instructions; i++)
+    {
+        emit_instruction(emitter, bytecode, listener, i, &top);
+    }
+
+    // Success: *out = result, return LISTENERERR_SUCCESS
+    emit_sse_stack(emitter, SSE_LOAD, 0, slot(0));
+    EMIT(emitter, 0xF2, 0x41, 0x0F, SSE_STORE, 0x04, 0x24); // movsd [r12], xmm0
+    EMIT(emitter, 0x31, 0xC0);                              // xor eax, eax
+
+    size_t epilogue = code_pos(emitter);
+    EMIT(emitter, 0x48, 0x81, 0xC4); // add rsp, frame_size
+    emit_u32(emitter, emitter->frame_size);
+    EMIT(emitter, 0x41, 0x5D, 0x41, 0x5C, 0x5B, 0xC3); // pop r13; pop r12; pop rbx; ret
+
+    // Error exit: Error in eax, index of instruction in rsi
+    size_t error_exit = code_pos(emitter);
+    EMIT(emitter, 0x4D, 0x85, 0xED, 0x74, 0x04); // test r13, r13; jz over store
+    EMIT(emitter, 0x49, 0x89, 0x75, 0x00);       // mov [r13], rsi
+    EMIT(emitter, 0xE9);
+    patch_jump(emitter, emit_jump_operand(emitter), epilogue);
+
+    for (size_t i = 0; i < vec_count(&emitter->error_jumps); i++)
+    {
+        patch_jump(emitter, *(size_t*)vec_get(&emitter->error_jumps, i), error_exit);
+    }
+}
+
+bool jit_available()
+{
+    return true;
+}
+
+/*
+Summary: Translates bytecode to machine code, bytecode can be destroyed afterwards
+Params
+    listener: Evaluates operators that are not inlined, baked into code
+Returns: False if code could not be mapped executable, out_code is not initialized in this case
+*/
+bool jit_compile(const Bytecode *bytecode, TreeListener listener, JitCode *out_code)
+{
+    size_t frame_size = slot(bytecode->stack_size + 1 + bytecode->num_temps);
+    Emitter emitter = {
+        .code        = vec_create(sizeof(uint8_t), CODE_STARTSIZE),
+        .error_jumps = vec_create(sizeof(size_t), JUMPS_STARTSIZE),
+        .frame_size  = (uint32_t)((frame_size + 15) & ~(size_t)15),
+        .result_slot = slot(bytecode->stack_size),
+        .first_temp  = bytecode->stack_size + 1
+    };
+    emit_function(&emitter, bytecode, listener);
+
+    size_t size = code_pos(&emitter);
+    void *buffer = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    bool success = buffer != MAP_FAILED;
+    if (success)
+    {
+        memcpy(buffer, emitter.code.buffer, size);
+        success = mprotect(buffer, size, PROT_READ | PROT_EXEC) == 0;
+        if (!success) munmap(buffer, size);
+    }
+    vec_destroy(&emitter.code);
+    vec_destroy(&emitter.error_jumps);
+    if (!success) return false;
+
+    *out_code = (JitCode){
+        .buffer                = buffer,
+        .buffer_size           = size,
+        .num_vars              = bytecode->num_vars,
+        .first_var_instruction = 0
+    };
+    // ISO C does not allow to cast object pointer to function pointer
+    memcpy(&out_code->entry, &buffer, sizeof(out_code->entry));
+    while (out_code->num_vars > 0
+        && bytecode->instructions[out_code->first_var_instruction].opcode != BC_VAR)
+    {
+        out_code->first_var_instruction++;
+    }
+    return true;
+}
+
+void jit_destroy(JitCode *code)
+{
+    munmap(code->buffer, code->buffer_size);
+}
+
+#else
+
+bool jit_available()
+{
+    return false;
+}
+
+bool jit_compile(__attribute__((unused)) const Bytecode *bytecode,
+    __attribute__((unused)) TreeListener listener,
+    __attribute__((unused)) JitCode *out_code)
+{
+    return false;
+}
+
+void jit_destroy(__attribute__((unused)) JitCode *code) { }
+
+#endif
+
+/*
+Summary: Executes compiled code, equivalent to bytecode_run of the bytecode it has been compiled from
+*/
+ListenerError jit_run(const JitCode *code, const double *var_values, double *out, size_t *out_err_instruction)
+{
+    if (var_values == NULL && code->num_vars > 0)
+    {
+        if (out_err_instruction != NULL) *out_err_instruction = code->first_var_instruction;
+        return LISTENERERR_VARIABLE_ENCOUNTERED;
+    }
+    return code->entry(var_values, out, out_err_instruction);
+}
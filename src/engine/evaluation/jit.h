@@ -0,0 +1,28 @@
+#pragma once
+#include <stdbool.h>
+#include "bytecode.h"
+
+/*
+Optional native backend: Translates bytecode to x86-64 machine code in an executable mmap'd buffer.
+Only compiled in with "make JIT=1" (defines USE_JIT) on x86-64, otherwise jit_compile always fails
+and callers keep using bytecode_run.
+Every stack slot of the VM becomes a fixed slot in the native stack frame, so no instruction is dispatched at runtime.
+Inline arithmetic is emitted as SSE2 instructions, unary, fused and shared functions (e.g. sin from libm) are called directly.
+Remaining operators and division by zero call the listener the code has been compiled for,
+whose errors abort evaluation as in bytecode_run.
+*/
+
+typedef ListenerError (*JitEntry)(const double *var_values, double *out, size_t *out_err_instruction);
+
+typedef struct {
+    JitEntry entry;
+    void *buffer;
+    size_t buffer_size;
+    size_t num_vars;
+    size_t first_var_instruction; // Error location when variables are not supplied
+} JitCode;
+
+bool jit_available();
+bool jit_compile(const Bytecode *bytecode, TreeListener listener, JitCode *out_code);
+void jit_destroy(JitCode *code);
+ListenerError jit_run(const JitCode *code, const double *var_values, double *out, size_t *out_err_instruction);
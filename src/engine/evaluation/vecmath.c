@@ -0,0 +1,270 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <float.h>
+#include <math.h>
+#include "vecmath.h"
+
+/*
+Approximations follow fdlibm: Argument reduction with constants split into parts whose products with
+small integers are exact (Cody-Waite), then a minimax polynomial on the reduced interval.
+Kernels only use arithmetic, comparisons and bit operations of vector types, so no lane branches.
+Kernels take pointers since passing vector types to functions changes the ABI between SSE2 and AVX2.
+*/
+
+#if defined(__x86_64__) && defined(__GNUC__)
+    #define DISPATCH __attribute__((target_clones("avx2", "default")))
+#else
+    #define DISPATCH
+#endif
+
+typedef double VDouble __attribute__((vector_size(VECMATH_LANES * sizeof(double))));
+typedef int64_t VInt __attribute__((vector_size(VECMATH_LANES * sizeof(int64_t))));
+typedef uint64_t VBits __attribute__((vector_size(VECMATH_LANES * sizeof(uint64_t)))); // Shifts into sign bit
+
+#define ROUND_MAGIC 6755399441055744.0 // 1.5 * 2^52: Adding it rounds to integer, which ends up in low bits
+#define SPLAT(x)          ((VDouble){ (x), (x), (x), (x) })
+#define SELECT(mask, a, b) ((VDouble)(((mask) & (VInt)(a)) | (~(mask) & (VInt)(b))))
+#define ANY(mask)         (((mask)[0] | (mask)[1] | (mask)[2] | (mask)[3]) != 0)
+
+#define EXP_MAX 708.0 // Results of greater arguments overflow or are subnormal
+
+static const double LN2_HI = 6.93147180369123816490e-01; // Upper 32 bits of ln(2)
+static const double LN2_LO = 1.90821492927058770002e-10;
+static const double LOG2_E = 1.44269504088896338700e+00;
+static const double SQRT_2 = 1.41421356237309514547e+00;
+
+// Coefficients of log(1+f) = f - f^2/2 + s*(f^2/2 + R(s^2)), s = f/(2+f)
+static const double LG1 = 6.666666666666735130e-01;
+static const double LG2 = 3.999999999940941908e-01;
+static const double LG3 = 2.857142874366239149e-01;
+static const double LG4 = 2.222219843214978396e-01;
+static const double LG5 = 1.818357216161805012e-01;
+static const double LG6 = 1.531383769920937332e-01;
+static const double LG7 = 1.479819860511658591e-01;
+
+#define SINCOS_MAX 524288.0 // 2^19, multiples of pi/2 up to this are exact with three 33-bit parts
+
+static const double TWO_OVER_PI = 6.36619772367581382433e-01;
+static const double PIO2_1      = 1.57079632673412561417e+00; // First 33 bits of pi/2
+static const double PIO2_2      = 6.07710050630396597660e-11; // Second 33 bits
+static const double PIO2_3      = 2.02226624871116645580e-21; // Third 33 bits
+static const double PIO2_3T     = 8.47842766036889956997e-32; // pi/2 - (PIO2_1 + PIO2_2 + PIO2_3)
+
+// sin(r) = r + r^3*S(r^2) and cos(r) = 1 - r^2/2 + r^4*C(r^2) for |r| <= pi/4
+static const double S1 = -1.66666666666666324348e-01;
+static const double S2 =  8.33333333332248946124e-03;
+static const double S3 = -1.98412698298579493134e-04;
+static const double S4 =  2.75573137070700676789e-06;
+static const double S5 = -2.50507602534068634195e-08;
+static const double S6 =  1.58969099521155010221e-10;
+static const double C1 =  4.16666666666666019037e-02;
+static const double C2 = -1.38888888888741095749e-03;
+static const double C3 =  2.48015872894767294178e-05;
+static const double C4 = -2.75573143513906633035e-07;
+static const double C5 =  2.08757232129817482790e-09;
+static const double C6 = -1.13596475577881948265e-11;
+
+// Recomputes lanes whose argument does not satisfy in_range by libm
+#define FALLBACK(values, args, in_range, fn) \
+    do { \
+        if (ANY(~(in_range))) \
+        { \
+            for (size_t lane = 0; lane < VECMATH_LANES; lane++) \
+            { \
+                if (!(in_range)[lane]) values[lane] = fn(args[lane]); \
+            } \
+        } \
+    } while (0)
+
+// Defines function that applies kernel to VECMATH_LANES values at a time, last values are padded
+#define DEFINE_VECTORIZED(name, kernel, pad) \
+    DISPATCH void name(double *values, size_t num_values) \
+    { \
+        size_t i = 0; \
+        for (; i + VECMATH_LANES <= num_values; i += VECMATH_LANES) kernel(values + i); \
+        if (i < num_values) \
+        { \
+            double tail[VECMATH_LANES] = { pad, pad, pad, pad }; \
+            memcpy(tail, values + i, (num_values - i) * sizeof(double)); \
+            kernel(tail); \
+            memcpy(values + i, tail, (num_values - i) * sizeof(double)); \
+        } \
+    }
+
+#define KERNEL static inline __attribute__((always_inline)) void
+
+KERNEL exp_kernel(double *values)
+{
+    VDouble x;
+    memcpy(&x, values, sizeof(x));
+
+    // x = n*ln(2) + r, |r| <= ln(2)/2
+    VDouble t = x * LOG2_E + ROUND_MAGIC;
+    VDouble n = t - ROUND_MAGIC;
+    VInt n_int = (VInt)t - (VInt)SPLAT(ROUND_MAGIC);
+    VDouble r = (x - n * LN2_HI) - n * LN2_LO;
+
+    // Taylor polynomial of degree 13, remainder below 2^-60
+    VDouble p = SPLAT(1.0 / 6227020800.0);
+    p = p * r + 1.0 / 479001600.0;
+    p = p * r + 1.0 / 39916800.0;
+    p = p * r + 1.0 / 3628800.0;
+    p = p * r + 1.0 / 362880.0;
+    p = p * r + 1.0 / 40320.0;
+    p = p * r + 1.0 / 5040.0;
+    p = p * r + 1.0 / 720.0;
+    p = p * r + 1.0 / 120.0;
+    p = p * r + 1.0 / 24.0;
+    p = p * r + 1.0 / 6.0;
+    p = p * r + 0.5;
+    p = p * (r * r) + r;
+
+    // Multiply by 2^n by constructing its exponent
+    VDouble scale = (VDouble)((VBits)(n_int + 1023) << 52);
+    VDouble res = scale + scale * p;
+
+    VInt in_range = (x >= -EXP_MAX) & (x <= EXP_MAX);
+    memcpy(values, &res, sizeof(res));
+    FALLBACK(values, x, in_range, exp);
+}
+
+KERNEL log_kernel(double *values)
+{
+    VDouble x;
+    memcpy(&x, values, sizeof(x));
+
+    // x = 2^k * (1+f), sqrt(2)/2 <= 1+f < sqrt(2)
+    VInt bits = (VInt)x;
+    VInt k = ((bits >> 52) & 0x7ff) - 1023;
+    VDouble m = (VDouble)((bits & 0x000fffffffffffff) | 0x3ff0000000000000);
+    VInt above = m > SQRT_2;
+    m = SELECT(above, m * 0.5, m);
+    k -= above;
+    VDouble dk = (VDouble)(k + (VInt)SPLAT(ROUND_MAGIC)) - ROUND_MAGIC;
+
+    VDouble f = m - 1;
+    VDouble s = f / (2 + f);
+    VDouble z = s * s;
+    VDouble w = z * z;
+    VDouble t1 = w * (LG2 + w * (LG4 + w * LG6));
+    VDouble t2 = z * (LG1 + w * (LG3 + w * (LG5 + w * LG7)));
+    VDouble half_f2 = 0.5 * f * f;
+    VDouble res = dk * LN2_HI - ((half_f2 - (s * (half_f2 + t1 + t2) + dk * LN2_LO)) - f);
+
+    // Excludes zero, negative, subnormal and non-finite arguments
+    VInt in_range = (x >= DBL_MIN) & (x <= DBL_MAX);
+    memcpy(values, &res, sizeof(res));
+    FALLBACK(values, x, in_range, log);
+}
+
+/*
+Summary: Computes sin and cos of four values, cos(x) = sin(x + pi/2) is realized by shifting the quadrant
+Params
+    out_sin, out_cos: May be NULL or the same as values
+*/
+KERNEL sincos_kernel(const double *values, double *out_sin, double *out_cos)
+{
+    VDouble x;
+    memcpy(&x, values, sizeof(x));
+
+    // x = n*pi/2 + r, |r| <= pi/4
+    VDouble t = x * TWO_OVER_PI + ROUND_MAGIC;
+    VDouble n = t - ROUND_MAGIC;
+    VInt quadrant = (VInt)t - (VInt)SPLAT(ROUND_MAGIC);
+    VDouble r = (((x - n * PIO2_1) - n * PIO2_2) - n * PIO2_3) - n * PIO2_3T;
+
+    VDouble z = r * r;
+    VDouble sin_r = r + (z * r) * (S1 + z * (S2 + z * (S3 + z * (S4 + z * (S5 + z * S6)))));
+    VDouble half_z = 0.5 * z;
+    VDouble one_minus = 1 - half_z;
+    VDouble cos_r = one_minus
+        + (((1 - one_minus) - half_z) + z * z * (C1 + z * (C2 + z * (C3 + z * (C4 + z * (C5 + z * C6))))));
+
+    // Zero keeps its sign only with libm
+    VInt in_range = (x >= -SINCOS_MAX) & (x <= SINCOS_MAX) & (x != 0);
+
+    // Odd quadrants use cos, the third and fourth are negated
+    if (out_sin != NULL)
+    {
+        VDouble res = SELECT((quadrant & 1) != 0, cos_r, sin_r);
+        res = (VDouble)((VBits)res ^ ((VBits)(quadrant & 2) << 62));
+        memcpy(out_sin, &res, sizeof(res));
+        FALLBACK(out_sin, x, in_range, sin);
+    }
+    if (out_cos != NULL)
+    {
+        quadrant += 1;
+        VDouble res = SELECT((quadrant & 1) != 0, cos_r, sin_r);
+        res = (VDouble)((VBits)res ^ ((VBits)(quadrant & 2) << 62));
+        memcpy(out_cos, &res, sizeof(res));
+        FALLBACK(out_cos, x, in_range, cos);
+    }
+}
+
+KERNEL sin_kernel(double *values)
+{
+    sincos_kernel(values, values, NULL);
+}
+
+KERNEL cos_kernel(double *values)
+{
+    sincos_kernel(values, NULL, values);
+}
+
+DEFINE_VECTORIZED(vecmath_exp, exp_kernel, 0)
+DEFINE_VECTORIZED(vecmath_log, log_kernel, 1)
+DEFINE_VECTORIZED(vecmath_sin, sin_kernel, 0)
+DEFINE_VECTORIZED(vecmath_cos, cos_kernel, 0)
+
+/*
+Summary: Computes sin and cos of the same values at once, argument reduction is shared
+Params
+    values: Replaced by their sine
+*/
+DISPATCH void vecmath_sincos(double *values, double *out_cos, size_t num_values)
+{
+    size_t i = 0;
+    for (; i + VECMATH_LANES <= num_values; i += VECMATH_LANES) sincos_kernel(values + i, values + i, out_cos + i);
+    if (i < num_values)
+    {
+        double tail[VECMATH_LANES] = { 0 };
+        double tail_cos[VECMATH_LANES];
+        memcpy(tail, values + i, (num_values - i) * sizeof(double));
+        sincos_kernel(tail, tail, tail_cos);
+        memcpy(values + i, tail, (num_values - i) * sizeof(double));
+        memcpy(out_cos + i, tail_cos, (num_values - i) * sizeof(double));
+    }
+}
+
+/*
+Summary: Like vecmath_sincos, values are replaced by their cosine
+*/
+DISPATCH void vecmath_cossin(double *values, double *out_sin, size_t num_values)
+{
+    size_t i = 0;
+    for (; i + VECMATH_LANES <= num_values; i += VECMATH_LANES) sincos_kernel(values + i, out_sin + i, values + i);
+    if (i < num_values)
+    {
+        double tail[VECMATH_LANES] = { 0 };
+        double tail_sin[VECMATH_LANES];
+        memcpy(tail, values + i, (num_values - i) * sizeof(double));
+        sincos_kernel(tail, tail_sin, tail);
+        memcpy(values + i, tail, (num_values - i) * sizeof(double));
+        memcpy(out_sin + i, tail_sin, (num_values - i) * sizeof(double));
+    }
+}
+
+/*
+Returns: Instruction set the vectorized functions run on
+*/
+const char *vecmath_get_isa()
+{
+#if defined(__x86_64__) && defined(__GNUC__)
+    return __builtin_cpu_supports("avx2") ? "AVX2" : "SSE2";
+#elif defined(__x86_64__)
+    return "SSE2";
+#else
+    return "generic";
+#endif
+}
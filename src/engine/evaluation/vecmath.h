@@ -0,0 +1,26 @@
+#pragma once
+#include <stddef.h>
+
+/*
+Vectorized elementary functions for batch evaluation, applied in place to arrays of values.
+Each function computes VECMATH_LANES values at once with branch-free polynomial approximations
+(GCC vector extensions). On x86-64, an AVX2 variant is selected at load time when the CPU supports it,
+otherwise SSE2 is used. Arguments outside of the range of an approximation (NaN, infinities, subnormal
+results, large arguments of sin and cos) are computed by libm, so results only differ from libm in rounding.
+
+Maximum error, measured against glibc on 10^7 random arguments per range:
+    vecmath_exp  |x| <= 708                1 ULP
+    vecmath_log  normal x > 0              1 ULP
+    vecmath_sin  |x| <= 2^19               2 ULP (1 ULP for |x| <= 4)
+    vecmath_cos  |x| <= 2^19               2 ULP (1 ULP for |x| <= 4)
+*/
+
+#define VECMATH_LANES 4
+
+void vecmath_exp(double *values, size_t num_values);
+void vecmath_log(double *values, size_t num_values);
+void vecmath_sin(double *values, size_t num_values);
+void vecmath_cos(double *values, size_t num_values);
+void vecmath_sincos(double *values, double *out_cos, size_t num_values);
+void vecmath_cossin(double *values, double *out_sin, size_t num_values);
+const char *vecmath_get_isa();
@@ -121,6 +121,22 @@ bool ctx_delete_op(ParsingContext *ctx, const char *name, OpPlacement placement)
     }    
 }
 
+/*
+Summary: Attaches traits to all operators of context
+Params
+    get_traits: Called for every operator, returns its new traits (may be NULL)
+*/
+void ctx_set_traits(ParsingContext *ctx, const OpTraits *(*get_traits)(const Operator *op))
+{
+    ListNode *curr = ctx->op_list.first;
+    while (curr != NULL)
+    {
+        Operator *op = (Operator*)listnode_get_data(curr);
+        op->traits = get_traits(op);
+        curr = listnode_get_next(curr);
+    }
+}
+
 /*
 Summary: Sets glue-op, which is inserted between two subexpressions (such as 2a -> 2*a)
 Returns: False, if ctx is NULL or operator with arity not equal to 2 or DYNAMIC_ARITY given
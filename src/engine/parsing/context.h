@@ -18,4 +18,5 @@ bool ctx_add_ops(ParsingContext *ctx, size_t count, ...);
 const Operator *ctx_add_op(ParsingContext *ctx, Operator op);
 bool ctx_delete_op(ParsingContext *ctx, const char *name, OpPlacement placement);
 bool ctx_set_glue_op(ParsingContext *ctx, const Operator *op);
+void ctx_set_traits(ParsingContext *ctx, const OpTraits *(*get_traits)(const Operator *op));
 const Operator *ctx_lookup_op(const ParsingContext *ctx, const char *name, OpPlacement placement);
@@ -5,6 +5,7 @@
 
 #include "matching.h"
 #include "transformation.h"
+#include "../tree/tree_traversal.h"
 #include "../tree/tree_util.h"
 #include "../tree/tree_to_string.h"
 #include "../../util/vector.h"
@@ -72,6 +73,21 @@ static void fill_suffix(
     curr->num_matchings = vec_count(matchings) - curr->first_match_index;
 }
 
+/*
+Summary: Cheap pre-check to prune partitions early.
+    A variable that has been bound before can only be mapped to an equal node, compare cached hashes.
+Returns: False if tree_child can not be mapped to pattern_child
+*/
+static bool may_be_equal_to_bound(const Matching *matching, const Node *pattern_child, const Node *tree_child)
+{
+    if (get_type(pattern_child) != NTYPE_VARIABLE) return true;
+    const NodeList *bound = &matching->mapped_nodes[get_id(pattern_child)];
+    if (bound->nodes == NULL) return true;
+    if (bound->size != 1) return false;
+    // Computing an uncached hash would take as long as comparing the trees
+    return !has_info(bound->nodes[0]) || !has_info(tree_child) || get_hash(bound->nodes[0]) == get_hash(tree_child);
+}
+
 static void match_parameter_lists(
     MatchingContext *ctx,
     Matching matching,
@@ -175,7 +191,8 @@ static void match_parameter_lists(
             }
             else
             {
-                if (new_sum < num_tree_children)
+                if (new_sum < num_tree_children
+                    && may_be_equal_to_bound(&matching, pattern_children[curr.distance], tree_children[new_sum]))
                 {
                     // Any non-list node in pattern corresponds to exactly one node in tree
                     VEC_PUSH_ELEM(&vec_suffixes, SuffixNode, ((SuffixNode){
@@ -348,21 +365,48 @@ bool get_matching(const Node **tree, const Pattern *pattern, ConstraintChecker c
     }
 }
 
-/*
-Summary: Looks for matching in tree, i.e. suffixess to construct matching in each node until matching is found (Top-Down)
-*/
-Node **find_matching(const Node **tree, const Pattern *pattern, ConstraintChecker checker, Matching *out_matching)
+struct MatchingSearch {
+    const Pattern *pattern;
+    ConstraintChecker checker;
+    Matching *out_matching;
+    Node **result;
+};
+
+static TraversalAction find_matching_pre(Node **node, Traversal *traversal, void *state)
 {
-    if (get_matching(tree, pattern, checker, out_matching)) return (Node**)tree;
-    if (get_type(*tree) == NTYPE_OPERATOR)
+    struct MatchingSearch *search = state;
+    // Skip subtrees that do not contain operator of pattern
+    if (get_type(search->pattern->pattern) == NTYPE_OPERATOR
+        && (get_info(*node).op_mask & OP_MASK_BIT(get_op(search->pattern->pattern))) == 0)
     {
-        for (size_t i = 0; i < get_num_children(*tree); i++)
-        {
-            Node **res = find_matching((const Node**)get_child_addr(*tree, i), pattern, checker, out_matching);
-            if (res != NULL) return res;
-        }
+        return TRAVERSAL_SKIP;
     }
-    return NULL;
+
+    if (get_matching((const Node**)node, search->pattern, search->checker, search->out_matching))
+    {
+        search->result = node;
+        traversal_invalidate_ancestors(traversal);
+        return TRAVERSAL_STOP;
+    }
+    return TRAVERSAL_CONTINUE;
+}
+
+/*
+Summary: Looks for matching in tree, i.e. suffixess to construct matching in each node until matching is found (Top-Down).
+    Infos of tree are cached to skip subtrees, infos of ancestors of the matched subtree are invalidated
+    since callers replace it.
+*/
+Node **find_matching(Node **tree, const Pattern *pattern, ConstraintChecker checker, Matching *out_matching)
+{
+    struct MatchingSearch search = {
+        .pattern      = pattern,
+        .checker      = checker,
+        .out_matching = out_matching,
+        .result       = NULL
+    };
+    update_info(*tree);
+    tree_traverse(tree, find_matching_pre, NULL, &search);
+    return search.result;
 }
 
 /*
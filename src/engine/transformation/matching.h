@@ -29,7 +29,7 @@ typedef bool (*ConstraintChecker)(Node **tree);
 NodeList *lookup_mapped_var(const Matching *matching, const char *var);
 size_t get_all_matchings(const Node **tree, const Pattern *pattern, ConstraintChecker checker, Matching **out_matchings);
 bool get_matching(const Node **tree, const Pattern *pattern, ConstraintChecker checker, Matching *out_matching);
-Node **find_matching(const Node **tree, const Pattern *pattern, ConstraintChecker checker, Matching *out_matching);
+Node **find_matching(Node **tree, const Pattern *pattern, ConstraintChecker checker, Matching *out_matching);
 
 int get_pattern(Node *tree, size_t num_constraints, Node **constrs, Pattern *out_pattern);
 void free_pattern(Pattern *pattern);
@@ -1,15 +1,61 @@
 #include <string.h>
 #include <stdio.h>
+#include <stdint.h>
 
 #include "../../util/string_util.h"
 #include "../../util/console_util.h"
 #include "../../util/alloc_wrappers.h"
+#include "../tree/tree_traversal.h"
 #include "../tree/tree_util.h"
 #include "../tree/tree_to_string.h"
 #include "rewrite_rule.h"
 #include "transformation.h"
 #include "matching.h"
 
+// Attaches number of results that are pending when node is instantiated, i.e. results of left siblings of node and its ancestors
+static TraversalAction compile_pre(__attribute__((unused)) Node **node,
+    Traversal *traversal,
+    __attribute__((unused)) void *state)
+{
+    uintptr_t num_pending = (uintptr_t)traversal_get_parent_data(traversal) + traversal_index(traversal);
+    traversal_set_data(traversal, (void*)num_pending);
+    return TRAVERSAL_CONTINUE;
+}
+
+// Appends instruction for node, its children have been appended before
+static TraversalAction compile_post(Node **node, Traversal *traversal, void *state)
+{
+    RewriteRule *rule = state;
+    PlanInstruction instr = { .type = get_type(*node) };
+    switch (get_type(*node))
+    {
+        case NTYPE_OPERATOR:
+            instr.op = get_op(*node);
+            instr.num_children = get_num_children(*node);
+            break;
+        case NTYPE_CONSTANT:
+            instr.value = get_const_value(*node);
+            break;
+        case NTYPE_VARIABLE:
+            instr.id = get_id(*node);
+            break;
+    }
+    rule->plan[rule->plan_size++] = instr;
+
+    size_t num_pending = (uintptr_t)traversal_get_data(traversal) + 1;
+    if (num_pending > rule->plan_stack_size) rule->plan_stack_size = num_pending;
+    return TRAVERSAL_CONTINUE;
+}
+
+// Precomputes how the right-hand side is instantiated by apply_rule, IDs of variables need to be set
+static void compile_plan(RewriteRule *rule)
+{
+    rule->plan_size = 0;
+    rule->plan = malloc_wrapper(get_info(rule->after).num_nodes * sizeof(PlanInstruction));
+    rule->plan_stack_size = 0;
+    tree_traverse(&rule->after, compile_pre, compile_post, rule);
+}
+
 /*
 Summary: Constructs new rule. Warning: "before" and "after" are not copied, so don't free them!
 */
@@ -46,6 +92,7 @@ bool get_rule(Pattern pattern, Node *after, RewriteRule *out_rule)
         .pattern = pattern,
         .after  = after,
     };
+    compile_plan(out_rule);
     return true;
 }
 
@@ -56,19 +103,141 @@ void free_rule(RewriteRule *rule)
 {
     free_pattern(&(rule->pattern));
     free_tree(rule->after);
+    free(rule->plan);
+}
+
+static int compare_addresses(const void *a, const void *b)
+{
+    uintptr_t x = (uintptr_t)*(const Node * const *)a;
+    uintptr_t y = (uintptr_t)*(const Node * const *)b;
+    return (x > y) - (x < y);
+}
+
+typedef struct {
+    size_t num_moved;
+    const Node **moved; // Sorted by address
+} MovedNodes;
+
+static TraversalAction free_unmoved_pre(Node **node, __attribute__((unused)) Traversal *traversal, void *state)
+{
+    // Moved subtrees belong to the result of the transformation now
+    MovedNodes *moved = state;
+    if (bsearch(node, moved->moved, moved->num_moved, sizeof(Node*), compare_addresses) != NULL)
+    {
+        return TRAVERSAL_SKIP;
+    }
+    return TRAVERSAL_CONTINUE;
+}
+
+static TraversalAction free_unmoved_post(Node **node,
+    __attribute__((unused)) Traversal *traversal,
+    __attribute__((unused)) void *state)
+{
+    free_node(*node);
+    return TRAVERSAL_CONTINUE;
+}
+
+// Frees matched subtree except bound subtrees that have been moved into the transformed tree
+static void free_matched_subtree(Node *matched_subtree, const Matching *matching, const bool *moved)
+{
+    MovedNodes moved_nodes = { .num_moved = 0 };
+    for (size_t i = 0; i < MAX_MAPPED_VARS; i++)
+    {
+        if (moved[i]) moved_nodes.num_moved += matching->mapped_nodes[i].size;
+    }
+
+    if (moved_nodes.num_moved == 0)
+    {
+        free_tree(matched_subtree);
+        return;
+    }
+
+    moved_nodes.moved = malloc_wrapper(moved_nodes.num_moved * sizeof(Node*));
+    size_t num_collected = 0;
+    for (size_t i = 0; i < MAX_MAPPED_VARS; i++)
+    {
+        if (!moved[i]) continue;
+        for (size_t j = 0; j < matching->mapped_nodes[i].size; j++)
+        {
+            moved_nodes.moved[num_collected++] = matching->mapped_nodes[i].nodes[j];
+        }
+    }
+    qsort(moved_nodes.moved, moved_nodes.num_moved, sizeof(Node*), compare_addresses);
+    tree_traverse(&matched_subtree, free_unmoved_pre, free_unmoved_post, &moved_nodes);
+    free(moved_nodes.moved);
 }
 
-// Needed to preserve error information
-void set_tok_index_for_all(Node *tree, size_t index)
+#define LOCAL_STACK_SIZE 64 // Instantiations with stacks up to this size do not need to allocate
+
+/*
+Summary: Builds right-hand side of rule for matching in one pass, see PlanInstruction.
+    Every node is allocated with its final number of children.
+    Bound subtrees are moved on the first occurrence of their variable, copied on further occurrences.
+Params
+    tok_index: Token index of every new node, bound subtrees keep theirs
+    out_moved: Array of size MAX_MAPPED_VARS, initialized to false.
+        out_moved[id] is set to true when the bound subtrees of the variable have been moved into the result.
+*/
+static Node *instantiate(const RewriteRule *rule, const Matching *matching, size_t tok_index, bool *out_moved)
 {
-    set_token_index(tree, index);
-    if (get_type(tree) == NTYPE_OPERATOR)
+    // Every instruction pushes its number of nodes, every node is pushed to the node stack
+    size_t node_stack_size = rule->plan_stack_size;
+    for (size_t i = 0; i < rule->plan_size; i++)
     {
-        for (size_t i = 0; i < get_num_children(tree); i++)
+        if (rule->plan[i].type == NTYPE_VARIABLE) node_stack_size += matching->mapped_nodes[rule->plan[i].id].size;
+    }
+    size_t local_counts[LOCAL_STACK_SIZE];
+    Node *local_nodes[LOCAL_STACK_SIZE];
+    size_t *counts = rule->plan_stack_size <= LOCAL_STACK_SIZE
+        ? local_counts
+        : malloc_wrapper(rule->plan_stack_size * sizeof(size_t));
+    Node **nodes = node_stack_size <= LOCAL_STACK_SIZE
+        ? local_nodes
+        : malloc_wrapper(node_stack_size * sizeof(Node*));
+    size_t counts_top = 0;
+    size_t nodes_top = 0;
+
+    for (size_t i = 0; i < rule->plan_size; i++)
+    {
+        const PlanInstruction *instr = &rule->plan[i];
+        switch (instr->type)
         {
-            set_tok_index_for_all(get_child(tree, i), index);
+            case NTYPE_OPERATOR:
+            {
+                size_t num_children = 0;
+                for (size_t j = 0; j < instr->num_children; j++) num_children += counts[--counts_top];
+                Node *node = malloc_operator_node(instr->op, num_children, tok_index);
+                nodes_top -= num_children;
+                for (size_t j = 0; j < num_children; j++) set_child(node, j, nodes[nodes_top + j]);
+                nodes[nodes_top++] = node;
+                counts[counts_top++] = 1;
+                break;
+            }
+
+            case NTYPE_CONSTANT:
+                nodes[nodes_top++] = malloc_constant_node(instr->value, tok_index);
+                counts[counts_top++] = 1;
+                break;
+
+            case NTYPE_VARIABLE:
+            {
+                NodeList bound = matching->mapped_nodes[instr->id];
+                for (size_t j = 0; j < bound.size; j++)
+                {
+                    nodes[nodes_top++] = out_moved[instr->id] ? tree_copy(bound.nodes[j]) : (Node*)bound.nodes[j];
+                }
+                out_moved[instr->id] = true;
+                counts[counts_top++] = bound.size;
+                break;
+            }
         }
     }
+
+    if (nodes_top != 1) software_defect("Trying to replace root with a list != 1.\n");
+    Node *res = nodes[0];
+    if (counts != local_counts) free(counts);
+    if (nodes != local_nodes) free(nodes);
+    return res;
 }
 
 /*
@@ -81,14 +250,16 @@ bool apply_rule(Node **tree, const RewriteRule *rule, ConstraintChecker checker)
 {
     Matching matching;
     // Try to find matching in tree with pattern specified in rule
-    Node **matched_subtree = find_matching((const Node**)tree, &rule->pattern, checker, &matching);
+    Node **matched_subtree = find_matching(tree, &rule->pattern, checker, &matching);
     if (matched_subtree == NULL) return false;
     // If matching is found, transform tree with it
-    Node *transformed = tree_copy(rule->after);
     // Every new node in rhs of rule emerged from root of matched subtree
-    set_tok_index_for_all(transformed, get_token_index(*matched_subtree));
-    transform_by_matching(&matching, &transformed);
-    tree_replace(matched_subtree, transformed);
+    // Bound subtrees are moved from the matched subtree instead of being copied, since it is freed anyway
+    bool moved[MAX_MAPPED_VARS] = { false };
+    Node *transformed = instantiate(rule, &matching, get_token_index(*matched_subtree), moved);
+    invalidate_info(*matched_subtree);
+    free_matched_subtree(*matched_subtree, &matching, moved);
+    *matched_subtree = transformed;
 
     return true;
 }
@@ -4,10 +4,27 @@
 #include "../../util/iterator.h"
 #include "../tree/node.h"
 
+/*
+Instruction of an instantiation plan: The right-hand side of a rule in post-order.
+An operator takes the nodes produced by its num_children preceding sibling instructions as children,
+a variable produces all nodes bound to it, thus the arity of an operator is only known when instantiated.
+*/
+typedef struct
+{
+    NodeType type;
+    const Operator *op;  // Operators only
+    size_t num_children; // Operators: Number of children in rule, list variables count as one
+    double value;        // Constants only
+    size_t id;           // Variables only
+} PlanInstruction;
+
 typedef struct
 {
     Pattern pattern;
     Node *after;
+    size_t plan_size;
+    PlanInstruction *plan;
+    size_t plan_stack_size; // Maximum number of instructions whose results are not consumed yet
 } RewriteRule;
 
 bool get_rule(Pattern pattern, Node *after, RewriteRule *out_rule);
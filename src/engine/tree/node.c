@@ -1,17 +1,24 @@
 #include <string.h>
+#include <stdint.h>
 #include "../../util/alloc_wrappers.h"
 #include "../../util/console_util.h"
+#include "../../util/vector.h"
+#include "tree_traversal.h"
 #include "node.h"
 
+#define NODE_FLAG_ARENA 1 // Node is owned by an arena and must not be freed individually
+#define NODE_FLAG_INFO  2 // Operator node holds valid info of its subtree, see update_info
+
 struct Node {
-    NodeType type;
+    unsigned char type;
+    unsigned char flags;
     size_t token_index;
 };
 
 typedef struct {
     Node base;
     size_t id; // For easier lookup
-    char var_name[];
+    Symbol symbol;
 } VariableNode;
 
 typedef struct {
@@ -23,27 +30,193 @@ typedef struct {
     Node base;
     const Operator *op;  // Points to operator in context
     size_t num_children; // Size of children buffer
+    NodeInfo info;       // Only valid with NODE_FLAG_INFO, leaves compute their info on the fly
     Node *children[];
 } OperatorNode;
 
+// Freed node, linked into the free list of its size class
+typedef struct FreeSlot {
+    struct FreeSlot *next;
+} FreeSlot;
+
+#define RECYCLE_MAX_CACHED   4096 // Maximum number of nodes kept per size class, further nodes are released
+#define INFO_STACK_STARTSIZE 16
+
+static Arena *node_arena = NULL;
+static NodeAllocStats alloc_stats = { 0 };
+static bool recycling = true;
+static FreeSlot *free_lists[NODE_NUM_CLASSES] = { NULL };
+static FreeSlot *arena_free_lists[NODE_NUM_CLASSES] = { NULL }; // Freed nodes of current arena, never trimmed
+static size_t num_cached[NODE_NUM_CLASSES] = { 0 };
+
+static NodeSizeClass get_size_class(NodeType type, size_t num_children)
+{
+    switch (type)
+    {
+        case NTYPE_CONSTANT:
+            return NODE_CLASS_CONSTANT;
+        case NTYPE_VARIABLE:
+            return NODE_CLASS_VARIABLE;
+        case NTYPE_OPERATOR:
+            return num_children <= 3 ? NODE_CLASS_OP_0 + num_children : NODE_CLASS_OP_N;
+    }
+    return NODE_CLASS_OP_N;
+}
+
+// Nodes of a size class are interchangeable since they are allocated with the same size
+static size_t get_slot_size(NodeType type, size_t num_children)
+{
+    switch (type)
+    {
+        case NTYPE_CONSTANT:
+            return sizeof(ConstantNode);
+        case NTYPE_VARIABLE:
+            return sizeof(VariableNode);
+        case NTYPE_OPERATOR:
+            if (num_children > 3 && num_children <= NODE_RECYCLE_MAX_CHILDREN) num_children = NODE_RECYCLE_MAX_CHILDREN;
+            return sizeof(OperatorNode) + num_children * sizeof(Node*);
+    }
+    return 0;
+}
+
+static bool is_recyclable(NodeType type, size_t num_children)
+{
+    return type != NTYPE_OPERATOR || num_children <= NODE_RECYCLE_MAX_CHILDREN;
+}
+
+static void *alloc_node(NodeType type, size_t num_children)
+{
+    Node *res;
+    if (node_arena != NULL)
+    {
+        NodeSizeClass size_class = get_size_class(type, num_children);
+        if (arena_free_lists[size_class] != NULL && is_recyclable(type, num_children))
+        {
+            res = (Node*)arena_free_lists[size_class];
+            arena_free_lists[size_class] = arena_free_lists[size_class]->next;
+            alloc_stats.arena_recycled++;
+        }
+        else
+        {
+            res = arena_alloc(node_arena, get_slot_size(type, num_children));
+        }
+        res->flags = NODE_FLAG_ARENA;
+        alloc_stats.arena_allocs++;
+    }
+    else
+    {
+        NodeSizeClass size_class = get_size_class(type, num_children);
+        if (free_lists[size_class] != NULL && is_recyclable(type, num_children))
+        {
+            res = (Node*)free_lists[size_class];
+            free_lists[size_class] = free_lists[size_class]->next;
+            num_cached[size_class]--;
+            alloc_stats.cached--;
+            alloc_stats.recycled++;
+            alloc_stats.class_recycled[size_class]++;
+        }
+        else
+        {
+            res = malloc_wrapper(get_slot_size(type, num_children));
+        }
+        res->flags = 0;
+        alloc_stats.heap_allocs++;
+        alloc_stats.class_allocs[size_class]++;
+        alloc_stats.live++;
+        if (alloc_stats.live > alloc_stats.peak_live) alloc_stats.peak_live = alloc_stats.live;
+    }
+    res->type = type;
+    return res;
+}
+
+/*
+Summary: Subsequently created nodes are allocated in given arena, or on the heap when NULL.
+    Nodes owned by an arena are released by arena_reset. As long as their arena is set,
+    freed arena nodes are kept for reuse by later allocations in it, otherwise free_tree ignores them.
+    Thus, a tree allocated in an arena must not contain heap-allocated subtrees. To keep
+    a result beyond the reset, tree_copy it after arena allocation has been switched off.
+*/
+void node_set_arena(Arena *arena)
+{
+    if (arena != node_arena)
+    {
+        // Freed nodes belong to the previous arena, which might be reset from now on
+        for (size_t i = 0; i < NODE_NUM_CLASSES; i++) arena_free_lists[i] = NULL;
+    }
+    node_arena = arena;
+}
+
+Arena *node_get_arena()
+{
+    return node_arena;
+}
+
+/*
+Summary: Recycling of freed heap nodes is enabled by default.
+    Disabling it releases all cached nodes, subsequent nodes are allocated and freed individually.
+*/
+void node_set_recycling(bool enabled)
+{
+    recycling = enabled;
+    if (!recycling) node_trim_free_lists();
+}
+
+/*
+Summary: Releases nodes kept for reuse to the system allocator
+*/
+void node_trim_free_lists()
+{
+    for (size_t i = 0; i < NODE_NUM_CLASSES; i++)
+    {
+        while (free_lists[i] != NULL)
+        {
+            FreeSlot *next = free_lists[i]->next;
+            free(free_lists[i]);
+            free_lists[i] = next;
+        }
+        num_cached[i] = 0;
+    }
+    alloc_stats.cached = 0;
+}
+
+NodeAllocStats node_get_alloc_stats()
+{
+    return alloc_stats;
+}
+
+/*
+Summary: Resets counters, the number of live and cached nodes is kept
+*/
+void node_reset_alloc_stats()
+{
+    alloc_stats = (NodeAllocStats){
+        .live      = alloc_stats.live,
+        .peak_live = alloc_stats.live,
+        .cached    = alloc_stats.cached
+    };
+}
+
 /*
 The following functions are used for polymorphism of different Node types
 */
 
 Node *malloc_variable_node(const char *var_name, size_t id, size_t tok_index)
 {
-    VariableNode *res = malloc_wrapper(sizeof(VariableNode) + (strlen(var_name) + 1) * sizeof(char));
-    res->base.type = NTYPE_VARIABLE;
+    return malloc_symbol_node(symbol_intern(var_name), id, tok_index);
+}
+
+Node *malloc_symbol_node(Symbol symbol, size_t id, size_t tok_index)
+{
+    VariableNode *res = alloc_node(NTYPE_VARIABLE, 0);
     res->base.token_index = tok_index;
     res->id = id;
-    strcpy(res->var_name, var_name);
+    res->symbol = symbol;
     return (Node*)res;
 }
 
 Node *malloc_constant_node(double value, size_t tok_index)
 {
-    ConstantNode *res = malloc_wrapper(sizeof(ConstantNode));
-    res->base.type = NTYPE_CONSTANT;
+    ConstantNode *res = alloc_node(NTYPE_CONSTANT, 0);
     res->base.token_index = tok_index;
     res->const_value = value;
     return (Node*)res;
@@ -51,31 +224,229 @@ Node *malloc_constant_node(double value, size_t tok_index)
 
 Node *malloc_operator_node(const Operator *op, size_t num_children, size_t tok_index)
 {
-    OperatorNode *res = malloc_wrapper(sizeof(OperatorNode) + num_children * sizeof(Node*));
+    OperatorNode *res = alloc_node(NTYPE_OPERATOR, num_children);
     for (size_t i = 0; i < num_children; i++) res->children[i] = NULL;
-    res->base.type = NTYPE_OPERATOR;
     res->base.token_index = tok_index;
     res->op = op;
     res->num_children = num_children;
     return (Node*)res;
 }
 
+static TraversalAction free_pre(Node **node, __attribute__((unused)) Traversal *traversal, __attribute__((unused)) void *state)
+{
+    // Trees of an arena that is not set anymore are released as a whole by arena_reset
+    if ((*node)->flags & NODE_FLAG_ARENA && node_arena == NULL) return TRAVERSAL_SKIP;
+    return TRAVERSAL_CONTINUE;
+}
+
+static TraversalAction free_post(Node **node, __attribute__((unused)) Traversal *traversal, __attribute__((unused)) void *state)
+{
+    free_node(*node);
+    return TRAVERSAL_CONTINUE;
+}
+
 void free_tree(Node *tree)
 {
     if (tree == NULL) return;
-    if (get_type(tree) == NTYPE_OPERATOR)
+    // Leaves are freed without setting up a traversal
+    if (get_type(tree) != NTYPE_OPERATOR)
     {
-        for (size_t i = 0; i < get_num_children(tree); i++)
-        {
-            free_tree(get_child(tree, i));
-        }
+        if (free_pre(&tree, NULL, NULL) == TRAVERSAL_CONTINUE) free_node(tree);
+        return;
+    }
+    tree_traverse(&tree, free_pre, free_post, NULL);
+}
+
+/*
+Summary: Frees a single node, but not its children.
+    Heap nodes are put into the free list of their size class if it is not full.
+    Arena nodes are put into the free list of the current arena, and ignored when no arena is set.
+*/
+void free_node(Node *node)
+{
+    if (node == NULL) return;
+    if (node->flags & NODE_FLAG_ARENA)
+    {
+        size_t num_children = get_type(node) == NTYPE_OPERATOR ? get_num_children(node) : 0;
+        if (node_arena == NULL || !is_recyclable(get_type(node), num_children)) return;
+        NodeSizeClass size_class = get_size_class(get_type(node), num_children);
+        FreeSlot *slot = (FreeSlot*)node;
+        slot->next = arena_free_lists[size_class];
+        arena_free_lists[size_class] = slot;
+        return;
+    }
+    alloc_stats.frees++;
+    alloc_stats.live--;
+
+    size_t num_children = get_type(node) == NTYPE_OPERATOR ? get_num_children(node) : 0;
+    NodeSizeClass size_class = get_size_class(get_type(node), num_children);
+    if (recycling
+        && is_recyclable(get_type(node), num_children)
+        && num_cached[size_class] < RECYCLE_MAX_CACHED)
+    {
+        FreeSlot *slot = (FreeSlot*)node;
+        slot->next = free_lists[size_class];
+        free_lists[size_class] = slot;
+        num_cached[size_class]++;
+        alloc_stats.cached++;
+        return;
+    }
+    free(node);
+}
+
+static uint64_t mix(uint64_t h, uint64_t value)
+{
+    h ^= value + 0x9e3779b97f4a7c15 + (h << 6) + (h >> 2);
+    return h;
+}
+
+static NodeInfo get_leaf_info(const Node *node)
+{
+    NodeInfo info = {
+        .hash          = get_type(node),
+        .op_mask       = 0,
+        .num_nodes     = 1,
+        .num_variables = 0,
+        .depth         = 1
+    };
+
+    if (get_type(node) == NTYPE_CONSTANT)
+    {
+        double value = get_const_value(node);
+        if (value == 0) value = 0; // -0 and 0 are equal
+        uint64_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        info.hash = mix(info.hash, bits);
+    }
+    else
+    {
+        // IDs are not taken into account, thus set_id does not need to invalidate
+        info.hash = mix(info.hash, get_var_symbol(node));
+        info.num_variables = 1;
+    }
+    return info;
+}
+
+// Combines infos of children (in order) to info of operator node
+static NodeInfo combine_infos(const Node *node, const NodeInfo *children)
+{
+    NodeInfo info = {
+        .hash          = mix(mix(NTYPE_OPERATOR, get_op(node)->id), get_num_children(node)),
+        .op_mask       = OP_MASK_BIT(get_op(node)),
+        .num_nodes     = 1,
+        .num_variables = 0,
+        .depth         = 1
+    };
+
+    for (size_t i = 0; i < get_num_children(node); i++)
+    {
+        info.hash = mix(info.hash, children[i].hash);
+        info.op_mask |= children[i].op_mask;
+        info.num_nodes += children[i].num_nodes;
+        info.num_variables += children[i].num_variables;
+        if (children[i].depth + 1 > info.depth) info.depth = children[i].depth + 1;
+    }
+    return info;
+}
+
+struct InfoComputation {
+    Vector infos; // Infos of visited subtrees whose parent has not been post-visited yet
+    bool store;   // Cache infos in operator nodes
+};
+
+static TraversalAction info_pre(Node **node, __attribute__((unused)) Traversal *traversal, void *state)
+{
+    struct InfoComputation *computation = state;
+    if (!has_info(*node)) return TRAVERSAL_CONTINUE;
+    VEC_PUSH_ELEM(&computation->infos, NodeInfo, get_info(*node));
+    return TRAVERSAL_SKIP;
+}
+
+static TraversalAction info_post(Node **node, __attribute__((unused)) Traversal *traversal, void *state)
+{
+    struct InfoComputation *computation = state;
+    size_t num_children = get_num_children(*node);
+    size_t first = vec_count(&computation->infos) - num_children;
+    NodeInfo info = combine_infos(*node, num_children > 0 ? vec_get(&computation->infos, first) : NULL);
+    for (size_t i = 0; i < num_children; i++) vec_pop(&computation->infos);
+    VEC_PUSH_ELEM(&computation->infos, NodeInfo, info);
+
+    if (computation->store)
+    {
+        ((OperatorNode*)*node)->info = info;
+        (*node)->flags |= NODE_FLAG_INFO;
     }
-    free(tree);
+    return TRAVERSAL_CONTINUE;
+}
+
+// Computes info of every subtree without one bottom-up, reusing cached infos
+static NodeInfo compute_info(Node *tree, bool store)
+{
+    struct InfoComputation computation = {
+        .infos = vec_create(sizeof(NodeInfo), INFO_STACK_STARTSIZE),
+        .store = store
+    };
+    tree_traverse(&tree, info_pre, info_post, &computation);
+    NodeInfo res = *(NodeInfo*)vec_get(&computation.infos, 0);
+    vec_destroy(&computation.infos);
+    return res;
+}
+
+/*
+Returns: True if get_info is O(1) for node, i.e. node is a leaf or an operator with cached info
+*/
+bool has_info(const Node *node)
+{
+    return get_type(node) != NTYPE_OPERATOR || node->flags & NODE_FLAG_INFO;
+}
+
+/*
+Summary: Summary of tree. Only read from node, thus safe to be called by concurrent threads.
+    Cached for operator nodes by update_info, otherwise computed from the cached infos of descendants
+    (in O(size of tree) in the worst case).
+*/
+NodeInfo get_info(const Node *node)
+{
+    if (get_type(node) != NTYPE_OPERATOR) return get_leaf_info(node);
+    if (node->flags & NODE_FLAG_INFO) return ((const OperatorNode*)node)->info;
+    return compute_info((Node*)node, false);
+}
+
+/*
+Summary: Structural hash of tree. Equal trees (as in tree_equals) have equal hashes.
+*/
+uint64_t get_hash(const Node *node)
+{
+    return get_info(node).hash;
+}
+
+/*
+Summary: Caches infos of all operator nodes in tree that do not hold one yet.
+    An info is only cached after the infos of all descendants, so when a node has no valid info,
+    none of its ancestors has one.
+*/
+void update_info(Node *tree)
+{
+    if (!has_info(tree)) compute_info(tree, true);
+}
+
+/*
+Summary: Drops cached info of node, must be called before node is changed.
+    Nodes do not know their parents, so infos of ancestors have to be dropped by the caller.
+    Invariant: When a node holds no info, none of its ancestors does. It is kept by
+    - tree_traverse for nodes replaced by visitors and by visitors calling traversal_invalidate_ancestors
+    - find_matching for the matched subtree
+    Any other change of a tree with cached infos needs to be followed by update_info of its root
+    after invalidating the path from the root to the changed node.
+*/
+void invalidate_info(Node *node)
+{
+    node->flags &= ~NODE_FLAG_INFO;
 }
 
 NodeType get_type(const Node *node)
 {
-    return node->type;
+    return (NodeType)node->type;
 }
 
 size_t get_token_index(const Node *node)
@@ -93,8 +464,12 @@ const Operator *get_op(const Node *node)
     return ((OperatorNode*)node)->op;
 }
 
+/*
+Summary: Invalidates info of node, but not of its ancestors (see invalidate_info)
+*/
 void set_op(Node *node, const Operator *op)
 {
+    invalidate_info(node);
     ((OperatorNode*)node)->op = op;
 }
 
@@ -113,14 +488,23 @@ Node **get_child_addr(const Node *node, size_t index)
     return &((OperatorNode*)node)->children[index];
 }
 
+/*
+Summary: Invalidates info of node, but not of its ancestors (see invalidate_info)
+*/
 void set_child(Node *node, size_t index, Node *child)
 {
+    invalidate_info(node);
     ((OperatorNode*)node)->children[index] = child;
 }
 
 const char *get_var_name(const Node *node)
 {
-    return ((VariableNode*)node)->var_name;
+    return symbol_get_name(((VariableNode*)node)->symbol);
+}
+
+Symbol get_var_symbol(const Node *node)
+{
+    return ((VariableNode*)node)->symbol;
 }
 
 size_t get_id(const Node *node)
@@ -1,6 +1,9 @@
 #pragma once
 #include <stdbool.h>
+#include <stdint.h>
+#include "../../util/arena.h"
 #include "operator.h"
+#include "symbols.h"
 
 /*
 Trees consist of nodes that are either operators, constants or variables.
@@ -23,11 +26,65 @@ typedef struct {
     const Node **nodes;
 } NodeList;
 
+// Freed heap nodes are kept in a free list per size class for reuse, see node_set_recycling
+typedef enum {
+    NODE_CLASS_CONSTANT,
+    NODE_CLASS_VARIABLE,
+    NODE_CLASS_OP_0, // Operators by number of children
+    NODE_CLASS_OP_1,
+    NODE_CLASS_OP_2,
+    NODE_CLASS_OP_3,
+    NODE_CLASS_OP_N, // Operators with 4 to NODE_RECYCLE_MAX_CHILDREN children, larger ones are not recycled
+    NODE_NUM_CLASSES
+} NodeSizeClass;
+
+#define NODE_RECYCLE_MAX_CHILDREN 8
+
+// Counts node allocations, e.g. to compare heap and arena allocation
+typedef struct {
+    size_t heap_allocs;
+    size_t arena_allocs;
+    size_t arena_recycled; // Arena allocations served from a free list of the arena
+    size_t frees;
+    size_t recycled;  // Heap allocations served from a free list
+    size_t live;      // Heap nodes currently allocated, not reset
+    size_t peak_live; // Maximum of live since last reset
+    size_t cached;    // Freed nodes currently kept in free lists, not reset
+    size_t class_allocs[NODE_NUM_CLASSES];
+    size_t class_recycled[NODE_NUM_CLASSES];
+} NodeAllocStats;
+
+// Summary of a subtree, see get_info
+typedef struct {
+    uint64_t hash;          // Structural hash, equal trees have equal hashes
+    uint64_t op_mask;       // Contains OP_MASK_BIT of every operator in tree (might collide)
+    uint32_t num_nodes;
+    uint32_t num_variables; // Number of variable nodes
+    uint32_t depth;         // 1 for leaves
+} NodeInfo;
+
+#define OP_MASK_BIT(op) ((uint64_t)1 << ((op)->id % 64))
+
 // Memory
+void node_set_arena(Arena *arena);
+Arena *node_get_arena();
+void node_set_recycling(bool enabled);
+void node_trim_free_lists();
+NodeAllocStats node_get_alloc_stats();
+void node_reset_alloc_stats();
 Node *malloc_variable_node(const char *var_name, size_t id, size_t tok_index);
+Node *malloc_symbol_node(Symbol symbol, size_t id, size_t tok_index);
 Node *malloc_constant_node(double value, size_t tok_index);
 Node *malloc_operator_node(const Operator *op, size_t num_children, size_t tok_index);
 void free_tree(Node *tree);
+void free_node(Node *node);
+
+// Info, cached in operator nodes
+NodeInfo get_info(const Node *node);
+uint64_t get_hash(const Node *node);
+bool has_info(const Node *node);
+void update_info(Node *tree);
+void invalidate_info(Node *node);
 
 // Accessors
 NodeType get_type(const Node *node);
@@ -40,6 +97,7 @@ Node *get_child(const Node *node, size_t index);
 Node **get_child_addr(const Node *node, size_t index);
 void set_child(Node *node, size_t index, Node *child);
 const char *get_var_name(const Node *node);
+Symbol get_var_symbol(const Node *node);
 size_t get_id(const Node *node);
 void set_id(Node *node, size_t id);
 double get_const_value(const Node *node);
@@ -49,3 +49,11 @@ Operator op_get_constant(const char *name)
 {
     return op_get_function(name, 0);
 }
+
+/*
+Returns: False if operator has no traits or trait is not set
+*/
+bool op_has_trait(const Operator *op, OpTraitFlags trait)
+{
+    return op->traits != NULL && (op->traits->flags & trait) != 0;
+}
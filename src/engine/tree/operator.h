@@ -1,6 +1,7 @@
 #pragma once
 #include <stdlib.h>
 #include <stdint.h>
+#include <stdbool.h>
 #include <limits.h>
 
 #define OP_DYNAMIC_ARITY  SIZE_MAX  // Used to indicate arbitrary number of operands
@@ -21,14 +22,51 @@ typedef enum {
     OP_PLACE_FUNCTION,
 } OpPlacement;
 
+typedef enum {
+    OP_TRAIT_IMPURE      = 1 << 0, // Result may differ for same arguments (e.g. random numbers)
+    OP_TRAIT_COMMUTATIVE = 1 << 1, // Order of operands does not matter
+    OP_TRAIT_ASSOCIATIVE = 1 << 2, // Nesting does not matter (up to rounding), e.g. (a+b)+c = a+(b+c)
+    OP_TRAIT_IDENTITY    = 1 << 3, // x op identity = x
+    OP_TRAIT_ABSORBING   = 1 << 4, // x op absorbing = absorbing for finite x
+} OpTraitFlags;
+
+typedef int ListenerError;
+typedef struct Operator Operator;
+
+/*
+Semantics of an operator, attached by the context that knows how to evaluate it (see ctx_set_traits).
+Lets evaluation, bytecode and rewriting query an operator in O(1) instead of dispatching on its id.
+*/
 typedef struct {
+    // Computes operator, NULL when it can not be evaluated numerically
+    ListenerError (*evaluate)(const Operator *op, size_t num_args, const double *args, double *out);
+    double (*unary)(double);                          // Optional for unary operators that never fail
+    void (*batch)(double *values, size_t num_values); // Optional vectorized unary, may differ in rounding
+    int flags;                                        // OpTraitFlags
+    double identity;                                  // Only meaningful with OP_TRAIT_IDENTITY
+    double absorbing;                                 // Only meaningful with OP_TRAIT_ABSORBING
+
+    // How bytecode executes operator, see OpInfo in bytecode.h
+    int kind;                                         // OpKind, ignored when unary is set
+    const char *cofunction;                           // Optional name of function computed together with unary by fused
+    void (*fused)(double x, double *out, double *out_cofunction);
+    void (*fused_batch)(double *values, double *out_cofunction, size_t num_values);
+    void (*shared)(const double *args, size_t num_args, uint32_t selection, double *out_results);
+    uint32_t shared_bit;                              // Selects operator in shared
+    int reduction;                                    // Optional kernel of context that reduces many values like repeated application
+} OpTraits;
+
+struct Operator {
     char *name;
     size_t id; // For easier lookup
     size_t arity;
     Precedence precedence;
     OpAssociativity assoc;
     OpPlacement placement;
-} Operator;
+    const OpTraits *traits; // NULL when semantics are unknown
+};
+
+bool op_has_trait(const Operator *op, OpTraitFlags trait);
 
 Operator op_get_function(const char *name, size_t arity);
 Operator op_get_prefix(const char *name, Precedence precedence);
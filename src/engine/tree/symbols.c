@@ -0,0 +1,98 @@
+#include <string.h>
+
+#include "../../util/alloc_wrappers.h"
+#include "../../util/console_util.h"
+#include "symbols.h"
+
+#define START_CAPACITY 64 // Must be a power of two
+#define EMPTY_SLOT     UINT32_MAX
+
+// Names by symbol
+static char **names = NULL;
+static size_t num_symbols = 0;
+
+// Open-addressing hash table of symbols, keyed by name
+static Symbol *slots = NULL;
+static size_t capacity = 0;
+
+static uint64_t hash_name(const char *name)
+{
+    // FNV-1a
+    uint64_t h = 0xcbf29ce484222325;
+    for (const char *c = name; *c != '\0'; c++)
+    {
+        h ^= (unsigned char)*c;
+        h *= 0x100000001b3;
+    }
+    return h;
+}
+
+// Returns slot that contains name or empty slot where it would be inserted
+static size_t find_slot(const char *name)
+{
+    size_t i = hash_name(name) & (capacity - 1);
+    while (slots[i] != EMPTY_SLOT && strcmp(names[slots[i]], name) != 0)
+    {
+        i = (i + 1) & (capacity - 1);
+    }
+    return i;
+}
+
+static void grow()
+{
+    Symbol *old_slots = slots;
+    size_t old_capacity = capacity;
+
+    capacity = capacity == 0 ? START_CAPACITY : capacity * 2;
+    slots = malloc_wrapper(capacity * sizeof(Symbol));
+    for (size_t i = 0; i < capacity; i++) slots[i] = EMPTY_SLOT;
+    names = realloc_wrapper(names, capacity * sizeof(char*));
+
+    for (size_t i = 0; i < old_capacity; i++)
+    {
+        if (old_slots[i] != EMPTY_SLOT) slots[find_slot(names[old_slots[i]])] = old_slots[i];
+    }
+    free(old_slots);
+}
+
+/*
+Returns: Symbol of name, a new one is created when name has not been interned before
+*/
+Symbol symbol_intern(const char *name)
+{
+    // Table is kept at most half full, names has as many entries as slots
+    if (2 * (num_symbols + 1) > capacity) grow();
+
+    size_t slot = find_slot(name);
+    if (slots[slot] == EMPTY_SLOT)
+    {
+        if (num_symbols == EMPTY_SLOT) software_defect("Too many symbols.\n");
+        names[num_symbols] = malloc_wrapper(strlen(name) + 1);
+        strcpy(names[num_symbols], name);
+        slots[slot] = num_symbols++;
+    }
+    return slots[slot];
+}
+
+/*
+Summary: Like symbol_intern, but does not create a new symbol
+Returns: False if name has not been interned, i.e. no variable of this name exists
+*/
+bool symbol_lookup(const char *name, Symbol *out_symbol)
+{
+    if (capacity == 0) return false;
+    size_t slot = find_slot(name);
+    if (slots[slot] == EMPTY_SLOT) return false;
+    *out_symbol = slots[slot];
+    return true;
+}
+
+const char *symbol_get_name(Symbol symbol)
+{
+    return names[symbol];
+}
+
+size_t symbol_count()
+{
+    return num_symbols;
+}
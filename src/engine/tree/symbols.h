@@ -0,0 +1,17 @@
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+/*
+Global symbol table: Every distinct variable name is stored once and identified by a small integer,
+so that variable nodes can be copied and compared without touching strings.
+Symbols are never released, names returned by symbol_get_name stay valid for the whole runtime.
+*/
+
+typedef uint32_t Symbol;
+
+Symbol symbol_intern(const char *name);
+bool symbol_lookup(const char *name, Symbol *out_symbol);
+const char *symbol_get_name(Symbol symbol);
+size_t symbol_count();
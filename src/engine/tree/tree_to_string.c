@@ -1,8 +1,10 @@
 #include <stdarg.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <string.h>
 
 #include "tree_to_string.h"
+#include "tree_traversal.h"
 #include "../parsing/context.h"
 #include "../../util/string_util.h"
 
@@ -20,162 +22,186 @@ static void p_close(StringBuilder *builder)
     strbuilder_append(builder, CLOSING_P);
 }
 
-static void to_str(StringBuilder *builder, bool color, const ParsingContext *ctx, const Node *node, bool l, bool r);
+/*
+Every node is printed with the following flags, determined by its parent:
+    l, r: Indicates whether subexpression represented by the node needs to be protected to the left or right.
+        It needs to be protected when it is adjacent to an operator on this side.
+        When the subexpression starts (ends) with an operator and needs to be protected to the left (right), a parenthesis is printed in between.
+    wrap: Subexpression is wrapped in parentheses, it does not need to be protected then
+Flags are attached to the node's frame during traversal.
+*/
+#define FLAG_L    1
+#define FLAG_R    2
+#define FLAG_WRAP 4
 
-static void prefix_to_str(StringBuilder *builder, bool color, const ParsingContext *ctx, const Node *node, bool l, bool r)
-{
-    if (l) p_open(builder);
-    strbuilder_append(builder, get_op(node)->name);
-    
-    if (get_type(get_child(node, 0)) == NTYPE_OPERATOR
-        && get_op(get_child(node, 0))->precedence <= get_op(node)->precedence)
-    {
-        p_open(builder);
-        to_str(builder, color, ctx, get_child(node, 0), false, false);
-        p_close(builder);
-    }
-    else
-    {
-        // Subexpression needs to be right-protected when expression of 'node' is not encapsulated in parentheses
-        // (!l, otherwise redundant parentheses would be printed) and itself needs to be right-protected
-        to_str(builder, color, ctx, get_child(node, 0), true, !l && r);
-    }
-    
-    if (l) p_close(builder);
-}
+typedef struct {
+    StringBuilder *builder;
+    bool color;
+    const ParsingContext *ctx;
+} Printer;
 
-static void postfix_to_str(StringBuilder *builder, bool color, const ParsingContext *ctx, const Node *node, bool l, bool r)
+static uintptr_t flags(bool l, bool r, bool wrap)
 {
-    if (r) p_open(builder);
-
-    // It should be safe to dereference first child
-    if (get_type(get_child(node, 0)) == NTYPE_OPERATOR
-        && get_op(get_child(node, 0))->precedence < get_op(node)->precedence)
-    {
-        p_open(builder);
-        to_str(builder, color, ctx, get_child(node, 0), false, false);
-        p_close(builder);
-    }
-    else
-    {
-        // See analog case of infix operator for conditions for left-protection
-        to_str(builder, color, ctx, get_child(node, 0), l && !r, true);
-    }
-    
-    strbuilder_append(builder, "%s", get_op(node)->name);
-    if (r) p_close(builder);
+    return (l ? FLAG_L : 0) | (r ? FLAG_R : 0) | (wrap ? FLAG_WRAP : 0);
 }
 
-static void function_to_str(StringBuilder *builder, bool color, const ParsingContext *ctx, const Node *node)
+static bool infix_needs_paren(const Node *node, const Node *operand, OpAssociativity protecting_assoc)
 {
-    if (get_op(node)->arity != 0)
-    {
-        strbuilder_append(builder, "%s(", get_op(node)->name);
-        for (size_t i = 0; i < get_num_children(node); i++)
-        {
-            to_str(builder, color, ctx, get_child(node, i), false, false);
-            if (i < get_num_children(node) - 1) strbuilder_append(builder, ",");
-        }
-        p_close(builder);
-    }
-    else
-    {
-        strbuilder_append(builder, "%s", get_op(node)->name);
-    }
+    // Checks if operand of infix operator which itself is an operator needs to be wrapped in parentheses
+    // This is the case when:
+    //    - It has a lower precedence
+    //    - It has the same precedence but node associates to the other side
+    //      (Same precedence -> same associativity, see consistency rules for operator set in context.c)
+    return get_type(operand) == NTYPE_OPERATOR
+        && (get_op(operand)->precedence < get_op(node)->precedence
+            || (get_op(operand)->precedence == get_op(node)->precedence
+                && get_op(node)->assoc == protecting_assoc));
 }
 
-static void infix_to_str(StringBuilder *builder, bool color, const ParsingContext *ctx, const Node *node, bool l, bool r)
+/*
+Summary: Computes flags of child and prints what precedes it within its parent
+Params
+    parent: Operator node
+    index:  Index of child in parent
+    p:      Flags of parent
+*/
+static uintptr_t child_to_str(Printer *printer, const Node *parent, size_t index, uintptr_t p)
 {
-    Node *left = get_child(node, 0);
-    Node *right = get_child(node, 1);
+    bool l = p & FLAG_L;
+    bool r = p & FLAG_R;
+    const Node *child = get_child(parent, index);
 
-    // Checks if left operand of infix operator which itself is an operator needs to be wrapped in parentheses
-    // This is the case when:
-    //    - It has a lower precedence
-    //    - It has the same precedence but associates to the right
-    //      (Same precedence -> same associativity, see consistency rules for operator set in context.c)
-    if (get_type(left) == NTYPE_OPERATOR
-        && (get_op(left)->precedence < get_op(node)->precedence
-            || (get_op(left)->precedence == get_op(node)->precedence
-                && get_op(node)->assoc == OP_ASSOC_RIGHT)))
+    switch (get_op(parent)->placement)
     {
-        p_open(builder);
-        to_str(builder, color, ctx, left, false, false);
-        p_close(builder);
-    }
-    else
-    {
-        to_str(builder, color, ctx, left, l, true);
-    }
+        case OP_PLACE_PREFIX:
+            if (get_type(child) == NTYPE_OPERATOR && get_op(child)->precedence <= get_op(parent)->precedence)
+            {
+                return flags(false, false, true);
+            }
+            // Subexpression needs to be right-protected when expression of parent is not encapsulated in parentheses
+            // (!l, otherwise redundant parentheses would be printed) and itself needs to be right-protected
+            return flags(true, !l && r, false);
 
-    bool r_needs_paren = get_type(right) == NTYPE_OPERATOR
-        && (get_op(right)->precedence < get_op(node)->precedence
-            || (get_op(right)->precedence == get_op(node)->precedence
-                && get_op(node)->assoc == OP_ASSOC_LEFT));
+        case OP_PLACE_POSTFIX:
+            // It should be safe to dereference first child
+            if (get_type(child) == NTYPE_OPERATOR && get_op(child)->precedence < get_op(parent)->precedence)
+            {
+                return flags(false, false, true);
+            }
+            // See analog case of infix operator for conditions for left-protection
+            return flags(l && !r, true, false);
 
-    // Print infix operator if it is not a glue op
-    if (ctx == NULL
-        || r_needs_paren
-        || ctx->glue_op->id != get_op(node)->id
-        || get_type(left) != NTYPE_CONSTANT
-        || get_type(right) == NTYPE_CONSTANT)
-    {
-        strbuilder_append(builder, is_letter(get_op(node)->name[0]) ? " %s " : "%s", get_op(node)->name);
-    }
+        case OP_PLACE_FUNCTION:
+            if (index > 0) strbuilder_append(printer->builder, ",");
+            return flags(false, false, false);
 
-    // Checks if right operand of infix operator needs to be wrapped in parentheses (see analog case for left operand)
-    if (r_needs_paren)
-    {
-        p_open(builder);
-        to_str(builder, color, ctx, right, false, false);
-        p_close(builder);
-    }
-    else
-    {
-        to_str(builder, color, ctx, right, true, r);
+        case OP_PLACE_INFIX:
+            if (index == 0)
+            {
+                if (infix_needs_paren(parent, child, OP_ASSOC_RIGHT)) return flags(false, false, true);
+                return flags(l, true, false);
+            }
+            else
+            {
+                const Node *left = get_child(parent, 0);
+                bool r_needs_paren = infix_needs_paren(parent, child, OP_ASSOC_LEFT);
+
+                // Print infix operator if it is not a glue op
+                if (printer->ctx == NULL
+                    || r_needs_paren
+                    || printer->ctx->glue_op->id != get_op(parent)->id
+                    || get_type(left) != NTYPE_CONSTANT
+                    || get_type(child) == NTYPE_CONSTANT)
+                {
+                    strbuilder_append(printer->builder,
+                        is_letter(get_op(parent)->name[0]) ? " %s " : "%s",
+                        get_op(parent)->name);
+                }
+
+                // Checks if right operand of infix operator needs to be wrapped in parentheses (see analog case for left operand)
+                if (r_needs_paren) return flags(false, false, true);
+                return flags(true, r, false);
+            }
     }
+    return flags(false, false, false);
 }
 
-/*
-Params
-    l, r: Indicates whether subexpression represented by 'node' needs to be protected to the left or right.
-        It needs to be protected when it is adjacent to an operator on this side.
-        When the subexpression starts (ends) with an operator and needs to be protected to the left (right), a parenthesis is printed in between.
-*/
-static void to_str(StringBuilder *builder, bool color, const ParsingContext *ctx, const Node *node, bool l, bool r)
+static TraversalAction to_str_pre(Node **node, Traversal *traversal, void *state)
 {
-    switch (get_type(node))
+    Printer *printer = state;
+    StringBuilder *builder = printer->builder;
+    uintptr_t f = traversal_parent(traversal) != NULL
+        ? child_to_str(printer,
+            traversal_parent(traversal),
+            traversal_index(traversal),
+            (uintptr_t)traversal_get_parent_data(traversal))
+        : flags(false, false, false);
+    traversal_set_data(traversal, (void*)f);
+
+    if (f & FLAG_WRAP) p_open(builder);
+    switch (get_type(*node))
     {
         case NTYPE_CONSTANT:
-            strbuilder_append(builder, color ? CONST_COLOR CONSTANT_TYPE_FMT COL_RESET : CONSTANT_TYPE_FMT, get_const_value(node));
+            strbuilder_append(builder,
+                printer->color ? CONST_COLOR CONSTANT_TYPE_FMT COL_RESET : CONSTANT_TYPE_FMT,
+                get_const_value(*node));
             break;
-            
+
         case NTYPE_VARIABLE:
-            strbuilder_append(builder, color ? VAR_COLOR "%s" COL_RESET : "%s", get_var_name(node));
+            strbuilder_append(builder, printer->color ? VAR_COLOR "%s" COL_RESET : "%s", get_var_name(*node));
             break;
-            
+
         case NTYPE_OPERATOR:
-            switch (get_op(node)->placement)
+            switch (get_op(*node)->placement)
             {
                 case OP_PLACE_PREFIX:
-                    prefix_to_str(builder, color, ctx, node, l, r);
+                    if (f & FLAG_L) p_open(builder);
+                    strbuilder_append(builder, get_op(*node)->name);
                     break;
                 case OP_PLACE_POSTFIX:
-                    postfix_to_str(builder, color, ctx, node, l, r);
+                    if (f & FLAG_R) p_open(builder);
                     break;
                 case OP_PLACE_FUNCTION:
-                    function_to_str(builder, color, ctx, node);
+                    strbuilder_append(builder, get_op(*node)->arity != 0 ? "%s(" : "%s", get_op(*node)->name);
                     break;
                 case OP_PLACE_INFIX:
-                    infix_to_str(builder, color, ctx, node, l, r);
                     break;
             }
     }
+    return TRAVERSAL_CONTINUE;
+}
+
+static TraversalAction to_str_post(Node **node, Traversal *traversal, void *state)
+{
+    StringBuilder *builder = ((Printer*)state)->builder;
+    uintptr_t f = (uintptr_t)traversal_get_data(traversal);
+
+    if (get_type(*node) == NTYPE_OPERATOR)
+    {
+        switch (get_op(*node)->placement)
+        {
+            case OP_PLACE_PREFIX:
+                if (f & FLAG_L) p_close(builder);
+                break;
+            case OP_PLACE_POSTFIX:
+                strbuilder_append(builder, "%s", get_op(*node)->name);
+                if (f & FLAG_R) p_close(builder);
+                break;
+            case OP_PLACE_FUNCTION:
+                if (get_op(*node)->arity != 0) p_close(builder);
+                break;
+            case OP_PLACE_INFIX:
+                break;
+        }
+    }
+    if (f & FLAG_WRAP) p_close(builder);
+    return TRAVERSAL_CONTINUE;
 }
 
 void tree_append_to_strbuilder(StringBuilder *builder, const Node *node, const ParsingContext *ctx, bool color)
 {
-    to_str(builder, color, ctx, node, false, false);
+    Printer printer = { .builder = builder, .color = color, .ctx = ctx };
+    tree_traverse((Node**)&node, to_str_pre, to_str_post, &printer);
 }
 
 // Summary: Returns string (on heap)
@@ -0,0 +1,152 @@
+#include "../../util/alloc_wrappers.h"
+#include "tree_traversal.h"
+
+#define LOCAL_FRAMES 32 // Traversals of trees up to this depth do not allocate
+
+typedef struct {
+    Node **slot;       // Address of node
+    size_t next_child; // Index of child to visit next
+    void *data;        // Data attached by visitors
+} Frame;
+
+struct Traversal {
+    Frame *frames;
+    size_t num_frames;
+    size_t capacity;
+    Frame local_frames[LOCAL_FRAMES];
+};
+
+static void push(Traversal *traversal, Node **slot)
+{
+    if (traversal->num_frames == traversal->capacity)
+    {
+        traversal->capacity *= 2;
+        if (traversal->frames == traversal->local_frames)
+        {
+            traversal->frames = malloc_wrapper(traversal->capacity * sizeof(Frame));
+            for (size_t i = 0; i < LOCAL_FRAMES; i++) traversal->frames[i] = traversal->local_frames[i];
+        }
+        else
+        {
+            traversal->frames = realloc_wrapper(traversal->frames, traversal->capacity * sizeof(Frame));
+        }
+    }
+    traversal->frames[traversal->num_frames++] = (Frame){ .slot = slot, .next_child = 0, .data = NULL };
+}
+
+// Pushes node and invokes pre-visitor, node is popped again when it is skipped
+static TraversalAction enter(Traversal *traversal, Node **slot, TreeVisitor pre, void *state)
+{
+    push(traversal, slot);
+    if (pre == NULL) return TRAVERSAL_CONTINUE;
+    Node *node = *slot;
+    TraversalAction action = pre(slot, traversal, state);
+    if (*slot != node) traversal_invalidate_ancestors(traversal);
+    if (action == TRAVERSAL_SKIP) traversal->num_frames--;
+    return action;
+}
+
+/*
+Summary: Visits all nodes of tree depth-first, see tree_traversal.h
+Params
+    pre, post: Visitors, may be NULL
+    state:     Passed to visitors
+Returns: False if traversal has been stopped by a visitor
+*/
+bool tree_traverse(Node **tree, TreeVisitor pre, TreeVisitor post, void *state)
+{
+    Traversal traversal;
+    traversal.frames = traversal.local_frames;
+    traversal.num_frames = 0;
+    traversal.capacity = LOCAL_FRAMES;
+
+    bool completed = enter(&traversal, tree, pre, state) != TRAVERSAL_STOP;
+    while (completed && traversal.num_frames > 0)
+    {
+        Frame *top = &traversal.frames[traversal.num_frames - 1];
+        Node *node = *top->slot;
+
+        if (get_type(node) == NTYPE_OPERATOR && top->next_child < get_num_children(node))
+        {
+            // Descend into next child
+            Node **child = get_child_addr(node, top->next_child++);
+            completed = enter(&traversal, child, pre, state) != TRAVERSAL_STOP;
+        }
+        else
+        {
+            // All children done
+            if (post != NULL)
+            {
+                completed = post(top->slot, &traversal, state) != TRAVERSAL_STOP;
+                if (*top->slot != node) traversal_invalidate_ancestors(&traversal);
+            }
+            traversal.num_frames--;
+        }
+    }
+
+    if (traversal.frames != traversal.local_frames) free(traversal.frames);
+    return completed;
+}
+
+/*
+Returns: Depth of current node, 0 for root
+*/
+size_t traversal_depth(const Traversal *traversal)
+{
+    return traversal->num_frames - 1;
+}
+
+/*
+Returns: Index of current node within children of its parent, 0 for root
+*/
+size_t traversal_index(const Traversal *traversal)
+{
+    if (traversal->num_frames < 2) return 0;
+    return traversal->frames[traversal->num_frames - 2].next_child - 1;
+}
+
+/*
+Returns: Parent of current node, NULL for root
+*/
+Node *traversal_parent(const Traversal *traversal)
+{
+    if (traversal->num_frames < 2) return NULL;
+    return *traversal->frames[traversal->num_frames - 2].slot;
+}
+
+/*
+Returns: Data attached to current node by traversal_set_data, NULL when nothing attached
+*/
+void *traversal_get_data(const Traversal *traversal)
+{
+    return traversal->frames[traversal->num_frames - 1].data;
+}
+
+void *traversal_get_parent_data(const Traversal *traversal)
+{
+    if (traversal->num_frames < 2) return NULL;
+    return traversal->frames[traversal->num_frames - 2].data;
+}
+
+/*
+Summary: Attaches data to current node, it is available until node has been post-visited
+*/
+void traversal_set_data(Traversal *traversal, void *data)
+{
+    traversal->frames[traversal->num_frames - 1].data = data;
+}
+
+/*
+Summary: Invalidates cached infos of all ancestors of current node, since it is going to be replaced.
+    Called automatically when a visitor replaces the node it is visiting.
+*/
+void traversal_invalidate_ancestors(Traversal *traversal)
+{
+    for (size_t i = traversal->num_frames - 1; i-- > 0;)
+    {
+        // Ancestors of a node without info do not have one either
+        Node *ancestor = *traversal->frames[i].slot;
+        if (!has_info(ancestor)) break;
+        invalidate_info(ancestor);
+    }
+}
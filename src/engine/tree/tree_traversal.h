@@ -0,0 +1,35 @@
+#pragma once
+#include <stdbool.h>
+#include "node.h"
+
+/*
+Depth-first traversal with an explicit stack instead of recursion,
+thus the depth of a tree is only limited by available heap memory.
+Each node is passed to the pre-visitor before and to the post-visitor after its children.
+Visitors get the address of the node (its slot in the parent), so they may replace it:
+    - In pre-order, the children of the replacement are visited instead
+    - In post-order, the replacement is not visited again
+    - Cached infos of ancestors are invalidated (see invalidate_info)
+The post-visitor may also free the node, the traversal does not access it afterwards.
+*/
+
+typedef enum {
+    TRAVERSAL_CONTINUE, // Proceed as usual
+    TRAVERSAL_SKIP,     // Only returned by pre-visitor: Neither visit children, nor post-visit node
+    TRAVERSAL_STOP      // Early exit: Stop whole traversal immediately
+} TraversalAction;
+
+typedef struct Traversal Traversal;
+
+typedef TraversalAction (*TreeVisitor)(Node **node, Traversal *traversal, void *state);
+
+bool tree_traverse(Node **tree, TreeVisitor pre, TreeVisitor post, void *state);
+
+// Position of currently visited node, to be used within visitors
+size_t traversal_depth(const Traversal *traversal);
+size_t traversal_index(const Traversal *traversal);
+Node *traversal_parent(const Traversal *traversal);
+void *traversal_get_data(const Traversal *traversal);
+void *traversal_get_parent_data(const Traversal *traversal);
+void traversal_set_data(Traversal *traversal, void *data);
+void traversal_invalidate_ancestors(Traversal *traversal);
@@ -1,79 +1,118 @@
-#include <string.h>
 #include <sys/types.h>
 #include "../../util/alloc_wrappers.h"
+#include "../../util/vector.h"
 #include "operator.h"
+#include "tree_traversal.h"
 #include "tree_util.h"
 #include "node.h"
 
+#define REDUCTION_STACK_STARTSIZE 8
+
+// Copies node without its children
+static Node *copy_node(const Node *node)
+{
+    switch (get_type(node))
+    {
+        case NTYPE_OPERATOR:
+            return malloc_operator_node(get_op(node), get_num_children(node), get_token_index(node));
+
+        case NTYPE_CONSTANT:
+            return malloc_constant_node(get_const_value(node), get_token_index(node));
+
+        case NTYPE_VARIABLE:
+            return malloc_symbol_node(get_var_symbol(node), get_id(node), get_token_index(node));
+    }
+    return NULL;
+}
+
+static TraversalAction copy_pre(Node **node, Traversal *traversal, void *state)
+{
+    Node *res = copy_node(*node);
+
+    // Attach copy to copy of parent, children will be attached to the copy
+    Node *parent_copy = traversal_get_parent_data(traversal);
+    if (parent_copy != NULL)
+    {
+        set_child(parent_copy, traversal_index(traversal), res);
+    }
+    else
+    {
+        *(Node**)state = res;
+    }
+    traversal_set_data(traversal, res);
+    return TRAVERSAL_CONTINUE;
+}
+
 /*
 Summary: Copies tree, tree_equals(tree, copy) will return true. Source tree can be safely free'd afterwards.
+    Copies are deep: Rewriting changes trees in place, so subtrees can not be shared between trees.
 Params
     tree: Tree to copy
 */
 Node *tree_copy(const Node *tree)
 {
     if (tree == NULL) return NULL;
-
+    // Leaves are copied without setting up a traversal
+    if (get_type(tree) != NTYPE_OPERATOR) return copy_node(tree);
     Node *res = NULL;
-    switch (get_type(tree))
-    {
-        case NTYPE_OPERATOR:
-            res = malloc_operator_node(get_op(tree), get_num_children(tree), get_token_index(tree));
-            for (size_t i = 0; i < get_num_children(tree); i++)
-            {
-                set_child(res, i, tree_copy(get_child(tree, i)));
-            }
-            break;
-      
-        case NTYPE_CONSTANT:
-            res = malloc_constant_node(get_const_value(tree), get_token_index(tree));
-            break;
-            
-        case NTYPE_VARIABLE:
-            res = malloc_variable_node(get_var_name(tree), get_id(tree), get_token_index(tree));
-            break;
-    }
-    
+    tree_traverse((Node**)&tree, copy_pre, NULL, &res);
     return res;
 }
 
-/*
-Summary: Checks if two trees represent exactly the same expression
-Returns: True iff trees are equal
-*/
-bool tree_equals(const Node *a, const Node *b)
+// Compares node with corresponding node of other tree, without children
+static bool shallow_equals(const Node *a, const Node *b)
 {
-    if (a == NULL || b == NULL) return false;
     if (get_type(a) != get_type(b)) return false;
-    
+
     switch (get_type(a))
     {
         case NTYPE_CONSTANT:
-            if (get_const_value(a) != get_const_value(b)) return false;
-            break;
+            return get_const_value(a) == get_const_value(b);
 
         case NTYPE_VARIABLE:
-            if (strcmp(get_var_name(a), get_var_name(b)) != 0 || get_id(a) != get_id(b)) return false;
-            break;
+            return get_var_symbol(a) == get_var_symbol(b) && get_id(a) == get_id(b);
 
         case NTYPE_OPERATOR:
-            if (get_op(a)->id != get_op(b)->id || get_num_children(a) != get_num_children(b))
-            {
-                return false;
-            }
-            for (size_t i = 0; i < get_num_children(a); i++)
-            {
-                if (!tree_equals(get_child(a, i), get_child(b, i)))
-                {
-                    return false;
-                }
-            }
+            // Hashes are only compared when cached, computing them would take as long as the comparison
+            return get_op(a)->id == get_op(b)->id
+                && get_num_children(a) == get_num_children(b)
+                && (!has_info(a) || !has_info(b) || get_hash(a) == get_hash(b));
     }
-    return true;
+    return false;
+}
+
+// Traverses first tree, state is the root of the second one
+static TraversalAction equals_pre(Node **a, Traversal *traversal, void *state)
+{
+    // Every node is attached to its counterpart in the second tree
+    const Node *b = traversal_depth(traversal) == 0
+        ? state
+        : get_child(traversal_get_parent_data(traversal), traversal_index(traversal));
+
+    if (*a == b) return TRAVERSAL_SKIP;
+    if (!shallow_equals(*a, b)) return TRAVERSAL_STOP;
+    traversal_set_data(traversal, (Node*)b);
+    return TRAVERSAL_CONTINUE;
+}
+
+/*
+Summary: Checks if two trees represent exactly the same expression.
+    Unequal operator trees are mostly rejected by their cached hashes without descending.
+Returns: True iff trees are equal
+*/
+bool tree_equals(const Node *a, const Node *b)
+{
+    if (a == NULL || b == NULL) return false;
+    // Leaves are compared without setting up a traversal
+    if (get_type(a) != NTYPE_OPERATOR) return a == b || shallow_equals(a, b);
+    return tree_traverse((Node**)&a, equals_pre, NULL, (Node*)b);
 }
 
 /*
-Summary: Frees *tree_to_replace and assigns tree_to_insert to tree_to_replace
+Summary: Frees *tree_to_replace and assigns tree_to_insert to tree_to_replace.
+    Cached infos of ancestors become stale and are not invalidated here, see invalidate_info.
+    This is done by tree_traverse when called by a visitor on the visited node,
+    and by find_matching when called on the matched subtree.
 */
 void tree_replace(Node **tree_to_replace, Node *tree_to_insert)
 {
@@ -82,12 +121,14 @@ void tree_replace(Node **tree_to_replace, Node *tree_to_insert)
 }
 
 /*
-Nodes from list are copied, the others are not
+Summary: Nodes from list are copied, the others are not.
+    Only info of *parent is invalidated, the same as for tree_replace applies to its ancestors.
 */
 void tree_replace_by_list(Node **parent, size_t child_to_replace, NodeList list)
 {
     if (list.size != 1) // Parent needs to be replaced (but not via tree_replace because most children are preserved)
     {
+        invalidate_info(*parent);
         free_tree(get_child(*parent, child_to_replace));
 
         Node *new_parent = malloc_operator_node(
@@ -109,7 +150,7 @@ void tree_replace_by_list(Node **parent, size_t child_to_replace, NodeList list)
                 child_to_replace + list.size + i,
                 get_child(*parent, child_to_replace + i + 1));
         }
-        free(*parent);
+        free_node(*parent);
         *parent = new_parent;
     }
     else
@@ -125,26 +166,28 @@ Returns: Total number of variable nodes in tree.
 size_t count_all_variable_nodes(const Node *tree)
 {
     if (tree == NULL) return 0;
+    return get_info(tree).num_variables;
+}
 
-    switch (get_type(tree))
-    {
-        case NTYPE_CONSTANT:
-            return 0;
-
-        case NTYPE_VARIABLE:
-            return 1;
+struct SymbolSearch {
+    Symbol symbol;
+    size_t buffer_size;
+    Node ***out_instances;
+    size_t num_found;
+};
 
-        case NTYPE_OPERATOR:
+static TraversalAction get_symbol_nodes_pre(Node **node, __attribute__((unused)) Traversal *traversal, void *state)
+{
+    struct SymbolSearch *search = state;
+    if (get_type(*node) == NTYPE_VARIABLE && get_var_symbol(*node) == search->symbol)
+    {
+        if (search->num_found < search->buffer_size)
         {
-            size_t sum = 0;
-            for (size_t i = 0; i < get_num_children(tree); i++)
-            {
-                sum += count_all_variable_nodes(get_child(tree, i));
-            }
-            return sum;
+            search->out_instances[search->num_found] = node;
         }
+        search->num_found++;
     }
-    return 0;
+    return TRAVERSAL_CONTINUE;
 }
 
 /*
@@ -157,92 +200,76 @@ size_t get_variable_nodes(const Node * const *tree, const char *var_name, size_t
 {
     if (tree == NULL || var_name == NULL) return 0;
 
-    switch (get_type(*tree))
-    {
-        case NTYPE_CONSTANT:
-            return 0;
-
-        case NTYPE_VARIABLE:
-            if (strcmp(get_var_name(*tree), var_name) == 0)
-            {
-                if (buffer_size > 0)
-                {
-                    *out_instances = (Node**)tree; // Discards const!
-                }
-                return 1;
-            }
-            else
-            {
-                return 0;
-            }
-
-        case NTYPE_OPERATOR:
-        {
-            size_t res = 0;
-            for (size_t i = 0; i < get_num_children(*tree); i++)
-            {
-                size_t num_found = get_variable_nodes((const Node**)get_child_addr(*tree, i), var_name,
-                    buffer_size,
-                    out_instances != NULL ? out_instances + res : NULL);
-
-                res += num_found;
-                if (buffer_size >= num_found)
-                {
-                    buffer_size -= num_found;
-                }
-                else
-                {
-                    buffer_size = 0;
-                }
-            }
-            return res;
-        }
-    }
-
-    return 0;
+    struct SymbolSearch search = {
+        .buffer_size   = buffer_size,
+        .out_instances = out_instances,
+        .num_found     = 0
+    };
+    if (!symbol_lookup(var_name, &search.symbol)) return 0;
+    tree_traverse((Node**)tree, get_symbol_nodes_pre, NULL, &search);
+    return search.num_found;
 }
 
-ssize_t list_variables_rec(Node *tree, size_t buffer_size, ssize_t num_found, const char **out_vars)
-{
-    if (num_found == -1) return -1;
+struct VariableList {
+    size_t buffer_size;
+    const char **out_vars;
+    size_t num_found;
+};
 
-    switch (get_type(tree))
+static TraversalAction list_variables_pre(Node **node, __attribute__((unused)) Traversal *traversal, void *state)
+{
+    struct VariableList *list = state;
+    switch (get_type(*node))
     {
         case NTYPE_CONSTANT:
-            return num_found;
-        
+            return TRAVERSAL_CONTINUE;
+
         case NTYPE_VARIABLE:
-            // Check if we already found variable
-            for (size_t i = 0; i < (size_t)num_found; i++)
+            // Check if we already found variable, names are interned and can be compared by address
+            for (size_t i = 0; i < list->num_found; i++)
             {
-                if (strcmp(get_var_name(tree), out_vars[i]) == 0)
+                if (get_var_name(*node) == list->out_vars[i])
                 {
-                    set_id(tree, i);
-                    return num_found;
+                    set_id(*node, i);
+                    return TRAVERSAL_CONTINUE;
                 }
             }
-            if ((size_t)num_found < buffer_size)
+            if (list->num_found < list->buffer_size)
             {
-                out_vars[num_found] = get_var_name(tree);
-                set_id(tree, num_found);
-                return num_found + 1;
+                list->out_vars[list->num_found] = get_var_name(*node);
+                set_id(*node, list->num_found);
+                list->num_found++;
+                return TRAVERSAL_CONTINUE;
             }
             else
             {
                 // Buffer too small!
-                return -1;
+                return TRAVERSAL_STOP;
             }
 
         case NTYPE_OPERATOR:
-            for (size_t i = 0; i < get_num_children(tree); i++)
-            {
-                // Don't add to num_found but overwrite it since it's passed to each subsequent call
-                num_found = list_variables_rec(get_child(tree, i), buffer_size, num_found, out_vars);
-            }
-            return num_found;
+            return get_info(*node).num_variables == 0 ? TRAVERSAL_SKIP : TRAVERSAL_CONTINUE;
     }
+    return TRAVERSAL_CONTINUE;
+}
+
+struct OpSearch {
+    const Operator *op;
+    Node **result;
+};
+
+static TraversalAction find_op_pre(Node **node, __attribute__((unused)) Traversal *traversal, void *state)
+{
+    struct OpSearch *search = state;
+    // Skip subtrees that certainly do not contain op
+    if (has_info(*node) && (get_info(*node).op_mask & OP_MASK_BIT(search->op)) == 0) return TRAVERSAL_SKIP;
 
-    return 0;
+    if (get_type(*node) == NTYPE_OPERATOR && get_op(*node)->id == search->op->id)
+    {
+        search->result = node;
+        return TRAVERSAL_STOP;
+    }
+    return TRAVERSAL_CONTINUE;
 }
 
 /*
@@ -250,22 +277,9 @@ Returns: Address of first operator node that has given operator, NULL when no su
 */
 Node **find_op(const Node * const *tree, const Operator *op)
 {
-    if (get_type(*tree) == NTYPE_OPERATOR)
-    {
-        if (get_op(*tree)->id == op->id)
-        {
-            return (Node**)tree;
-        }
-        else
-        {
-            for (size_t i = 0; i < get_num_children(*tree); i++)
-            {
-                Node **child_res = find_op((const Node* const*)get_child_addr(*tree, i), op);
-                if (child_res != NULL) return child_res;
-            }
-        }
-    }
-    return NULL;
+    struct OpSearch search = { .op = op, .result = NULL };
+    tree_traverse((Node**)tree, find_op_pre, NULL, &search);
+    return search.result;
 }
 
 /*
@@ -279,8 +293,14 @@ Params
 size_t list_variables(Node *tree, size_t buffer_size, const char **out_vars, bool *out_sufficient_buff)
 {
     if (tree == NULL || out_vars == NULL) return 0;
-    ssize_t res = list_variables_rec(tree, buffer_size, 0, out_vars);
-    if (res == -1)
+    struct VariableList list = {
+        .buffer_size = buffer_size,
+        .out_vars    = out_vars,
+        .num_found   = 0
+    };
+    // Variable-free subtrees are skipped by their cached infos
+    update_info(tree);
+    if (!tree_traverse(&tree, list_variables_pre, NULL, &list))
     {
         if (out_sufficient_buff != NULL)
         {
@@ -293,34 +313,58 @@ size_t list_variables(Node *tree, size_t buffer_size, const char **out_vars, boo
     {
         *out_sufficient_buff = true;
     }
-    return (size_t)res;
+    return list.num_found;
 }
 
-void tree_copy_IDs(Node *tree, size_t num_vars, const char **vars)
+struct SymbolIDs {
+    size_t num_vars;
+    Symbol *symbols;
+};
+
+static TraversalAction copy_IDs_pre(Node **node, __attribute__((unused)) Traversal *traversal, void *state)
 {
-    switch (get_type(tree))
+    struct SymbolIDs *ids = state;
+    if (get_type(*node) == NTYPE_VARIABLE)
     {
-        case NTYPE_CONSTANT:
-            return;
-        
-        case NTYPE_VARIABLE:
-            for (size_t i = 0; i < num_vars; i++)
-            {
-                if (strcmp(vars[i], get_var_name(tree)) == 0)
-                {
-                    set_id(tree, i);
-                    return;
-                }
-            }
-            return;
-
-        case NTYPE_OPERATOR:
-            for (size_t i = 0; i < get_num_children(tree); i++)
+        for (size_t i = 0; i < ids->num_vars; i++)
+        {
+            if (ids->symbols[i] == get_var_symbol(*node))
             {
-                tree_copy_IDs(get_child(tree, i), num_vars, vars);
+                set_id(*node, i);
+                break;
             }
+        }
     }
+    return TRAVERSAL_CONTINUE;
+}
+
+void tree_copy_IDs(Node *tree, size_t num_vars, const char **vars)
+{
+    struct SymbolIDs ids = {
+        .num_vars = num_vars,
+        .symbols  = malloc_wrapper(num_vars * sizeof(Symbol))
+    };
+    for (size_t i = 0; i < num_vars; i++) ids.symbols[i] = symbol_intern(vars[i]);
+    tree_traverse(&tree, copy_IDs_pre, NULL, &ids);
+    free(ids.symbols);
+}
 
+struct SymbolReplacement {
+    Symbol symbol;
+    const Node *tree_to_copy;
+    size_t num_replaced;
+};
+
+// In post-order, since replacements must not be visited
+static TraversalAction replace_symbol_nodes_post(Node **node, __attribute__((unused)) Traversal *traversal, void *state)
+{
+    struct SymbolReplacement *replacement = state;
+    if (get_type(*node) == NTYPE_VARIABLE && get_var_symbol(*node) == replacement->symbol)
+    {
+        tree_replace(node, tree_copy(replacement->tree_to_copy));
+        replacement->num_replaced++;
+    }
+    return TRAVERSAL_CONTINUE;
 }
 
 /*
@@ -333,35 +377,54 @@ Params
 */
 size_t replace_variable_nodes(Node **tree, const Node *tree_to_copy, const char *var_name)
 {
-    switch (get_type(*tree))
+    struct SymbolReplacement replacement = { .tree_to_copy = tree_to_copy, .num_replaced = 0 };
+    if (!symbol_lookup(var_name, &replacement.symbol)) return 0;
+    tree_traverse(tree, NULL, replace_symbol_nodes_post, &replacement);
+    return replacement.num_replaced;
+}
+
+/* ~ ~ ~ ~ ~ ~ ~ ~ ~ Traversal ~ ~ ~ ~ ~ ~ ~ ~ ~ */
+
+struct Reduction {
+    TreeListener listener;
+    Vector values; // Values of subtrees that have been evaluated, but not their parents
+    ListenerError err;
+    const Node **out_errnode;
+};
+
+static TraversalAction reduce_post(Node **node, __attribute__((unused)) Traversal *traversal, void *state)
+{
+    struct Reduction *reduction = state;
+    switch (get_type(*node))
     {
         case NTYPE_CONSTANT:
-            return 0;
-        
-        case NTYPE_VARIABLE:
-            if (strcmp(var_name, get_var_name(*tree)) == 0)
-            {
-                tree_replace(tree, tree_copy(tree_to_copy));
-                return 1;
-            }
-            return 0;
+            VEC_PUSH_ELEM(&reduction->values, double, get_const_value(*node));
+            return TRAVERSAL_CONTINUE;
 
         case NTYPE_OPERATOR:
         {
-            size_t res = 0;
-            for (size_t i = 0; i < get_num_children(*tree); i++)
-            {
-                res += replace_variable_nodes(get_child_addr(*tree, i), tree_to_copy, var_name);
-            }
-            return res;
+            // Values of children are on top of the stack
+            size_t num_args = get_num_children(*node);
+            reduction->values.elem_count -= num_args;
+            double res;
+            reduction->err = reduction->listener(get_op(*node),
+                num_args,
+                vec_get(&reduction->values, vec_count(&reduction->values)),
+                &res);
+            if (reduction->err != LISTENERERR_SUCCESS) break;
+            VEC_PUSH_ELEM(&reduction->values, double, res);
+            return TRAVERSAL_CONTINUE;
         }
+
+        case NTYPE_VARIABLE:
+            reduction->err = LISTENERERR_VARIABLE_ENCOUNTERED;
+            break;
     }
 
-    return 0; // To make compiler happy
+    if (reduction->out_errnode != NULL) *reduction->out_errnode = *node;
+    return TRAVERSAL_STOP;
 }
 
-/* ~ ~ ~ ~ ~ ~ ~ ~ ~ Traversal ~ ~ ~ ~ ~ ~ ~ ~ ~ */
-
 /*
 Summary: Evaluates operator tree
 Returns: True if reduction could be applied, i.e. no variable in tree and reduction-function did not return false
@@ -372,77 +435,81 @@ Params
 */
 ListenerError tree_reduce(const Node *tree, TreeListener listener, double *out, const Node **out_errnode)
 {
-    switch (get_type(tree))
-    {
-        case NTYPE_CONSTANT:
-            *out = get_const_value(tree);
-            return LISTENERERR_SUCCESS;
-
-        case NTYPE_OPERATOR:
-        {
-            size_t num_args = get_num_children(tree);
-            double *args = malloc_wrapper(sizeof(double) * num_args);
-
-            for (size_t i = LISTENERERR_SUCCESS; i < num_args; i++)
-            {
-                ListenerError err = tree_reduce(get_child(tree, i), listener, &args[i], out_errnode);
-                if (err != LISTENERERR_SUCCESS)
-                {
-                    free(args);
-                    return err;
-                }
-            }
-
-            ListenerError err = listener(get_op(tree), num_args, args, out);
-            if (err != LISTENERERR_SUCCESS)
-            {
-                if (out_errnode != NULL) *out_errnode = tree;
-                free(args);
-                return err;
-            }
+    struct Reduction reduction = {
+        .listener    = listener,
+        .values      = vec_create(sizeof(double), REDUCTION_STACK_STARTSIZE),
+        .err         = LISTENERERR_SUCCESS,
+        .out_errnode = out_errnode
+    };
+    tree_traverse((Node**)&tree, NULL, reduce_post, &reduction);
+    if (reduction.err == LISTENERERR_SUCCESS) *out = *(double*)vec_get(&reduction.values, 0);
+    vec_destroy(&reduction.values);
+    return reduction.err;
+}
 
-            free(args);
-            return LISTENERERR_SUCCESS;
-        }
+struct ConstantReduction {
+    TreeListener listener;
+    ListenerError err;
+    const Node **out_errnode;
+};
 
-        case NTYPE_VARIABLE:
-            if (out_errnode != NULL) *out_errnode = tree;
-            return LISTENERERR_VARIABLE_ENCOUNTERED;
+static TraversalAction reduce_constant_subtrees_pre(Node **node, __attribute__((unused)) Traversal *traversal, void *state)
+{
+    struct ConstantReduction *reduction = state;
+    if (get_info(*node).num_variables != 0) return TRAVERSAL_CONTINUE;
+
+    double res;
+    reduction->err = tree_reduce(*node, reduction->listener, &res, reduction->out_errnode);
+    if (reduction->err != LISTENERERR_SUCCESS) return TRAVERSAL_STOP;
+    Node *replacement = malloc_constant_node(res, get_token_index(*node));
+    // Infos of ancestors are invalidated by traversal and refreshed on the way up
+    free_tree(*node);
+    *node = replacement;
+    return TRAVERSAL_SKIP;
+}
 
-        default:
-            return 0; // This should never happen
-    }
+static TraversalAction reduce_constant_subtrees_post(Node **node, __attribute__((unused)) Traversal *traversal, __attribute__((unused)) void *state)
+{
+    // Infos of ancestors of replaced subtrees have been invalidated by traversal, children are up to date
+    update_info(*node);
+    return TRAVERSAL_CONTINUE;
 }
 
 /*
-Summary: Replaces reducible subtrees by a ConstantNode
+Summary: Replaces reducible subtrees by a ConstantNode.
+    Linear in the size of tree, since constant subtrees are detected by cached variable counts.
 Params:
-    tree:            Tree that will be changed
+    tree:            Tree that will be changed, infos of its ancestors are not invalidated
     listener:        Compositional evaluation function
 */
 ListenerError tree_reduce_constant_subtrees(Node **tree, TreeListener listener, const Node **out_errnode)
 {
-    if (count_all_variable_nodes(*tree) == 0)
-    {
-        double res;
-        ListenerError err = tree_reduce(*tree, listener, &res, out_errnode);
-        if (err != LISTENERERR_SUCCESS) return err;
-        Node *replacement = malloc_constant_node(res, get_token_index(*tree));
-        tree_replace(tree, replacement);
-    }
-    else
+    struct ConstantReduction reduction = {
+        .listener    = listener,
+        .err         = LISTENERERR_SUCCESS,
+        .out_errnode = out_errnode
+    };
+    update_info(*tree);
+    tree_traverse(tree, reduce_constant_subtrees_pre, reduce_constant_subtrees_post, &reduction);
+    return reduction.err;
+}
+
+struct OpReduction {
+    const Operator *op;
+    OpEval callback;
+};
+
+static TraversalAction reduce_ops_post(Node **node, __attribute__((unused)) Traversal *traversal, void *state)
+{
+    struct OpReduction *reduction = state;
+    if (get_type(*node) == NTYPE_OPERATOR && get_op(*node) == reduction->op)
     {
-        if (get_type(*tree) == NTYPE_OPERATOR)
-        {
-            for (size_t i = 0; i < get_num_children(*tree); i++)
-            {
-                ListenerError err = tree_reduce_constant_subtrees(get_child_addr(*tree, i), listener, out_errnode);
-                if (err != LISTENERERR_SUCCESS) return err;
-            }
-        }
+        Node *replacement = malloc_constant_node(reduction->callback(get_num_children(*node),
+            (const Node * const *)get_child_addr(*node, 0)),
+            get_token_index(*node));
+        tree_replace(node, replacement);
     }
-
-    return LISTENERERR_SUCCESS;
+    return TRAVERSAL_CONTINUE;
 }
 
 /*
@@ -450,19 +517,6 @@ Summary: For non-compositional evaluation of operators
 */
 void tree_reduce_ops(Node **tree, const Operator *op, OpEval callback)
 {
-    if (get_type(*tree) == NTYPE_OPERATOR)
-    {
-        for (size_t i = 0; i < get_num_children(*tree); i++)
-        {
-            tree_reduce_ops(get_child_addr(*tree, i), op, callback);
-        }
-
-        if (get_op(*tree) == op)
-        {
-            Node *replacement = malloc_constant_node(callback(get_num_children(*tree),
-                (const Node * const *)get_child_addr(*tree, 0)),
-                get_token_index(*tree));
-            tree_replace(tree, replacement);
-        }
-    }
+    struct OpReduction reduction = { .op = op, .callback = callback };
+    tree_traverse(tree, NULL, reduce_ops_post, &reduction);
 }
@@ -4,7 +4,6 @@
 #define LISTENERERR_SUCCESS                0
 #define LISTENERERR_VARIABLE_ENCOUNTERED -50
 
-typedef int ListenerError;
 typedef ListenerError (*TreeListener)(const Operator *op, size_t num_children, const double *children, double *out);
 typedef double (*OpEval)(size_t num_children, const Node * const *children);
 
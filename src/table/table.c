@@ -1,5 +1,6 @@
 #include <stdarg.h>
 #include <stdio.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 #include <assert.h>
@@ -11,48 +12,62 @@
 
 #define MAX(a, b) ((a) > (b) ? (a) : (b))
 
+#define VECTOR_STARTSIZE 16
+#define ARENA_STARTSIZE  256
+
+#define CELL_IS_SET   1 // Cell holds data or is covered by a spanning cell
+#define CELL_HAS_TEXT 2 // Text is valid, cells inserted by add_empty_cell have none
+
+/*
+ * Cells are stored column-wise. A cell only holds what is needed for every cell,
+ * settings that are rarely changed live in a side table of struct CellExtra.
+ * Texts of all cells are copied into a single arena and measured once on insertion.
+ */
+
 struct Cell
 {
-    char *text;         // Actual content to be displayed
-    size_t text_height; // Number of lines
-    size_t text_width;  // Maximum width of lines
+    size_t text;     // Offset of text in arena
+    uint32_t width;  // Maximum width of lines
+    uint32_t height; // Number of lines
+    uint32_t extra;  // Index in extras + 1, 0 when cell has default settings
+    uint8_t flags;   // CELL_IS_SET, CELL_HAS_TEXT
+};
 
-    // Settings
+// Non-default settings of a single cell
+struct CellExtra
+{
     TableHAlign h_align;           // Non default, how to place text in col width
     TableVAlign v_align;           // Non default, how to place text in col width
     TableBorderStyle border_left;  // Non-default border left
     TableBorderStyle border_above; // Non-default border above
     size_t span_x;                 // How many cols to span over
     size_t span_y;                 // How many rows to span over
+    size_t parent_x;               // Position of cell that spans into this cell
+    size_t parent_y;
 
-    // Generated
     bool override_v_align;      // Default set for each col in table
     bool override_h_align;      // Default set for each col in table
     bool override_border_left;  // Default set for each col in table
     bool override_border_above; // Default set in row
-
-    bool is_set;          // Indicates whether data is valid
-    bool text_needs_free; // When set to true, text will be freed on free_table
-    size_t x;             // Column position
-    size_t y;             // Row position
-    struct Cell *parent;  // Cell that spans into this cell
+    bool has_parent;            // Cell is covered by a spanning cell
 };
 
 struct Row
 {
-    struct Cell cells[TABLE_MAX_COLS]; // All cells of this row from left to right
-    struct Row *next_row;              // Pointer to next row or NULL if last row
-    TableBorderStyle border_above;     // Default border above (can be overwritten in cell)
-    size_t border_above_counter;       // Counts cells that override their border_above
+    TableBorderStyle border_above; // Default border above (can be overwritten in cell)
+    size_t border_above_counter;   // Counts cells that override their border_above
 };
 
 struct Table
 {
-    size_t num_cols;                         // Number of columns (max. of num_cells over all rows)
-    size_t num_rows;                         // Number of rows (length of linked list)
-    struct Row *first_row;                   // Start of linked list to rows
-    struct Row *curr_row;                    // Marker of row of next inserted cell
-    size_t curr_col;                         // Marker of col of next inserted cell
+    size_t num_cols;                               // Number of columns (max. of num_cells over all rows)
+    size_t num_rows;                               // Number of rows (length of rows)
+    size_t curr_row;                               // Marker of row of next inserted cell
+    size_t curr_col;                               // Marker of col of next inserted cell
+    Vector columns[TABLE_MAX_COLS];                // Cells of each column, cells below its end are not set
+    Vector rows;                                   // Settings of each row
+    Vector extras;                                 // Settings of cells that are not default
+    StringBuilder arena;                           // Texts of all cells, each terminated by \0
     TableBorderStyle borders_left[TABLE_MAX_COLS]; // Default left border of cols
     TableHAlign h_aligns[TABLE_MAX_COLS];          // Default horizontal alignment of cols
     TableVAlign v_aligns[TABLE_MAX_COLS];          // Default vertical alignment of cols
@@ -67,6 +82,18 @@ struct Constraint
     size_t min;        // Needed size (i.e. minimum size needed)
 };
 
+static const struct Cell EMPTY_CELL = { .text = 0, .width = 0, .height = 0, .extra = 0, .flags = 0 };
+
+static const struct CellExtra DEFAULT_EXTRA = {
+    .span_x                = 1,
+    .span_y                = 1,
+    .override_h_align      = false,
+    .override_v_align      = false,
+    .override_border_left  = false,
+    .override_border_above = false,
+    .has_parent            = false
+};
+
 static char *BORDER_MATRIX_SINGLE[] = {
     "┌", "┬", "┐",
     "├", "┼", "┤",
@@ -87,23 +114,81 @@ static size_t VLINE_INDEX = 10;
 // Index encodes whether a border intersects (0: no intersection, 1: intersection), clockwise
 static size_t BORDER_LOOKUP[16] = { 11, 11, 11, 6, 11, 10, 0, 3, 11, 8, 9, 7, 2, 5, 1, 4 };
 
+// Read-only access, cells that have not been written to are empty
+static const struct Cell *peek_cell(const Table *table, size_t x, size_t y)
+{
+    if (y >= vec_count(&table->columns[x])) return &EMPTY_CELL;
+    return vec_get(&table->columns[x], y);
+}
+
+// Write access, extends column when needed. Pointer is valid until next call.
+static struct Cell *get_cell(Table *table, size_t x, size_t y)
+{
+    while (vec_count(&table->columns[x]) <= y)
+    {
+        VEC_PUSH_ELEM(&table->columns[x], struct Cell, EMPTY_CELL);
+    }
+    return vec_get(&table->columns[x], y);
+}
+
+static const struct CellExtra *peek_extra(const Table *table, size_t x, size_t y)
+{
+    const struct Cell *cell = peek_cell(table, x, y);
+    if (cell->extra == 0) return &DEFAULT_EXTRA;
+    return vec_get(&table->extras, cell->extra - 1);
+}
+
+// Creates settings when cell has default settings. Pointer is valid until next call.
+static struct CellExtra *get_extra(Table *table, size_t x, size_t y)
+{
+    struct Cell *cell = get_cell(table, x, y);
+    if (cell->extra == 0)
+    {
+        VEC_PUSH_ELEM(&table->extras, struct CellExtra, DEFAULT_EXTRA);
+        cell->extra = vec_count(&table->extras);
+    }
+    return vec_get(&table->extras, cell->extra - 1);
+}
+
 static struct Row *get_row(const Table *table, size_t index)
 {
-    struct Row *row = table->first_row;
-    while (index-- > 0 && row != NULL) row = row->next_row;
-    return row;
+    return vec_get(&table->rows, index);
 }
 
-static TableHAlign get_h_align(TableHAlign default_h, const struct Cell *cell)
+static bool is_set(const Table *table, size_t x, size_t y)
 {
-    if (cell->parent != NULL) return get_h_align(default_h, cell->parent);
-    return (cell->override_h_align ? cell->h_align : default_h);
+    return (peek_cell(table, x, y)->flags & CELL_IS_SET) != 0;
 }
 
-static TableVAlign get_v_align(TableVAlign default_v, const struct Cell *cell)
+static const char *get_text(const Table *table, const struct Cell *cell)
 {
-    if (cell->parent != NULL) return get_v_align(default_v, cell->parent);
-    return (cell->override_v_align ? cell->v_align : default_v);
+    if ((cell->flags & CELL_HAS_TEXT) == 0) return NULL;
+    return (const char*)table->arena.buffer + cell->text;
+}
+
+// Replaces position of a cell that is covered by a spanning cell with the position of the spanning cell
+static void resolve_parent(const Table *table, size_t *x, size_t *y)
+{
+    const struct CellExtra *extra = peek_extra(table, *x, *y);
+    if (extra->has_parent)
+    {
+        *x = extra->parent_x;
+        *y = extra->parent_y;
+    }
+}
+
+static TableHAlign get_h_align(const Table *table, TableHAlign default_h, size_t x, size_t y)
+{
+    resolve_parent(table, &x, &y);
+    const struct CellExtra *extra = peek_extra(table, x, y);
+    return (extra->override_h_align ? extra->h_align : default_h);
+}
+
+static TableVAlign get_v_align(const Table *table, TableVAlign default_v, size_t x, size_t y)
+{
+    resolve_parent(table, &x, &y);
+    const struct CellExtra *extra = peek_extra(table, x, y);
+    return (extra->override_v_align ? extra->v_align : default_v);
 }
 
 /*
@@ -123,35 +208,19 @@ size_t console_strlen(const char *str)
     return res;
 }
 
-// Counts number of \n in string
-static size_t get_text_height(const char *str)
-{
-    if (str == NULL) return 0;
-    size_t res = 1;
-    size_t pos = 0;
-    while (str[pos] != '\0')
-    {
-        if (str[pos] == '\n')
-        {
-            res++;
-        }
-        pos++;
-    }
-    return res;
-}
-
-static size_t get_text_width(const char *str)
+// Computes number of lines and maximum width of lines in a single pass
+static void measure_text(const char *str, size_t *out_width, size_t *out_height)
 {
-    size_t res = 0;
-    size_t height = get_text_height(str);
-    for (size_t i = 0; i < height; i++)
+    *out_width = 0;
+    *out_height = 0;
+    while (str != NULL)
     {
-        char *line;
-        get_line_of_string(str, i, &line);
-        size_t line_width = console_strlen(line);
-        if (line_width > res) res = line_width;
+        size_t line_width = console_strlen(str);
+        if (line_width > *out_width) *out_width = line_width;
+        (*out_height)++;
+        str = strchr(str, '\n');
+        if (str != NULL) str++;
     }
-    return res;
 }
 
 static void print_repeated(const char *string, size_t times, FILE *stream)
@@ -159,7 +228,9 @@ static void print_repeated(const char *string, size_t times, FILE *stream)
     for (size_t i = 0; i < times; i++) fprintf(stream, "%s", string);
 }
 
-static void print_text(const struct Cell *cell,
+static void print_text(const Table *table,
+    size_t x,
+    size_t y,
     TableHAlign default_h,
     TableVAlign default_v,
     size_t line_index,
@@ -167,32 +238,29 @@ static void print_text(const struct Cell *cell,
     size_t total_height,
     FILE *stream)
 {
-    if (cell->parent != NULL)
-    {
-        cell = cell->parent;
-    }
+    resolve_parent(table, &x, &y);
+    const struct Cell *cell = peek_cell(table, x, y);
 
     // First, select actual line that needs to be printed based on vertical alignment
     int actual_line = 0;
-    switch (get_v_align(default_v, cell))
+    switch (get_v_align(table, default_v, x, y))
     {
         case V_ALIGN_TOP:
             actual_line = line_index;
             break;
         case V_ALIGN_CENTER:
-            actual_line = line_index - (total_height - cell->text_height) / 2;
-            //printf("~~%zu~~", total_height);
+            actual_line = line_index - (total_height - cell->height) / 2;
             break;
         case V_ALIGN_BOTTOM:
-            actual_line = line_index - (total_height - cell->text_height);
+            actual_line = line_index - (total_height - cell->height);
     }
 
     char *string = NULL;
     int bytes = 0;
-    
+
     if (actual_line >= 0)
     {
-        bytes = get_line_of_string(cell->text, actual_line, &string);
+        bytes = get_line_of_string(get_text(table, cell), actual_line, &string);
     }
 
     if (string == NULL)
@@ -206,7 +274,7 @@ static void print_text(const struct Cell *cell,
     int string_length = console_strlen(string);
     int adjusted_total_len = total_width + bytes - string_length;
 
-    switch (get_h_align(default_h, cell))
+    switch (get_h_align(table, default_h, x, y))
     {
         case H_ALIGN_LEFT:
         {
@@ -228,51 +296,43 @@ static void print_text(const struct Cell *cell,
     }
 }
 
-static size_t get_total_width(const Table *table, const size_t *col_widths, struct Cell *cell)
+static size_t get_total_width(const Table *table, const size_t *col_widths, size_t x, size_t y)
 {
-    if (cell->parent != NULL) cell = cell->parent;
+    resolve_parent(table, &x, &y);
 
     size_t sum = 0;
-    for (size_t i = 0; i < cell->span_x; i++)
+    for (size_t i = 0; i < peek_extra(table, x, y)->span_x; i++)
     {
-        if (i != 0 && table->border_left_counters[cell->x + i + 1] > 0) sum++;
-        sum += col_widths[cell->x + i];
+        if (i != 0 && table->border_left_counters[x + i + 1] > 0) sum++;
+        sum += col_widths[x + i];
     }
     return sum;
 }
 
-static size_t get_total_height(const Table *table, const size_t *row_heights, struct Cell *cell)
+static size_t get_total_height(const Table *table, const size_t *row_heights, size_t x, size_t y)
 {
-    if (cell->parent != NULL) cell = cell->parent;
+    resolve_parent(table, &x, &y);
 
     size_t sum = 0;
-    struct Row *curr_row = get_row(table, cell->y);
-    for (size_t i = 0; i < cell->span_y; i++)
+    for (size_t i = 0; i < peek_extra(table, x, y)->span_y; i++)
     {
-        if (i != 0 && curr_row->border_above_counter > 0) sum++;
-        sum += row_heights[cell->y + i];
-        curr_row = curr_row->next_row;
+        if (i != 0 && get_row(table, y + i)->border_above_counter > 0) sum++;
+        sum += row_heights[y + i];
     }
     return sum;
 }
 
-static size_t get_span_x(struct Cell *cell)
+static size_t get_span_x(const Table *table, size_t x, size_t y)
 {
-    if (cell->parent != NULL)
-    {
-        return cell->parent->span_x;
-    }
-    else
-    {
-        return cell->span_x;
-    }
+    resolve_parent(table, &x, &y);
+    return peek_extra(table, x, y)->span_x;
 }
 
-static TableBorderStyle get_border_above(TableBorderStyle default_style, const struct Cell *cell)
+static TableBorderStyle get_border_above(TableBorderStyle default_style, const struct CellExtra *extra)
 {
-    if (cell->override_border_above)
+    if (extra->override_border_above)
     {
-        return cell->border_above;
+        return extra->border_above;
     }
     else
     {
@@ -280,11 +340,11 @@ static TableBorderStyle get_border_above(TableBorderStyle default_style, const s
     }
 }
 
-static TableBorderStyle get_border_left(TableBorderStyle default_style, const struct Cell *cell)
+static TableBorderStyle get_border_left(TableBorderStyle default_style, const struct CellExtra *extra)
 {
-    if (cell->override_border_left)
+    if (extra->override_border_left)
     {
-        return cell->border_left;
+        return extra->border_left;
     }
     else
     {
@@ -301,9 +361,9 @@ static void count_styles(TableBorderStyle style, size_t *out_num_single, size_t
 static void print_intersection_char(
     TableBorderStyle default_right_border_left,
     TableBorderStyle default_below_border_above,
-    struct Cell *right_above,
-    struct Cell *left_below,
-    struct Cell *right_below,
+    const struct CellExtra *right_above,
+    const struct CellExtra *left_below,
+    const struct CellExtra *right_below,
     FILE *stream)
 {
     size_t num_single = 0;
@@ -365,31 +425,33 @@ static void print_intersection_char(
     }
 }
 
-// Above row can be NULL, below row must not be NULL!
+// Prints border above row y
 static void print_row_border(Table *table,
-    struct Row *above_row,
-    struct Row *below_row,
+    size_t y,
     size_t *line_indices,
     size_t *col_widths,
     size_t *row_heights,
     FILE *stream)
 {
+    TableBorderStyle row_border = get_row(table, y)->border_above;
     for (size_t i = 0; i < table->num_cols; i++)
     {
+        const struct CellExtra *extra = peek_extra(table, i, y);
+
         // Print vline-hline intersection
         if (table->border_left_counters[i] > 0)
         {
             print_intersection_char(table->borders_left[i],
-                below_row->border_above,
-                above_row != NULL ? &above_row->cells[i] : NULL,
-                i > 0 ? &below_row->cells[i - 1] : NULL,
-                &below_row->cells[i], stream);
+                row_border,
+                y > 0 ? peek_extra(table, i, y - 1) : NULL,
+                i > 0 ? peek_extra(table, i - 1, y) : NULL,
+                extra, stream);
         }
 
         // Print hline in between intersections (or content when cell has span_y > 1)
-        if (below_row->cells[i].parent == NULL || below_row->cells[i].parent->y == below_row->cells[i].y)
+        if (!extra->has_parent || extra->parent_y == y)
         {
-            switch (get_border_above(below_row->border_above, &below_row->cells[i]))
+            switch (get_border_above(row_border, extra))
             {
                 case BORDER_SINGLE:
                     print_repeated(BORDER_MATRIX_SINGLE[HLINE_INDEX], col_widths[i], stream);
@@ -403,16 +465,19 @@ static void print_row_border(Table *table,
         }
         else
         {
-            struct Cell *parent = below_row->cells[i].parent;
-            print_text(parent,
+            size_t parent_x = extra->parent_x;
+            size_t parent_y = extra->parent_y;
+            print_text(table,
+                parent_x,
+                parent_y,
                 table->h_aligns[i],
                 table->v_aligns[i],
                 line_indices[i],
-                get_total_width(table, col_widths, parent),
-                get_total_height(table, row_heights, parent),
+                get_total_width(table, col_widths, parent_x, parent_y),
+                get_total_height(table, row_heights, parent_x, parent_y),
                 stream);
             line_indices[i]++;
-            i += parent->span_x - 1;
+            i += peek_extra(table, parent_x, parent_y)->span_x - 1;
         }
     }
     fprintf(stream, "\n");
@@ -423,25 +488,14 @@ static void override_superfluous_lines(Table *table, size_t last_col_width, size
     // Special cases: If last row/col is empty, delete all vlines/hlines in it
     if (last_col_width == 0)
     {
-        struct Row *row = table->first_row;
         table->curr_col = table->num_cols - 1;
-        while (row != NULL)
+        for (size_t i = 0; i < table->num_rows; i++)
         {
-            table->curr_row = row;
+            table->curr_row = i;
             override_above_border(table, BORDER_NONE);
-            row = row->next_row;
-        }
-    }
-    else
-    {
-        struct Row *row = table->first_row;
-        while (row != NULL)
-        {
-            table->curr_row = row;
-            row = row->next_row;
         }
     }
-    // table->curr_row is last row now
+    table->curr_row = table->num_rows - 1;
     if (last_row_height == 0)
     {
         for (size_t i = 0; i < table->num_cols; i++)
@@ -452,89 +506,50 @@ static void override_superfluous_lines(Table *table, size_t last_col_width, size
     }
 }
 
-static void add_text_cell(Table *table, char *text, bool needs_free)
+// Sets current cell to text that has been appended to arena last (if any) and moves on to next unset cell
+static void set_curr_cell(Table *table, bool has_text, size_t offset)
 {
-    struct Cell *cell = &table->curr_row->cells[table->curr_col];
-    cell->is_set = true;
-    cell->text_needs_free = needs_free;
-    cell->text = text;
-    cell->text_height = get_text_height(text);
-    cell->text_width = get_text_width(text);
+    assert(table->curr_col < TABLE_MAX_COLS);
+
+    struct Cell *cell = get_cell(table, table->curr_col, table->curr_row);
+    cell->flags = CELL_IS_SET;
+    if (has_text)
+    {
+        // Keep \0 of text when next text is appended
+        VEC_PUSH_ELEM(&table->arena, char, '\0');
+
+        size_t width, height;
+        measure_text((const char*)table->arena.buffer + offset, &width, &height);
+        cell = get_cell(table, table->curr_col, table->curr_row);
+        cell->flags |= CELL_HAS_TEXT;
+        cell->text = offset;
+        cell->width = width;
+        cell->height = height;
+    }
 
     if (table->curr_col >= table->num_cols)
     {
         table->num_cols = table->curr_col + 1;
     }
 
-    while (table->curr_col != TABLE_MAX_COLS && table->curr_row->cells[table->curr_col].is_set)
+    while (table->curr_col != TABLE_MAX_COLS && is_set(table, table->curr_col, table->curr_row))
     {
         table->curr_col++;
     }
 }
 
-static void override_h_align_internal(struct Cell *cell, TableHAlign h_align)
+// Copies text into arena, NULL for an empty cell
+static void add_text_cell(Table *table, const char *text)
 {
-    cell->h_align = h_align;
-    cell->override_h_align = true;
+    size_t offset = vec_count(&table->arena) - 1;
+    if (text != NULL) strbuilder_append(&table->arena, "%s", text);
+    set_curr_cell(table, text != NULL, offset);
 }
 
-static void override_v_align_internal(struct Cell *cell, TableVAlign v_align)
+static void append_row(Table *table)
 {
-    cell->v_align = v_align;
-    cell->override_v_align = true;
-}
-
-static struct Row *malloc_row(size_t y)
-{
-    struct Row *res = calloc_wrapper(1, sizeof(struct Row));
-    if (res == NULL) return NULL;
-    for (size_t i = 0; i < TABLE_MAX_COLS; i++)
-    {
-        res->cells[i] = (struct Cell){
-            .is_set                = false,
-            .x                     = i,
-            .y                     = y,
-            .parent                = NULL,
-            .text                  = NULL,
-            .override_h_align      = false,
-            .override_v_align      = false,
-            .override_border_left  = false,
-            .override_border_above = false,
-            .span_x                = 1,
-            .span_y                = 1,
-            .text_needs_free       = false
-        };
-    }
-    return res;
-}
-
-static struct Row *append_row(Table *table)
-{
-    struct Row *row = table->curr_row;
-    while (row->next_row != NULL)
-    {
-        row = row->next_row;
-    }
-    row->next_row = malloc_row(table->num_rows);
+    VEC_PUSH_ELEM(&table->rows, struct Row, ((struct Row){ .border_above = BORDER_NONE, .border_above_counter = 0 }));
     table->num_rows++;
-    return row->next_row;
-}
-
-static struct Cell *get_curr_cell(Table *table)
-{
-    return &table->curr_row->cells[table->curr_col];
-}
-
-static void free_row(Table *table, struct Row *row)
-{
-    for (size_t i = 0; i < table->num_cols; i++)
-    {
-        if (row->cells[i].text_needs_free)
-        {
-            free(row->cells[i].text);
-        }
-    }
-    free(row);
 }
 
 static size_t needed_to_satisfy(struct Constraint *constr, size_t *vars)
@@ -585,19 +600,19 @@ void get_dimensions(Table *table, size_t *out_col_widths, size_t *out_row_height
 {
     struct Constraint *constrs = malloc_wrapper(table->num_cols * table->num_rows * sizeof(struct Constraint));
     // Satisfy constraints of width
-    struct Row *curr_row = table->first_row;
     size_t index = 0;
-    while (curr_row != NULL)
+    for (size_t y = 0; y < table->num_rows; y++)
     {
         for (size_t i = 0; i < table->num_cols; i++)
         {
             // Build constraints for set parent cells
-            if (curr_row->cells[i].is_set && curr_row->cells[i].parent == NULL)
+            const struct CellExtra *extra = peek_extra(table, i, y);
+            if (is_set(table, i, y) && !extra->has_parent)
             {
-                size_t min = curr_row->cells[i].text_width;
+                size_t min = peek_cell(table, i, y)->width;
 
                 // Constraint can be weakened when vlines are in between
-                for (size_t j = i + 1; j < i + curr_row->cells[i].span_x; j++)
+                for (size_t j = i + 1; j < i + extra->span_x; j++)
                 {
                     if (min == 0) break;
                     if (table->border_left_counters[j] > 0) min--;
@@ -606,47 +621,41 @@ void get_dimensions(Table *table, size_t *out_col_widths, size_t *out_row_height
                 constrs[index] = (struct Constraint){
                     .min        = min,
                     .from_index = i,
-                    .to_index   = i + curr_row->cells[i].span_x
+                    .to_index   = i + extra->span_x
                 };
                 index++;
             }
         }
-        curr_row = curr_row->next_row;
     }
     for (size_t i = 0; i < table->num_cols; i++) out_col_widths[i] = 0;
     satisfy_constraints(index, constrs, out_col_widths);
 
     // Satisfy constraints of height
-    curr_row = table->first_row;
     index = 0;
-    size_t row_index = 0;
-    while (curr_row != NULL)
+    for (size_t y = 0; y < table->num_rows; y++)
     {
         for (size_t i = 0; i < table->num_cols; i++)
         {
-            if (curr_row->cells[i].is_set && curr_row->cells[i].parent == NULL)
+            const struct CellExtra *extra = peek_extra(table, i, y);
+            if (is_set(table, i, y) && !extra->has_parent)
             {
-                size_t min = curr_row->cells[i].text_height;
-                struct Row *row_checked_for_hline = curr_row->next_row;
+                size_t min = peek_cell(table, i, y)->height;
 
                 // Constraint can be weakened when hlines are in between
-                for (size_t j = i + 1; j < i + curr_row->cells[i].span_y; j++)
+                for (size_t j = 1; j < extra->span_y; j++)
                 {
-                    if (row_checked_for_hline == NULL || min == 0) break;
-                    if (row_checked_for_hline->border_above_counter > 0) min--;
-                    row_checked_for_hline = row_checked_for_hline->next_row;
+                    if (y + j >= table->num_rows || min == 0) break;
+                    if (get_row(table, y + j)->border_above_counter > 0) min--;
                 }
 
                 constrs[index] = (struct Constraint){
                     .min        = min,
-                    .from_index = row_index,
-                    .to_index   = row_index + curr_row->cells[i].span_y
+                    .from_index = y,
+                    .to_index   = y + extra->span_y
                 };
                 index++;
             }
         }
-        curr_row = curr_row->next_row;
-        row_index++;
     }
     for (size_t i = 0; i < table->num_rows; i++) out_row_heights[i] = 0;
     satisfy_constraints(index, constrs, out_row_heights);
@@ -661,36 +670,38 @@ Returns: A new table with a single, empty row.
 Table *get_empty_table()
 {
     Table *res = malloc_wrapper(sizeof(Table));
-    struct Row *first_row = malloc_row(0);
     *res = (Table){
         .num_cols             = 0,
+        .num_rows             = 0,
         .curr_col             = 0,
-        .first_row            = first_row,
-        .curr_row             = first_row,
-        .num_rows             = 1,
+        .curr_row             = 0,
+        .rows                 = vec_create(sizeof(struct Row), VECTOR_STARTSIZE),
+        .extras               = vec_create(sizeof(struct CellExtra), VECTOR_STARTSIZE),
+        .arena                = strbuilder_create(ARENA_STARTSIZE),
         .h_aligns             = { H_ALIGN_LEFT },
         .v_aligns             = { V_ALIGN_TOP },
         .borders_left         = { BORDER_NONE },
         .border_left_counters = { 0 }
     };
+    for (size_t i = 0; i < TABLE_MAX_COLS; i++)
+    {
+        res->columns[i] = vec_create(sizeof(struct Cell), VECTOR_STARTSIZE);
+    }
+    append_row(res);
     return res;
 }
 
 /*
-Summary: Frees all rows and content strings in cells created by add_cell_fmt.
-    Don't use the table any more, get a new one!
+Summary: Frees all cells and their texts. Don't use the table any more, get a new one!
 */
 void free_table(Table *table)
 {
     assert(table != NULL);
 
-    struct Row *row = table->first_row;
-    while (row != NULL)
-    {
-        struct Row *next_row = row->next_row;
-        free_row(table, row);
-        row = next_row;
-    }
+    for (size_t i = 0; i < TABLE_MAX_COLS; i++) vec_destroy(&table->columns[i]);
+    vec_destroy(&table->rows);
+    vec_destroy(&table->extras);
+    vec_destroy(&table->arena);
     free(table);
 }
 
@@ -700,17 +711,11 @@ void set_position(Table *table, size_t x, size_t y)
     assert(x < TABLE_MAX_COLS);
 
     table->curr_col = x;
-    if (y < table->num_rows)
+    while (y >= table->num_rows)
     {
-        table->curr_row = get_row(table, y);
-    }
-    else
-    {
-        while (y >= table->num_rows)
-        {
-            table->curr_row = append_row(table);
-        }
+        append_row(table);
     }
+    table->curr_row = y;
 }
 
 /*
@@ -720,16 +725,17 @@ void next_row(Table *table)
 {
     assert(table != NULL);
 
-    // Extend linked list if necessary
+    // Extend table if necessary
     table->curr_col = 0;
-    if (table->curr_row->next_row == NULL)
+    if (table->curr_row + 1 == table->num_rows)
     {
-        table->curr_row = append_row(table);
+        append_row(table);
+        table->curr_row++;
     }
     else
     {
-        table->curr_row = table->curr_row->next_row;
-        while (table->curr_col < TABLE_MAX_COLS && table->curr_row->cells[table->curr_col].is_set)
+        table->curr_row++;
+        while (table->curr_col < TABLE_MAX_COLS && is_set(table, table->curr_col, table->curr_row))
         {
             table->curr_col++;
         }
@@ -737,12 +743,11 @@ void next_row(Table *table)
 }
 
 /*
-Summary: Adds next cell. Buffer is not copied. print_table will access it.
-    Ensure that lifetime of buffer outlasts last call of print_table!
+Summary: Adds next cell. Text is copied, buffer can be freed afterwards.
 */
 void add_cell(Table *table, const char *text)
 {
-    add_text_cell(table, (char*)text, false);
+    add_text_cell(table, text);
 }
 
 void add_cells(Table *table, size_t num_cells, ...)
@@ -757,21 +762,21 @@ void add_cells(Table *table, size_t num_cells, ...)
 }
 
 /*
-Summary: Same as add_cell, but frees buffer on reset
+Summary: Same as add_cell, but frees buffer
 */
 void add_cell_gc(Table *table, char *text)
 {
-    add_text_cell(table, text, true);
+    add_text_cell(table, text);
+    free(text);
 }
 
 void add_empty_cell(Table *table)
 {
-    add_text_cell(table, NULL, false);
+    add_text_cell(table, NULL);
 }
 
 /*
-Summary: Adds next cell and maintains buffer of text.
-    Use add_cell to save memory if you maintain a content string yourself.
+Summary: Adds next cell, text is formatted directly into the table
 */
 void add_cell_fmt(Table *table, const char *fmt, ...)
 {
@@ -783,14 +788,13 @@ void add_cell_fmt(Table *table, const char *fmt, ...)
 
 void add_cell_vfmt(Table *table, const char *fmt, va_list args)
 {
-    StringBuilder builder = strbuilder_create(0);
-    vstrbuilder_append(&builder, fmt, args);
-    add_text_cell(table, builder.buffer, true);
+    size_t offset = vec_count(&table->arena) - 1;
+    vstrbuilder_append(&table->arena, fmt, args);
+    set_curr_cell(table, true, offset);
 }
 
 /*
 Summary: Puts contents of memory-contiguous 2D array into table cell by cell.
-    Strings are not copied. Ensure that lifetime of array outlasts last call of print_table.
     Position of next insertion is first cell in next row.
 */
 void add_cells_from_array(Table *table, size_t width, size_t height, const char **array)
@@ -826,13 +830,17 @@ Summary: Overrides alignment of current cell
 void override_horizontal_alignment(Table *table, TableHAlign h_align)
 {
     assert(table != NULL);
-    override_h_align_internal(get_curr_cell(table), h_align);
+    struct CellExtra *extra = get_extra(table, table->curr_col, table->curr_row);
+    extra->h_align = h_align;
+    extra->override_h_align = true;
 }
 
 void override_vertical_alignment(Table *table, TableVAlign v_align)
 {
     assert(table != NULL);
-    override_v_align_internal(get_curr_cell(table), v_align);
+    struct CellExtra *extra = get_extra(table, table->curr_col, table->curr_row);
+    extra->v_align = v_align;
+    extra->override_v_align = true;
 }
 
 /*
@@ -843,7 +851,9 @@ void override_horizontal_alignment_of_row(Table *table, TableHAlign h_align)
     assert(table != NULL);
     for (size_t i = 0; i < TABLE_MAX_COLS; i++)
     {
-        override_h_align_internal(&table->curr_row->cells[i], h_align);
+        struct CellExtra *extra = get_extra(table, i, table->curr_row);
+        extra->h_align = h_align;
+        extra->override_h_align = true;
     }
 }
 
@@ -852,22 +862,25 @@ void override_vertical_alignment_of_row(Table *table, TableVAlign v_align)
     assert(table != NULL);
     for (size_t i = 0; i < TABLE_MAX_COLS; i++)
     {
-        override_v_align_internal(&table->curr_row->cells[i], v_align);
+        struct CellExtra *extra = get_extra(table, i, table->curr_row);
+        extra->v_align = v_align;
+        extra->override_v_align = true;
     }
 }
 
 void set_hline(Table *table, TableBorderStyle style)
 {
     assert(table != NULL);
-    if (table->curr_row->border_above != BORDER_NONE)
+    struct Row *row = get_row(table, table->curr_row);
+    if (row->border_above != BORDER_NONE)
     {
-        table->curr_row->border_above_counter--;
+        row->border_above_counter--;
     }
     if (style != BORDER_NONE)
     {
-        table->curr_row->border_above_counter++;
+        row->border_above_counter++;
     }
-    table->curr_row->border_above = style;
+    row->border_above = style;
 }
 
 void set_vline(Table *table, size_t index, TableBorderStyle style)
@@ -906,7 +919,8 @@ void override_left_border(Table *table, TableBorderStyle style)
 {
     assert(table != NULL);
 
-    if (get_curr_cell(table)->override_border_left && get_curr_cell(table)->border_left != BORDER_NONE)
+    struct CellExtra *extra = get_extra(table, table->curr_col, table->curr_row);
+    if (extra->override_border_left && extra->border_left != BORDER_NONE)
     {
         table->border_left_counters[table->curr_col]--;
     }
@@ -915,25 +929,27 @@ void override_left_border(Table *table, TableBorderStyle style)
         table->border_left_counters[table->curr_col]++;
     }
 
-    get_curr_cell(table)->border_left = style;
-    get_curr_cell(table)->override_border_left = true;
+    extra->border_left = style;
+    extra->override_border_left = true;
 }
 
 void override_above_border(Table *table, TableBorderStyle style)
 {
     assert(table != NULL);
 
-    if (get_curr_cell(table)->override_border_above && get_curr_cell(table)->border_above != BORDER_NONE)
+    struct Row *row = get_row(table, table->curr_row);
+    struct CellExtra *extra = get_extra(table, table->curr_col, table->curr_row);
+    if (extra->override_border_above && extra->border_above != BORDER_NONE)
     {
-        table->curr_row->border_above_counter--;
+        row->border_above_counter--;
     }
     if (style != BORDER_NONE)
     {
-        table->curr_row->border_above_counter++;
+        row->border_above_counter++;
     }
 
-    get_curr_cell(table)->border_above = style;
-    get_curr_cell(table)->override_border_above = true;
+    extra->border_above = style;
+    extra->override_border_above = true;
 }
 
 /*
@@ -946,28 +962,28 @@ void set_span(Table *table, size_t span_x, size_t span_y)
     assert(span_x != 0);
     assert(span_y != 0);
     assert(table->curr_col + span_x <= TABLE_MAX_COLS);
-    struct Cell *cell = &table->curr_row->cells[table->curr_col];
-    assert(cell->span_x == 1);
-    assert(cell->span_y == 1);
+    size_t x = table->curr_col;
+    size_t y = table->curr_row;
+    assert(peek_extra(table, x, y)->span_x == 1);
+    assert(peek_extra(table, x, y)->span_y == 1);
 
-    cell->span_x = span_x;
-    cell->span_y = span_y;
-    table->num_cols = MAX(table->curr_col + span_x, table->num_cols);
+    table->num_cols = MAX(x + span_x, table->num_cols);
 
     // Inserts rows and sets child cells
-    struct Row *row = table->curr_row;
     for (size_t i = 0; i < span_y; i++)
     {
         for (size_t j = 0; j < span_x; j++)
         {
             if (i == 0 && j == 0) continue;
-            struct Cell *child = &row->cells[cell->x + j];
 
-            if (!child->is_set)
+            if (!is_set(table, x + j, y + i))
             {
-                child->is_set = true;
-                child->parent = cell;
-                
+                get_cell(table, x + j, y + i)->flags |= CELL_IS_SET;
+                struct CellExtra *child = get_extra(table, x + j, y + i);
+                child->has_parent = true;
+                child->parent_x = x;
+                child->parent_y = y;
+
                 if (j != 0)
                 {
                     child->border_left = BORDER_NONE;
@@ -982,21 +998,22 @@ void set_span(Table *table, size_t span_x, size_t span_y)
             else
             {
                 // Span clashes with already set cell, truncate it and finalize method
-                cell->span_y = i;
-                cell->span_x = j;
-                return;
+                span_y = i;
+                span_x = j;
+                break;
             }
         }
+        if (i == span_y) break;
 
-        if (i + 1 < span_y && row->next_row == NULL)
+        if (i + 1 < span_y && y + i + 1 == table->num_rows)
         {
-            row = append_row(table);
-        }
-        else
-        {
-            row = row->next_row;
+            append_row(table);
         }
     }
+
+    struct CellExtra *extra = get_extra(table, x, y);
+    extra->span_x = span_x;
+    extra->span_y = span_y;
 }
 
 void set_all_vlines(Table *table, TableBorderStyle style)
@@ -1050,7 +1067,7 @@ void fprint_table(Table *table, FILE *stream)
     size_t *row_heights = malloc_wrapper(table->num_rows * sizeof(size_t));
     get_dimensions(table, col_widths, row_heights);
     override_superfluous_lines(table, col_widths[table->num_cols - 1], row_heights[table->num_rows - 1]);
-    
+
     //#ifdef DEBUG
     //print_debug(table);
     //#endif
@@ -1059,33 +1076,31 @@ void fprint_table(Table *table, FILE *stream)
     for (size_t i = 0; i < table->num_cols; i++) line_indices[i] = 0;
 
     // Print rows
-    struct Row *prev_row = NULL;
-    struct Row *curr_row = table->first_row;
-    size_t row_index = 0;
-    while (curr_row != NULL)
+    for (size_t y = 0; y < table->num_rows; y++)
     {
-        if (curr_row->border_above_counter > 0)
+        if (get_row(table, y)->border_above_counter > 0)
         {
-            print_row_border(table, prev_row, curr_row, line_indices, col_widths, row_heights, stream);
+            print_row_border(table, y, line_indices, col_widths, row_heights, stream);
         }
 
         // Reset line indices for newly beginning cells, don't reset them for cells that are children spanning from above
         for (size_t j = 0; j < table->num_cols; j++)
         {
-            if (curr_row->cells[j].parent == NULL || curr_row->cells[j].y == curr_row->cells[j].parent->y)
+            const struct CellExtra *extra = peek_extra(table, j, y);
+            if (!extra->has_parent || extra->parent_y == y)
             {
                 line_indices[j] = 0;
             }
         }
 
-        for (size_t j = 0; j < row_heights[row_index]; j++)
+        for (size_t j = 0; j < row_heights[y]; j++)
         {
             // Print cell
-            for (size_t k = 0; k < table->num_cols; k += get_span_x(&curr_row->cells[k]))
+            for (size_t k = 0; k < table->num_cols; k += get_span_x(table, k, y))
             {
                 if (table->border_left_counters[k] > 0)
                 {
-                    switch (get_border_left(table->borders_left[k], &curr_row->cells[k]))
+                    switch (get_border_left(table->borders_left[k], peek_extra(table, k, y)))
                     {
                         case BORDER_SINGLE:
                             fprintf(stream, "%s", BORDER_MATRIX_SINGLE[VLINE_INDEX]);
@@ -1098,23 +1113,21 @@ void fprint_table(Table *table, FILE *stream)
                     }
                 }
 
-                print_text(&curr_row->cells[k],
+                print_text(table,
+                    k,
+                    y,
                     table->h_aligns[k],
                     table->v_aligns[k],
                     line_indices[k],
-                    get_total_width(table, col_widths, &curr_row->cells[k]),
-                    get_total_height(table, row_heights, &curr_row->cells[k]),
+                    get_total_width(table, col_widths, k, y),
+                    get_total_height(table, row_heights, k, y),
                     stream);
-                
+
                 line_indices[k]++;
             }
 
             fprintf(stream, "\n");
         }
-
-        row_index++;
-        prev_row = curr_row;
-        curr_row = curr_row->next_row;
     }
 
     free(row_heights);
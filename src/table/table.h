@@ -61,3 +61,6 @@ void set_all_vlines(Table *table, TableBorderStyle style);
 void override_left_border(Table *table, TableBorderStyle style);
 void override_above_border(Table *table, TableBorderStyle style);
 void set_span(Table *table, size_t span_x, size_t span_y);
+
+// Utility
+size_t console_strlen(const char *str);
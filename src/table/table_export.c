@@ -0,0 +1,198 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <assert.h>
+
+#include "../util/alloc_wrappers.h"
+#include "table.h"
+#include "table_export.h"
+
+#define FILE_BUFFER_SIZE (1 << 20) // Bytes buffered before they are written to file
+#define F64_BATCH_SIZE   4096      // Doubles interleaved before they are passed to file
+#define EXPORT_NUM_FMT   "%.17g"   // Round-trips every double
+
+struct TableExport
+{
+    FILE *file;
+    char *file_buffer;
+    ExportFormat format;
+    size_t num_cols;
+    bool swap_bytes; // Host is not little-endian
+};
+
+static const char *EXTENSIONS[] = { ".csv", ".tsv", ".f64" };
+
+static bool is_little_endian()
+{
+    uint16_t probe = 1;
+    return *(uint8_t*)&probe == 1;
+}
+
+static double to_little_endian(double value)
+{
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    uint8_t bytes[sizeof(bits)];
+    for (size_t i = 0; i < sizeof(bits); i++) bytes[i] = (uint8_t)(bits >> (8 * i));
+    memcpy(&value, bytes, sizeof(value));
+    return value;
+}
+
+static char get_separator(const TableExport *export)
+{
+    return export->format == EXPORT_CSV ? ',' : '\t';
+}
+
+// Quotes CSV fields that contain separators, quotes or line breaks
+static void print_field(const TableExport *export, const char *field)
+{
+    if (export->format != EXPORT_CSV || strpbrk(field, ",\"\n") == NULL)
+    {
+        fputs(field, export->file);
+        return;
+    }
+
+    fputc('"', export->file);
+    for (const char *c = field; *c != '\0'; c++)
+    {
+        if (*c == '"') fputc('"', export->file);
+        fputc(*c, export->file);
+    }
+    fputc('"', export->file);
+}
+
+static void print_value(const TableExport *export, double value)
+{
+    // printf may print a sign for NaN
+    if (isnan(value))
+    {
+        fputs("nan", export->file);
+    }
+    else
+    {
+        fprintf(export->file, EXPORT_NUM_FMT, value);
+    }
+}
+
+static void write_f64(TableExport *export, size_t num_rows, const double **columns)
+{
+    double batch[F64_BATCH_SIZE];
+    size_t count = 0;
+    for (size_t i = 0; i < num_rows; i++)
+    {
+        for (size_t j = 0; j < export->num_cols; j++)
+        {
+            batch[count++] = export->swap_bytes ? to_little_endian(columns[j][i]) : columns[j][i];
+        }
+
+        // Whole rows are interleaved, so flush when next row does not fit
+        if (count + export->num_cols > F64_BATCH_SIZE)
+        {
+            fwrite(batch, sizeof(double), count, export->file);
+            count = 0;
+        }
+    }
+    fwrite(batch, sizeof(double), count, export->file);
+}
+
+// ~ ~ ~ ~ ~ ~ ~ ~ ~ ~ User-functions ~ ~ ~ ~ ~ ~ ~ ~ ~ ~
+
+/*
+Summary: Determines format by extension of path (.csv, .tsv or .f64)
+Returns: False if extension is not supported
+*/
+bool export_format_from_path(const char *path, ExportFormat *out_format)
+{
+    const char *extension = strrchr(path, '.');
+    if (extension == NULL) return false;
+
+    for (size_t i = 0; i < sizeof(EXTENSIONS) / sizeof(EXTENSIONS[0]); i++)
+    {
+        if (strcmp(extension, EXTENSIONS[i]) == 0)
+        {
+            *out_format = (ExportFormat)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+/*
+Summary: Creates or truncates file at path
+Returns: NULL if file could not be opened, errno is set in this case
+*/
+TableExport *open_table_export(const char *path, ExportFormat format, size_t num_cols)
+{
+    assert(num_cols > 0 && num_cols <= TABLE_MAX_COLS);
+
+    FILE *file = fopen(path, format == EXPORT_F64 ? "wb" : "w");
+    if (file == NULL) return NULL;
+
+    TableExport *res = malloc_wrapper(sizeof(TableExport));
+    *res = (TableExport){
+        .file        = file,
+        .file_buffer = malloc_wrapper(FILE_BUFFER_SIZE),
+        .format      = format,
+        .num_cols    = num_cols,
+        .swap_bytes  = !is_little_endian()
+    };
+    setvbuf(file, res->file_buffer, _IOFBF, FILE_BUFFER_SIZE);
+    return res;
+}
+
+/*
+Summary: Flushes buffer, closes file and frees export
+Returns: False if any write failed
+*/
+bool close_table_export(TableExport *export)
+{
+    assert(export != NULL);
+
+    bool success = !ferror(export->file);
+    if (fclose(export->file) != 0) success = false;
+    free(export->file_buffer);
+    free(export);
+    return success;
+}
+
+/*
+Summary: Writes names of columns as first line, ignored for F64
+*/
+void export_header(TableExport *export, const char **names)
+{
+    assert(export != NULL);
+    if (export->format == EXPORT_F64) return;
+
+    for (size_t i = 0; i < export->num_cols; i++)
+    {
+        if (i != 0) fputc(get_separator(export), export->file);
+        print_field(export, names[i]);
+    }
+    fputc('\n', export->file);
+}
+
+/*
+Params
+    columns: Array of num_cols columns of num_rows values each
+*/
+void export_rows(TableExport *export, size_t num_rows, const double **columns)
+{
+    assert(export != NULL);
+
+    if (export->format == EXPORT_F64)
+    {
+        write_f64(export, num_rows, columns);
+        return;
+    }
+
+    for (size_t i = 0; i < num_rows; i++)
+    {
+        for (size_t j = 0; j < export->num_cols; j++)
+        {
+            if (j != 0) fputc(get_separator(export), export->file);
+            print_value(export, columns[j][i]);
+        }
+        fputc('\n', export->file);
+    }
+}
@@ -0,0 +1,26 @@
+#pragma once
+#include <stdbool.h>
+#include <stdlib.h>
+
+/*
+ * Writes numeric rows to a file for other tools, without any layout.
+ * CSV and TSV contain an optional header line and one line per row with values printed exactly (%.17g).
+ * F64 is a raw stream of little-endian doubles, row after row, without header.
+ * Rows are passed column-wise in batches and written through a large buffer.
+ */
+
+typedef enum
+{
+    EXPORT_CSV,
+    EXPORT_TSV,
+    EXPORT_F64
+} ExportFormat;
+
+typedef struct TableExport TableExport;
+
+bool export_format_from_path(const char *path, ExportFormat *out_format);
+TableExport *open_table_export(const char *path, ExportFormat format, size_t num_cols);
+bool close_table_export(TableExport *export);
+
+void export_header(TableExport *export, const char **names);
+void export_rows(TableExport *export, size_t num_rows, const double **columns);
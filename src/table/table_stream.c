@@ -0,0 +1,228 @@
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include "../util/string_builder.h"
+#include "../util/alloc_wrappers.h"
+#include "table_stream.h"
+
+#define CELL_STARTSIZE 16
+
+struct TableStream
+{
+    FILE *stream;
+    size_t num_cols;
+    size_t window;                        // Number of rows buffered to fix widths
+    size_t widths[TABLE_MAX_COLS];        // Can only grow
+    TableHAlign h_aligns[TABLE_MAX_COLS];
+    char *header[TABLE_MAX_COLS];         // Copied cells, all NULL when there is no header
+    bool has_header;
+    StringBuilder cells[TABLE_MAX_COLS];  // Current row, buffers are reused for every row
+    size_t curr_col;
+    Vector buffered;                      // Copied cells (char*) of rows in window, num_cols per row
+    bool flushed;                         // When true, rows are printed immediately
+};
+
+static char *copy_string(const char *str)
+{
+    char *res = malloc_wrapper(strlen(str) + 1);
+    strcpy(res, str);
+    return res;
+}
+
+// Returns: True if a column has been widened
+static bool fit_row(TableStream *ts, char **row)
+{
+    bool widened = false;
+    for (size_t i = 0; i < ts->num_cols; i++)
+    {
+        size_t width = console_strlen(row[i]);
+        if (width > ts->widths[i])
+        {
+            ts->widths[i] = width;
+            widened = true;
+        }
+    }
+    return widened;
+}
+
+static void print_cell(const TableStream *ts, size_t col, const char *text)
+{
+    // Widths passed to printf include color codes, adjust them like print_table
+    int bytes = strlen(text);
+    int width = ts->widths[col] + bytes - console_strlen(text);
+    switch (ts->h_aligns[col])
+    {
+        case H_ALIGN_LEFT:
+            fprintf(ts->stream, "%-*s", width, text);
+            break;
+        case H_ALIGN_RIGHT:
+            fprintf(ts->stream, "%*s", width, text);
+            break;
+        case H_ALIGN_CENTER:
+        {
+            int padding = width - bytes;
+            fprintf(ts->stream, "%*s%s%*s", padding / 2, "", text, padding - padding / 2, "");
+            break;
+        }
+    }
+}
+
+static void print_row(const TableStream *ts, char **row)
+{
+    for (size_t i = 0; i < ts->num_cols; i++) print_cell(ts, i, row[i]);
+    fprintf(ts->stream, "\n");
+}
+
+// Prints header and buffered rows with widths fixed by them
+static void flush_window(TableStream *ts)
+{
+    if (ts->has_header) print_row(ts, ts->header);
+    for (size_t i = 0; i < vec_count(&ts->buffered); i += ts->num_cols)
+    {
+        char **row = vec_get(&ts->buffered, i);
+        print_row(ts, row);
+        for (size_t j = 0; j < ts->num_cols; j++) free(row[j]);
+    }
+    vec_destroy(&ts->buffered);
+    ts->flushed = true;
+}
+
+// ~ ~ ~ ~ ~ ~ ~ ~ ~ ~ User-functions ~ ~ ~ ~ ~ ~ ~ ~ ~ ~
+
+/*
+Summary: Creates stream of rows printed to stream, cells are left-aligned by default
+Params
+    num_cols: Number of cells in each row, missing cells are printed empty
+    window:   Number of rows buffered to fix widths before anything is printed,
+              0 to print first row immediately (declare widths then)
+*/
+TableStream *get_table_stream(FILE *stream, size_t num_cols, size_t window)
+{
+    assert(num_cols <= TABLE_MAX_COLS);
+
+    TableStream *res = malloc_wrapper(sizeof(TableStream));
+    *res = (TableStream){
+        .stream     = stream,
+        .num_cols   = num_cols,
+        .window     = window,
+        .widths     = { 0 },
+        .h_aligns   = { H_ALIGN_LEFT },
+        .header     = { NULL },
+        .has_header = false,
+        .curr_col   = 0,
+        .buffered   = vec_create(sizeof(char*), window * num_cols + 1),
+        .flushed    = false
+    };
+    for (size_t i = 0; i < num_cols; i++) res->cells[i] = strbuilder_create(CELL_STARTSIZE);
+    return res;
+}
+
+/*
+Summary: Completes a pending row, prints buffered rows and frees stream. Underlying FILE is not closed.
+*/
+void free_table_stream(TableStream *ts)
+{
+    assert(ts != NULL);
+
+    if (ts->curr_col != 0) stream_next_row(ts);
+    if (!ts->flushed) flush_window(ts);
+    fflush(ts->stream);
+
+    for (size_t i = 0; i < ts->num_cols; i++)
+    {
+        free(ts->header[i]);
+        vec_destroy(&ts->cells[i]);
+    }
+    free(ts);
+}
+
+void stream_set_alignments(TableStream *ts, size_t num_alignments, const TableHAlign *h_aligns)
+{
+    assert(ts != NULL);
+    assert(num_alignments <= TABLE_MAX_COLS);
+
+    for (size_t i = 0; i < num_alignments; i++) ts->h_aligns[i] = h_aligns[i];
+}
+
+/*
+Summary: Sets minimum widths of columns, e.g. computed from the widest value a format can produce
+*/
+void stream_declare_widths(TableStream *ts, size_t num_widths, const size_t *widths)
+{
+    assert(ts != NULL);
+    assert(num_widths <= ts->num_cols);
+
+    for (size_t i = 0; i < num_widths; i++)
+    {
+        if (widths[i] > ts->widths[i]) ts->widths[i] = widths[i];
+    }
+}
+
+/*
+Summary: Sets row that is printed before the first row and again whenever a column grows.
+    Cells are copied.
+*/
+void stream_set_header(TableStream *ts, size_t num_cells, const char **cells)
+{
+    assert(ts != NULL);
+    assert(num_cells <= ts->num_cols);
+
+    for (size_t i = 0; i < ts->num_cols; i++)
+    {
+        free(ts->header[i]);
+        ts->header[i] = copy_string(i < num_cells ? cells[i] : "");
+    }
+    ts->has_header = true;
+    fit_row(ts, ts->header);
+}
+
+void stream_add_cell(TableStream *ts, const char *text)
+{
+    stream_add_cell_fmt(ts, "%s", text);
+}
+
+void stream_add_cell_fmt(TableStream *ts, const char *fmt, ...)
+{
+    va_list args;
+    va_start(args, fmt);
+    stream_add_cell_vfmt(ts, fmt, args);
+    va_end(args);
+}
+
+void stream_add_cell_vfmt(TableStream *ts, const char *fmt, va_list args)
+{
+    assert(ts != NULL);
+    assert(ts->curr_col < ts->num_cols);
+
+    vstrbuilder_append(&ts->cells[ts->curr_col], fmt, args);
+    ts->curr_col++;
+}
+
+/*
+Summary: Completes current row. It is printed immediately when the window is full.
+*/
+void stream_next_row(TableStream *ts)
+{
+    assert(ts != NULL);
+
+    char *row[TABLE_MAX_COLS];
+    for (size_t i = 0; i < ts->num_cols; i++) row[i] = strbuilder_to_str(&ts->cells[i]);
+    bool widened = fit_row(ts, row);
+
+    if (ts->flushed)
+    {
+        if (widened && ts->has_header) print_row(ts, ts->header);
+        print_row(ts, row);
+    }
+    else
+    {
+        for (size_t i = 0; i < ts->num_cols; i++) VEC_PUSH_ELEM(&ts->buffered, char*, copy_string(row[i]));
+        if (vec_count(&ts->buffered) >= ts->window * ts->num_cols) flush_window(ts);
+    }
+
+    for (size_t i = 0; i < ts->num_cols; i++) strbuilder_clear(&ts->cells[i]);
+    ts->curr_col = 0;
+}
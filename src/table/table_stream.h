@@ -0,0 +1,29 @@
+#pragma once
+#include <stdbool.h>
+#include <stdarg.h>
+#include <stdio.h>
+
+#include "table.h"
+
+/*
+ * Streaming counterpart of Table for an unbounded number of rows of single-line cells without borders.
+ * Column widths are fixed from declared widths and the first rows (the window), afterwards every row
+ * is printed as soon as it is complete. When a later cell does not fit, its column grows and the header
+ * (if any) is printed again, so memory stays constant regardless of the number of rows.
+ */
+
+typedef struct TableStream TableStream;
+
+TableStream *get_table_stream(FILE *stream, size_t num_cols, size_t window);
+void free_table_stream(TableStream *ts);
+
+// Settings, only effective before the first row has been printed
+void stream_set_alignments(TableStream *ts, size_t num_alignments, const TableHAlign *h_aligns);
+void stream_declare_widths(TableStream *ts, size_t num_widths, const size_t *widths);
+void stream_set_header(TableStream *ts, size_t num_cells, const char **cells);
+
+// Cell insertion
+void stream_add_cell(TableStream *ts, const char *text);
+void stream_add_cell_fmt(TableStream *ts, const char *fmt, ...);
+void stream_add_cell_vfmt(TableStream *ts, const char *fmt, va_list args);
+void stream_next_row(TableStream *ts);
@@ -0,0 +1,133 @@
+#include <stddef.h>
+#include <stdint.h>
+
+#include "alloc_wrappers.h"
+#include "arena.h"
+
+#define ALIGNMENT _Alignof(max_align_t)
+#define ALIGN_UP(n) (((n) + ALIGNMENT - 1) & ~(ALIGNMENT - 1))
+
+struct ArenaBlock
+{
+    ArenaBlock *next;
+    size_t size; // Usable bytes in data
+    size_t used; // Bytes already handed out
+    _Alignas(max_align_t) unsigned char data[];
+};
+
+static ArenaBlock *malloc_block(size_t size)
+{
+    ArenaBlock *res = malloc_wrapper(sizeof(ArenaBlock) + size);
+    res->next = NULL;
+    res->size = size;
+    res->used = 0;
+    return res;
+}
+
+Arena arena_create(size_t block_size)
+{
+    return (Arena){
+        .block_size = ALIGN_UP(block_size),
+        .first      = NULL,
+        .last       = NULL,
+        .curr       = NULL,
+        .large      = NULL,
+        .num_allocs = 0,
+        .num_bytes  = 0,
+        .num_blocks = 0
+    };
+}
+
+// Frees list of blocks, returns number of freed blocks
+static size_t free_blocks(ArenaBlock *block)
+{
+    size_t res = 0;
+    while (block != NULL)
+    {
+        ArenaBlock *next = block->next;
+        free(block);
+        block = next;
+        res++;
+    }
+    return res;
+}
+
+/*
+Summary: Returns uninitialized memory of given size, aligned for any type.
+    Blocks kept from a previous reset are reused before new ones are allocated.
+*/
+void *arena_alloc(Arena *arena, size_t size)
+{
+    size = ALIGN_UP(size);
+    arena->num_allocs++;
+    arena->num_bytes += size;
+
+    // Large allocation does not waste the space left in current block
+    if (size > arena->block_size)
+    {
+        ArenaBlock *block = malloc_block(size);
+        block->used = size;
+        block->next = arena->large;
+        arena->large = block;
+        arena->num_blocks++;
+        return block->data;
+    }
+
+    // Advance to first block (current or a reused one) with enough space left
+    while (arena->curr != NULL && arena->curr->size - arena->curr->used < size)
+    {
+        arena->curr = arena->curr->next;
+        if (arena->curr != NULL) arena->curr->used = 0;
+    }
+
+    if (arena->curr == NULL)
+    {
+        ArenaBlock *block = malloc_block(arena->block_size);
+        if (arena->last == NULL)
+        {
+            arena->first = block;
+        }
+        else
+        {
+            arena->last->next = block;
+        }
+        arena->last = block;
+        arena->curr = block;
+        arena->num_blocks++;
+    }
+
+    void *res = arena->curr->data + arena->curr->used;
+    arena->curr->used += size;
+    return res;
+}
+
+/*
+Summary: Releases all allocations at once. Up to ARENA_KEEP_BLOCKS blocks are kept
+    and reused by subsequent allocations, the others are freed.
+*/
+void arena_reset(Arena *arena)
+{
+    arena->num_blocks -= free_blocks(arena->large);
+    arena->large = NULL;
+
+    ArenaBlock *last = arena->first;
+    for (size_t i = 1; last != NULL && last->next != NULL && i < ARENA_KEEP_BLOCKS; i++) last = last->next;
+    if (last != NULL)
+    {
+        arena->num_blocks -= free_blocks(last->next);
+        last->next = NULL;
+    }
+    arena->last = last;
+
+    arena->curr = arena->first;
+    if (arena->curr != NULL) arena->curr->used = 0;
+    arena->num_allocs = 0;
+    arena->num_bytes = 0;
+}
+
+void arena_destroy(Arena *arena)
+{
+    free_blocks(arena->first);
+    free_blocks(arena->large);
+    *arena = arena_create(arena->block_size);
+}
@@ -0,0 +1,31 @@
+#pragma once
+#include <stdlib.h>
+
+/*
+ * Region allocator: Many small allocations are served from a few big blocks
+ * and released all at once by arena_reset or arena_destroy.
+ * Memory of single allocations can not be freed.
+ * Allocations larger than the block size get a block of their own, which is released by the next reset.
+ * A reset keeps up to ARENA_KEEP_BLOCKS regular blocks for reuse and releases the others.
+ */
+
+#define ARENA_KEEP_BLOCKS 16
+
+typedef struct ArenaBlock ArenaBlock;
+
+typedef struct
+{
+    size_t block_size;  // Minimum size of newly allocated blocks
+    ArenaBlock *first;  // Linked list of blocks of block_size, kept over resets for reuse
+    ArenaBlock *last;   // Tail of list, new blocks are appended here
+    ArenaBlock *curr;   // Block the next allocation is tried to be served from
+    ArenaBlock *large;  // Linked list of blocks of single large allocations
+    size_t num_allocs;  // Number of allocations since last reset
+    size_t num_bytes;   // Number of bytes handed out since last reset
+    size_t num_blocks;  // Number of blocks currently owned
+} Arena;
+
+Arena arena_create(size_t block_size);
+void *arena_alloc(Arena *arena, size_t size);
+void arena_reset(Arena *arena);
+void arena_destroy(Arena *arena);
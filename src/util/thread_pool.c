@@ -0,0 +1,139 @@
+#define _DEFAULT_SOURCE // sysconf
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "alloc_wrappers.h"
+#include "thread_pool.h"
+
+#define MAX_THREADS 256
+
+// Loop that is currently executed, guarded by mutex except for the counter
+static struct {
+    PoolTask task;
+    void *state;
+    size_t num_tasks;
+    atomic_size_t next_task;
+    size_t generation; // Incremented for every loop, tells workers that there is new work
+    size_t num_pending; // Workers that have not finished their part of the current loop
+    bool shutdown;
+} job = { .generation = 0, .num_pending = 0, .shutdown = false };
+
+static pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t work_available = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t work_done = PTHREAD_COND_INITIALIZER;
+static pthread_t *workers = NULL;
+static size_t num_workers = 0;
+static size_t num_threads = 0; // Including caller, 0 as long as it has not been determined
+
+static void run_tasks(PoolTask task, void *state, size_t num_tasks)
+{
+    size_t index;
+    while ((index = atomic_fetch_add(&job.next_task, 1)) < num_tasks) task(state, index);
+}
+
+static void *worker_main(__attribute__((unused)) void *arg)
+{
+    size_t seen_generation = 0;
+    pthread_mutex_lock(&mutex);
+    while (true)
+    {
+        while (!job.shutdown && job.generation == seen_generation) pthread_cond_wait(&work_available, &mutex);
+        if (job.shutdown) break;
+
+        seen_generation = job.generation;
+        PoolTask task = job.task;
+        void *state = job.state;
+        size_t num_tasks = job.num_tasks;
+        pthread_mutex_unlock(&mutex);
+
+        run_tasks(task, state, num_tasks);
+
+        pthread_mutex_lock(&mutex);
+        if (--job.num_pending == 0) pthread_cond_signal(&work_done);
+    }
+    pthread_mutex_unlock(&mutex);
+    return NULL;
+}
+
+/*
+Summary: Sets number of threads that execute loops (including the calling one), stops running workers.
+    0 chooses the number of online processors, 1 executes loops sequentially.
+*/
+void pool_set_num_threads(size_t new_num_threads)
+{
+    pool_shutdown();
+    num_threads = new_num_threads;
+}
+
+size_t pool_get_num_threads()
+{
+    if (num_threads == 0)
+    {
+        long num_processors = sysconf(_SC_NPROCESSORS_ONLN);
+        num_threads = num_processors > 0 ? (size_t)num_processors : 1;
+    }
+    if (num_threads > MAX_THREADS) num_threads = MAX_THREADS;
+    return num_threads;
+}
+
+static void start_workers()
+{
+    job.shutdown = false;
+    job.generation = 0;
+    workers = malloc_wrapper((pool_get_num_threads() - 1) * sizeof(pthread_t));
+    for (num_workers = 0; num_workers < pool_get_num_threads() - 1; num_workers++)
+    {
+        // Without workers loops are still executed by the caller
+        if (pthread_create(&workers[num_workers], NULL, worker_main, NULL) != 0) break;
+    }
+}
+
+/*
+Summary: Calls task for every index in [0, num_tasks), possibly in parallel and in any order.
+    Returns when all calls have returned.
+*/
+void pool_parallel_for(size_t num_tasks, PoolTask task, void *state)
+{
+    if (num_tasks == 0) return;
+    if (num_tasks == 1 || pool_get_num_threads() == 1)
+    {
+        for (size_t i = 0; i < num_tasks; i++) task(state, i);
+        return;
+    }
+    if (workers == NULL) start_workers();
+
+    pthread_mutex_lock(&mutex);
+    job.task = task;
+    job.state = state;
+    job.num_tasks = num_tasks;
+    atomic_store(&job.next_task, 0);
+    job.generation++;
+    job.num_pending = num_workers;
+    pthread_cond_broadcast(&work_available);
+    pthread_mutex_unlock(&mutex);
+
+    run_tasks(task, state, num_tasks);
+
+    // Every worker finishes every loop, even if it finds no task left, so it can not mix up loops
+    pthread_mutex_lock(&mutex);
+    while (job.num_pending > 0) pthread_cond_wait(&work_done, &mutex);
+    pthread_mutex_unlock(&mutex);
+}
+
+/*
+Summary: Stops and joins all workers, they are started again by the next loop
+*/
+void pool_shutdown()
+{
+    if (workers == NULL) return;
+    pthread_mutex_lock(&mutex);
+    job.shutdown = true;
+    pthread_cond_broadcast(&work_available);
+    pthread_mutex_unlock(&mutex);
+
+    for (size_t i = 0; i < num_workers; i++) pthread_join(workers[i], NULL);
+    free(workers);
+    workers = NULL;
+    num_workers = 0;
+}
@@ -0,0 +1,16 @@
+#pragma once
+#include <stdlib.h>
+
+/*
+ * Fixed set of worker threads that execute the iterations of parallel loops.
+ * Workers are started on first use and wait for further loops until pool_shutdown.
+ * The calling thread takes part in each loop, iterations are claimed one by one from a shared counter,
+ * so uneven iterations are balanced. Loops must only be started by one thread at a time.
+ */
+
+typedef void (*PoolTask)(void *state, size_t index);
+
+void pool_set_num_threads(size_t num_threads);
+size_t pool_get_num_threads();
+void pool_parallel_for(size_t num_tasks, PoolTask task, void *state);
+void pool_shutdown();
@@ -17,6 +17,7 @@ void vec_trim(Vector *vec)
 
 void vec_ensure_size(Vector *vec, size_t needed_size)
 {
+    if (needed_size <= vec->buffer_size) return;
     while (needed_size > vec->buffer_size)
     {
         vec->buffer_size += MAX(1, (size_t)(vec->buffer_size * VECTOR_GROWTHFACTOR));
@@ -5,6 +5,8 @@
 #include "test_data_structures.h"
 #include "../src/util/linked_list.h"
 #include "../src/util/trie.h"
+#include "../src/util/arena.h"
+#include "../src/util/thread_pool.h"
 
 #define NUM_TRIE_ITERATOR_TESTS 10
 char *trie_iterator_tests[] = {
@@ -20,6 +22,14 @@ char *trie_iterator_tests[] = {
     "zzaaa"
 };
 
+#define NUM_POOL_TASKS 1000
+
+static void square_task(void *state, size_t index)
+{
+    double arg = index % 10;
+    ((double*)state)[index] = arg * arg;
+}
+
 bool data_structures_test(StringBuilder *error_builder)
 {
     // Case 1: vector
@@ -192,6 +202,64 @@ bool data_structures_test(StringBuilder *error_builder)
 
     trie_destroy(&trie);
 
+    // Case 4: arena
+    Arena arena = arena_create(64);
+    size_t num_blocks = 0;
+    for (size_t round = 0; round < 2; round++)
+    {
+        int *small = arena_alloc(&arena, sizeof(int));
+        char *big = arena_alloc(&arena, 1000); // Exceeds block size
+        double *aligned = arena_alloc(&arena, sizeof(double));
+        *small = 42;
+        memset(big, 'x', 1000);
+        *aligned = 1.5;
+        if ((size_t)aligned % _Alignof(double) != 0)
+        {
+            ERROR("Arena allocation not aligned\n");
+        }
+        if (*small != 42 || big[999] != 'x' || *aligned != 1.5)
+        {
+            ERROR("Arena allocations overlap\n");
+        }
+        if (arena.num_allocs != 3)
+        {
+            ERROR("num_allocs of arena is %zu, should be 3\n", arena.num_allocs);
+        }
+        // Blocks need to be reused after reset
+        if (round == 1 && arena.num_blocks != num_blocks)
+        {
+            ERROR("Arena owns %zu blocks after reset, should be %zu\n", arena.num_blocks, num_blocks);
+        }
+        num_blocks = arena.num_blocks;
+        arena_reset(&arena);
+    }
+    // Surplus blocks are released by reset
+    for (size_t i = 0; i < 2 * ARENA_KEEP_BLOCKS; i++) arena_alloc(&arena, 64);
+    arena_reset(&arena);
+    if (arena.num_blocks != ARENA_KEEP_BLOCKS)
+    {
+        ERROR("Arena owns %zu blocks after reset, should be %d\n", arena.num_blocks, ARENA_KEEP_BLOCKS);
+    }
+    arena_destroy(&arena);
+
+    // Case 5: thread pool, each task is executed exactly once, also when loops follow each other
+    double squares[NUM_POOL_TASKS];
+    pool_set_num_threads(4);
+    for (size_t i = 0; i < 3; i++)
+    {
+        for (size_t j = 0; j < NUM_POOL_TASKS; j++) squares[j] = -1;
+        pool_parallel_for(NUM_POOL_TASKS - i, square_task, squares);
+        for (size_t j = 0; j < NUM_POOL_TASKS; j++)
+        {
+            double expected = j < NUM_POOL_TASKS - i ? (double)((j % 10) * (j % 10)) : -1;
+            if (squares[j] != expected)
+            {
+                ERROR("Unexpected result of task %zu of parallel loop\n", j);
+            }
+        }
+    }
+    pool_set_num_threads(0);
+
     return true;
 }
 
@@ -20,7 +20,7 @@ struct ErrorTest {
     ParserErrorType result;
 };
 
-static const size_t NUM_VALUE_CASES = 43;
+static const size_t NUM_VALUE_CASES = 57;
 static struct ValueTest valueTests[] = {
     // 1. Basic prefix, infix, postfix
     { "2+3",         5 },
@@ -38,6 +38,14 @@ static struct ValueTest valueTests[] = {
     { "fib(-8)",       -21 },
     { "gcd(942, 492)",   6 },
     { "lcm(14, 24)",   168 },
+    { "fib(90)",       2880067194370816120.0 },
+    { "fib(-90)",     -2880067194370816120.0 },
+    { "gcd(10^15, 1)",   1 },
+    { "gcd(0, 7)",       7 },
+    { "lcm(2^40, 6)",  3298534883328 },
+    { "66 C 33",       7219428434016265740.0 },
+    { "3 C 5",           0 },
+    { "20!",           2432902008176640000.0 },
     // 3. Precedence and parentheses
     { "1+2*3+4",      11 },
     { "1+2*(3+4)",    15 },
@@ -70,6 +78,12 @@ static struct ValueTest valueTests[] = {
     { "sum(1,2,3)",                  6 },
     { "prod(2,3,4)-4!",              0 },
     { "sum(sum(1,2),sum(3,4),5)+6", 21 },
+    { "median(0.5, 0.2, 0.9, 0.1)",  0.35 },
+    { "median(9,1,8,2,7,3,6,4,5)",   5 },
+    { "median(10,1,9,2,8,3,7,4,6,5,0,11)", 5.5 },
+    { "var(1,2,3,4)",                1.25 },
+    { "max(3,9,2,8,1,7,4,6,5)-min(3,9,2,8,1,7,4,6,5)", 8 },
+    { "avg(1,2,3,4,5,6,7,8,9,10)+var(1,2,3,4,5,6,7,8,9,10)", 13.75 },
     // 6. Going wild
     { "5 .5sin(2)+5pi5", 80.81305990681 },
     { "--(1+sum(ld(--8), --1%+--1%, 2 .2))%+1", 1.0442 },
@@ -137,6 +151,33 @@ bool parser_test(StringBuilder *error_builder)
         }
     }
 
+    // Built-in operators are evaluated by their traits, which also describe algebraic properties
+    for (ListNode *curr = ctx.op_list.first; curr != NULL; curr = listnode_get_next(curr))
+    {
+        const Operator *op = listnode_get_data(curr);
+        if (op->traits == NULL || op->traits->evaluate == NULL)
+        {
+            ERROR("Operator '%s' has no traits\n", op->name);
+        }
+    }
+    const Operator *add = ctx_lookup_op(&ctx, "+", OP_PLACE_INFIX);
+    const Operator *sub = ctx_lookup_op(&ctx, "-", OP_PLACE_INFIX);
+    const Operator *mul = ctx_lookup_op(&ctx, "*", OP_PLACE_INFIX);
+    const Operator *rand_op = ctx_lookup_op(&ctx, "rand", OP_PLACE_FUNCTION);
+    const Operator *custom = ctx_add_op(&ctx, op_get_function("custom", 1));
+    double args[] = { 3, 4 };
+    double result = 0;
+    if (!op_has_trait(add, OP_TRAIT_COMMUTATIVE) || !op_has_trait(add, OP_TRAIT_ASSOCIATIVE) || add->traits->identity != 0
+        || op_has_trait(sub, OP_TRAIT_COMMUTATIVE)
+        || !op_has_trait(mul, OP_TRAIT_ABSORBING) || mul->traits->absorbing != 0
+        || !op_has_trait(rand_op, OP_TRAIT_IMPURE) || !arith_op_info(rand_op).impure
+        || op_has_trait(custom, OP_TRAIT_IMPURE)
+        || arith_op_evaluate(mul, 2, args, &result) != LISTENERERR_SUCCESS || result != 12
+        || arith_op_evaluate(custom, 1, args, &result) != LISTENERERR_UNKNOWN_OP)
+    {
+        ERROR("Unexpected traits of operators\n");
+    }
+
     // Perform error tests
     // Remove glue-op to test for "expected infix or prefix"
     ctx_set_glue_op(&ctx, NULL);
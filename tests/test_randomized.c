@@ -1,5 +1,7 @@
 #include <stdio.h>
 #include <string.h>
+#include <math.h>
+#include <float.h>
 
 #include "test_randomized.h"
 #include "fuzzer.h"
@@ -7,10 +9,176 @@
 #include "../src/engine/tree/tree_util.h"
 #include "../src/engine/tree/tree_to_string.h"
 #include "../src/util/string_util.h"
+#include "../src/util/alloc_wrappers.h"
+#include "../src/engine/evaluation/bytecode.h"
+#include "../src/engine/evaluation/jit.h"
+#include "../src/engine/evaluation/vecmath.h"
 #include "../src/client/core/arith_context.h"
+#include "../src/client/core/arith_evaluation.h"
 
 #define MAX_INNER_NODES 10
 #define NUM_CASES       500
+#define NUM_EVAL_CASES  500
+#define NUM_BATCH_ROWS  (BYTECODE_BATCH_SIZE + 2)
+#define NUM_VECMATH_ARGS 100000
+#define VECMATH_MAX_ULP  2
+
+static bool same_result(double a, double b)
+{
+    return a == b || (isnan(a) && isnan(b));
+}
+
+// Vectorized functions round differently, batch evaluation is only exact with libm
+static OpInfo scalar_op_info(const Operator *op)
+{
+    OpInfo info = arith_op_info(op);
+    info.batch = NULL;
+    return info;
+}
+
+/*
+Summary: Compiled evaluation must behave exactly like evaluation by listener only, including errors
+*/
+static bool compiled_evaluation_test(StringBuilder *error_builder)
+{
+    for (size_t i = 0; i < NUM_EVAL_CASES; i++)
+    {
+        Node *random_tree = NULL;
+        get_random_tree(MAX_INNER_NODES, &random_tree);
+
+        Bytecode bytecode;
+        bytecode_compile(random_tree, scalar_op_info, &bytecode);
+
+        // Reference is evaluated by listener only, with variables replaced by their values
+        Node *reference = tree_copy(random_tree);
+        double values[5];
+        for (size_t j = 0; j < bytecode.num_vars; j++)
+        {
+            values[j] = 1.5 - (double)j;
+            Node *value = malloc_constant_node(values[j], 0);
+            replace_variable_nodes(&reference, value, symbol_get_name(bytecode.vars[j]));
+            free_node(value);
+        }
+
+        double ref_res = 0;
+        double res = 0;
+        ListenerError ref_err = tree_reduce(reference, arith_op_evaluate, &ref_res, NULL);
+        ListenerError err = bytecode_run(&bytecode, arith_op_evaluate, values, &res, NULL);
+        if (err != ref_err || (err == LISTENERERR_SUCCESS && !same_result(res, ref_res)))
+        {
+            char *stringed_tree = tree_to_str(random_tree);
+            ERROR("Bytecode evaluation of %s resulted in %f (error %d), should be %f (error %d).\n",
+                stringed_tree, res, err, ref_res, ref_err);
+        }
+
+        // Native code (when compiled in) must behave like bytecode
+        JitCode jit;
+        if (jit_compile(&bytecode, arith_op_evaluate, &jit))
+        {
+            double jit_res = 0;
+            size_t err_instr = 0;
+            size_t jit_err_instr = 0;
+            err = bytecode_run(&bytecode, arith_op_evaluate, values, &res, &err_instr);
+            ListenerError jit_err = jit_run(&jit, values, &jit_res, &jit_err_instr);
+            if (jit_err != err
+                || (err == LISTENERERR_SUCCESS && !same_result(res, jit_res))
+                || (err != LISTENERERR_SUCCESS && jit_err_instr != err_instr))
+            {
+                char *stringed_tree = tree_to_str(random_tree);
+                ERROR("Native evaluation of %s resulted in %f (error %d), should be %f (error %d).\n",
+                    stringed_tree, jit_res, jit_err, res, err);
+            }
+            jit_destroy(&jit);
+        }
+
+        // Every row of batch evaluation must behave like a single evaluation
+        double columns[5][NUM_BATCH_ROWS];
+        const double *column_ptrs[5];
+        for (size_t k = 0; k < bytecode.num_vars; k++)
+        {
+            for (size_t r = 0; r < NUM_BATCH_ROWS; r++) columns[k][r] = values[k] + (double)r / 4 - 2;
+            column_ptrs[k] = columns[k];
+        }
+        double batch_res[NUM_BATCH_ROWS];
+        ListenerError batch_errs[NUM_BATCH_ROWS];
+        bytecode_run_batch(&bytecode, arith_op_evaluate, column_ptrs, NUM_BATCH_ROWS, batch_res, batch_errs);
+        for (size_t r = 0; r < NUM_BATCH_ROWS; r++)
+        {
+            double row_values[5];
+            for (size_t k = 0; k < bytecode.num_vars; k++) row_values[k] = columns[k][r];
+            err = bytecode_run(&bytecode, arith_op_evaluate, row_values, &res, NULL);
+            if (err != batch_errs[r] || (err == LISTENERERR_SUCCESS && !same_result(res, batch_res[r])))
+            {
+                char *stringed_tree = tree_to_str(random_tree);
+                ERROR("Batch evaluation of %s resulted in %f (error %d) in row %zu, should be %f (error %d).\n",
+                    stringed_tree, batch_res[r], batch_errs[r], r, res, err);
+            }
+        }
+
+        free_tree(reference);
+        bytecode_destroy(&bytecode);
+        free_tree(random_tree);
+    }
+    return true;
+}
+
+static double ulp_distance(double res, double expected)
+{
+    if (res == expected || (isnan(res) && isnan(expected))) return 0;
+    return fabs(res - expected) / fabs(nextafter(expected, INFINITY) - expected);
+}
+
+/*
+Summary: Vectorized functions must agree with libm within error bound of vecmath.h, including special values
+*/
+static bool vecmath_test(StringBuilder *error_builder)
+{
+    struct {
+        const char *name;
+        void (*vectorized)(double*, size_t);
+        double (*reference)(double);
+        double min;
+        double max;
+    } functions[] = {
+        { "exp", vecmath_exp, exp, -750, 750 },
+        { "log", vecmath_log, log, -1, 1e6 },
+        { "sin", vecmath_sin, sin, -1e6, 1e6 },
+        { "cos", vecmath_cos, cos, -10, 10 }
+    };
+    const double special[] = { NAN, INFINITY, -INFINITY, 0, -0.0, DBL_MIN, DBL_TRUE_MIN, DBL_MAX, -DBL_MAX };
+    const size_t num_special = sizeof(special) / sizeof(double);
+
+    double *args = malloc_wrapper((NUM_VECMATH_ARGS + num_special) * sizeof(double));
+    double *values = malloc_wrapper((NUM_VECMATH_ARGS + num_special) * sizeof(double));
+    for (size_t i = 0; i < sizeof(functions) / sizeof(functions[0]); i++)
+    {
+        for (size_t j = 0; j < NUM_VECMATH_ARGS; j++)
+        {
+            args[j] = functions[i].min + (functions[i].max - functions[i].min) * rand() / RAND_MAX;
+        }
+        memcpy(args + NUM_VECMATH_ARGS, special, sizeof(special));
+        memcpy(values, args, (NUM_VECMATH_ARGS + num_special) * sizeof(double));
+
+        // Odd count to cover partially filled vectors
+        functions[i].vectorized(values, NUM_VECMATH_ARGS + num_special);
+        for (size_t j = 0; j < NUM_VECMATH_ARGS + num_special; j++)
+        {
+            double expected = functions[i].reference(args[j]);
+            if (ulp_distance(values[j], expected) > VECMATH_MAX_ULP
+                || (j >= NUM_VECMATH_ARGS && signbit(values[j]) != signbit(expected)))
+            {
+                double res = values[j];
+                double arg = args[j];
+                free(args);
+                free(values);
+                ERROR("vecmath_%s(%.17g) is %.17g, should be %.17g.\n", functions[i].name, arg, res, expected);
+            }
+        }
+    }
+    free(args);
+    free(values);
+    return true;
+}
 
 /*
 Summary:
@@ -68,7 +236,7 @@ bool randomized_test(StringBuilder *error_builder)
         free(stringed_tree);
     }
 
-    return true;
+    return compiled_evaluation_test(error_builder) && vecmath_test(error_builder);
 }
 
 Test get_randomized_test()
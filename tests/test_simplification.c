@@ -6,8 +6,10 @@
 #include "../src/engine/tree/tree_util.h"
 #include "../src/engine/tree/tree_to_string.h"
 #include "../src/engine/parsing/parser.h"
+#include "../src/engine/transformation/rule_parsing.h"
 #include "../src/client/core/arith_context.h"
 #include "../src/client/core/arith_evaluation.h"
+#include "../src/client/core/arith_optimization.h"
 #include "../src/client/simplification/simplification.h"
 #include "test_simplification.h"
 
@@ -44,6 +46,56 @@ const char *cases[] = {
     "sqrt(x)'",            "0.5/sqrt(x)"
 };
 
+static const size_t NUM_OPTIMIZATION_CASES = 14;
+const char *optimization_cases[] = {
+    "x^2",                 "x*x",
+    "x^3",                 "x*x*x",
+    "x^4",                 "(x*x)*(x*x)",
+    "sin(x)/4",            "sin(x)*0.25",
+    "x^3-2x^2+x/8",        "((x-2)*x+0.125)*x",
+    "x^2+1",               "x*x+1",
+    "sin(x)+x^2+3x+1",     "sin(x)+((x+3)*x+1)",
+    "log(x,10)",           "ln(x)*0.4342944819", // Precision problems, checked by stringifying tree
+    "x^0.5+x^(-2)+x/0",    "x^0.5+x^(-2)+x/0",   // Not rewritten to preserve errors and precision
+    "-(x^2)-x",            "(-x-1)*x",
+    "ln(x)/2",             "ln(x)*0.5",
+    "ln(x)/ln(2)",         "ln(x)*1.442695041",
+    "rand(1,x)^2",         "rand(1,x)^2",        // Random numbers must not be drawn twice
+    "rand(1,x)+x^2+x",     "rand(1,x)+x*x+x"
+};
+
+static const size_t NUM_REDUCTION_CASES = 9;
+const struct {
+    const char *fold;
+    AggregateKind kind; // 0 if fold can not be reduced by a kernel
+} reduction_cases[] = {
+    { "x+y",      AGG_SUM  },
+    { "y*x",      AGG_PROD },
+    { "max(x,y)", AGG_MAX  },
+    { "min(y,x)", AGG_MIN  },
+    { "sum(x,y)", AGG_SUM  },
+    { "x-y",      0        },
+    { "x+2y",     0        },
+    { "x+x",      0        },
+    { "gcd(x,y)", 0        }, // Associative, but no kernel
+};
+
+static bool check_trees(StringBuilder *error_builder, const char *input, Node *result, Node *expected, const char *action)
+{
+    if (!tree_equals(result, expected))
+    {
+        char *wrong_result = tree_to_str(result);
+        char *right_result = tree_to_str(expected);
+        if (strcmp(wrong_result, right_result) != 0)
+        {
+            ERROR("%s %s to %s, should be %s.\n", input, action, wrong_result, right_result);
+        }
+        free(wrong_result);
+        free(right_result);
+    }
+    return true;
+}
+
 bool simplification_test(StringBuilder *error_builder)
 {
     if (!simplification_is_initialized())
@@ -68,28 +120,79 @@ bool simplification_test(StringBuilder *error_builder)
             ERROR("Simplification reported semantic error in test case %zu.\n", i);
         }
 
-        if (!tree_equals(left, right))
+        if (!check_trees(error_builder, cases[2 * i], left, right, "simplified")) return false;
+
+        free_tree(left);
+        free_tree(right);
+    }
+
+    // Bound subtrees are moved into the result, only further occurrences of a variable are copied
+    RewriteRule rule;
+    if (!parse_rule("sin(x) -> x*x", g_ctx, &rule))
+    {
+        ERROR("Could not parse rule.\n");
+    }
+    Node *tree = parse_easy(g_ctx, "sin(a+b)");
+    Node *expected = parse_easy(g_ctx, "(a+b)*(a+b)");
+    Node *bound = get_child(tree, 0);
+    if (!apply_rule(&tree, &rule, NULL)
+        || !tree_equals(tree, expected)
+        || get_child(tree, 0) != bound
+        || get_child(tree, 1) == bound)
+    {
+        ERROR("Unexpected result of moving rule application.\n");
+    }
+    free_tree(tree);
+    free_tree(expected);
+    free_rule(&rule);
+
+    // Operators are instantiated with the number of children of the expanded list variables
+    if (!parse_rule("sum([xs], 0, [ys]) -> 2*sum([xs], [ys])", g_ctx, &rule))
+    {
+        ERROR("Could not parse rule.\n");
+    }
+    tree = parse_easy(g_ctx, "sum(a, b, 0, c)");
+    expected = parse_easy(g_ctx, "2*sum(a, b, c)");
+    bound = get_child(tree, 3);
+    if (!apply_rule(&tree, &rule, NULL)
+        || !tree_equals(tree, expected)
+        || get_child(get_child(tree, 1), 2) != bound)
+    {
+        ERROR("Unexpected result of rule application with list variables.\n");
+    }
+    free_tree(tree);
+    free_tree(expected);
+    free_rule(&rule);
+
+    // Rewriting for evaluation
+    for (size_t i = 0; i < NUM_OPTIMIZATION_CASES; i++)
+    {
+        Node *left = parse_easy(g_ctx, optimization_cases[2 * i]);
+        Node *right = parse_easy(g_ctx, optimization_cases[2 * i + 1]);
+        if (left == NULL || right == NULL)
         {
-            // Additional test: Double precision may cause problems, string tree and see if equals
-            char *wrong_result = tree_to_str(left);
-            char *right_result = tree_to_str(right);
-
-            if (strcmp(wrong_result, right_result) != 0)
-            {
-                ERROR("%s simplified to %s, should be %s.\n", cases[2 * i], wrong_result, right_result);
-            }
-            else
-            {
-                // Carry on, test case is passed
-                free(wrong_result);
-                free(right_result);
-            }
+            ERROR("Syntax error in optimization test case %zu.\n", i);
         }
-        
+        arith_optimize(&left);
+        if (!check_trees(error_builder, optimization_cases[2 * i], left, right, "optimized")) return false;
         free_tree(left);
         free_tree(right);
     }
 
+    // Recognition of folds that are reduced in parallel
+    for (size_t i = 0; i < NUM_REDUCTION_CASES; i++)
+    {
+        Node *fold = parse_easy(g_ctx, reduction_cases[i].fold);
+        if (fold == NULL) ERROR("Syntax error in reduction test case %zu.\n", i);
+        AggregateKind kind = 0;
+        bool reduce = arith_get_reduction(fold, "x", "y", &kind);
+        free_tree(fold);
+        if (reduce != (reduction_cases[i].kind != 0) || (reduce && kind != reduction_cases[i].kind))
+        {
+            ERROR("Unexpected reduction of fold %s.\n", reduction_cases[i].fold);
+        }
+    }
+
     // Fuzzer test to detect illegal simplification rules
     /*for (size_t i = 0; i < NUM_FUZZER_CASES; i++)
     {
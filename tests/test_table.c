@@ -1,7 +1,13 @@
+#define _DEFAULT_SOURCE // mkstemp
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
 
 #include "../src/table/table.h"
+#include "../src/table/table_stream.h"
+#include "../src/table/table_export.h"
 
 #include "test_table.h"
 
@@ -20,7 +26,7 @@ char *arrayA[4][4] = {
     { " 3....... ", RED " 23.1132310 " COL_RESET, "c ", " 333" },
 };
 
-bool table_test(__attribute__((unused)) StringBuilder *error_builder)
+bool table_test(StringBuilder *error_builder)
 {
     // Case 1
     Table *t1 = get_empty_table();
@@ -139,6 +145,111 @@ bool table_test(__attribute__((unused)) StringBuilder *error_builder)
     make_boxed(t5, BORDER_SINGLE);
     print_table(t5);
     free_table(t5);
+
+    // Case 6: Widths are fixed by window of two rows, header is printed again when third row is wider
+    FILE *file = tmpfile();
+    if (file == NULL) ERROR("Could not create temporary file\n");
+    TableStream *ts = get_table_stream(file, 3, 2);
+    stream_set_alignments(ts, 3, (TableHAlign[]){ H_ALIGN_LEFT, H_ALIGN_RIGHT, H_ALIGN_CENTER });
+    stream_declare_widths(ts, 1, (size_t[]){ 3 });
+    stream_set_header(ts, 2, (const char*[]){ "a", YELLOW "b" COL_RESET });
+    for (size_t i = 0; i < 3; i++)
+    {
+        stream_add_cell_fmt(ts, "%zu", i);
+        stream_add_cell(ts, i == 2 ? "wide" : "x");
+        stream_add_cell(ts, "c");
+        stream_next_row(ts);
+    }
+    free_table_stream(ts);
+
+    const char *expected = "a  " YELLOW "b" COL_RESET " \n"
+                           "0  xc\n"
+                           "1  xc\n"
+                           "a     " YELLOW "b" COL_RESET " \n"
+                           "2  widec\n";
+    char output[128] = { 0 };
+    rewind(file);
+    fread(output, 1, sizeof(output) - 1, file);
+    fclose(file);
+    if (strcmp(output, expected) != 0) ERROR("Unexpected output of table stream:\n%s", output);
+
+    // Case 7: Texts are copied into table, buffers can be reused before printing
+    Table *t7 = get_empty_table();
+    set_default_alignments(t7, 2, (TableHAlign[]){ H_ALIGN_RIGHT, H_ALIGN_LEFT }, NULL);
+    char buffer[8];
+    for (size_t i = 0; i < 3; i++)
+    {
+        snprintf(buffer, sizeof(buffer), "%zu", i * 50);
+        add_cell(t7, buffer);
+        add_cell_fmt(t7, "|%s", i == 1 ? "a\nb" : "c");
+        next_row(t7);
+    }
+    file = tmpfile();
+    if (file == NULL) ERROR("Could not create temporary file\n");
+    fprint_table(t7, file);
+    free_table(t7);
+
+    expected = "  0|c\n"
+               " 50|a\n"
+               "   b \n"
+               "100|c\n";
+    memset(output, 0, sizeof(output));
+    rewind(file);
+    fread(output, 1, sizeof(output) - 1, file);
+    fclose(file);
+    if (strcmp(output, expected) != 0) ERROR("Unexpected output of table:\n%s", output);
+
+    // Case 8: Export as CSV quotes names and writes NaN portably, F64 is read back bitwise
+    char path[] = "/tmp/ccalc_export_XXXXXX";
+    int fd = mkstemp(path);
+    if (fd == -1) ERROR("Could not create temporary file\n");
+    close(fd);
+    ExportFormat format;
+    if (!export_format_from_path("values.csv", &format) || format != EXPORT_CSV
+        || !export_format_from_path("values.f64", &format) || format != EXPORT_F64
+        || export_format_from_path("values.txt", &format))
+    {
+        ERROR_RETURN_VAL("export_format_from_path");
+    }
+
+    const double xs[] = { 0, 0.1, -2 };
+    const double ys[] = { 1e300, -NAN, 1.0 / 3 };
+    TableExport *export = open_table_export(path, EXPORT_CSV, 2);
+    if (export == NULL) ERROR_RETURN_VAL("open_table_export");
+    export_header(export, (const char*[]){ "x", "max(x,\"y\")" });
+    export_rows(export, 3, (const double*[]){ xs, ys });
+    if (!close_table_export(export)) ERROR_RETURN_VAL("close_table_export");
+
+    expected = "x,\"max(x,\"\"y\"\")\"\n"
+               "0,1.0000000000000001e+300\n"
+               "0.10000000000000001,nan\n"
+               "-2,0.33333333333333331\n";
+    memset(output, 0, sizeof(output));
+    file = fopen(path, "r");
+    fread(output, 1, sizeof(output) - 1, file);
+    fclose(file);
+    if (strcmp(output, expected) != 0) ERROR("Unexpected CSV export:\n%s", output);
+
+    export = open_table_export(path, EXPORT_F64, 2);
+    if (export == NULL) ERROR_RETURN_VAL("open_table_export");
+    export_header(export, (const char*[]){ "x", "y" });
+    export_rows(export, 3, (const double*[]){ xs, ys });
+    if (!close_table_export(export)) ERROR_RETURN_VAL("close_table_export");
+
+    double values[7];
+    file = fopen(path, "rb");
+    size_t num_read = fread(values, sizeof(double), 7, file);
+    fclose(file);
+    remove(path);
+    if (num_read != 6) ERROR("F64 export has %zu instead of 6 values\n", num_read);
+    for (size_t i = 0; i < 3; i++)
+    {
+        if (memcmp(&values[2 * i], &xs[i], sizeof(double)) != 0
+            || memcmp(&values[2 * i + 1], &ys[i], sizeof(double)) != 0)
+        {
+            ERROR("F64 export differs in row %zu\n", i);
+        }
+    }
     
     return true;
 }
@@ -1,10 +1,100 @@
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
+#include <math.h>
 
 #include "test_tree_util.h"
 #include "../src/engine/tree/operator.h"
 #include "../src/engine/tree/tree_util.h"
+#include "../src/engine/tree/tree_traversal.h"
 #include "../src/engine/tree/tree_to_string.h"
+#include "../src/engine/evaluation/bytecode.h"
+
+static size_t num_listener_calls = 0;
+
+struct SlotReplacement {
+    Node **slot;
+    Node *replacement;
+};
+
+// Replaces node at slot while traversing, like rules of a simplification
+static TraversalAction replace_slot_post(Node **node, __attribute__((unused)) Traversal *traversal, void *state)
+{
+    struct SlotReplacement *replacement = state;
+    if (node == replacement->slot) tree_replace(node, replacement->replacement);
+    return TRAVERSAL_CONTINUE;
+}
+
+static ListenerError sum_listener(__attribute__((unused)) const Operator *op,
+    size_t num_children,
+    const double *children,
+    double *out)
+{
+    num_listener_calls++;
+    *out = 0;
+    for (size_t i = 0; i < num_children; i++) *out += children[i];
+    return LISTENERERR_SUCCESS;
+}
+
+static OpInfo pure_classifier(__attribute__((unused)) const Operator *op)
+{
+    return (OpInfo){ .kind = OPKIND_CALL };
+}
+
+static Operator sin_op;
+static Operator cos_op;
+static size_t num_fused_calls = 0;
+
+static void fused_sin_cos(double x, double *out, double *out_cofunction)
+{
+    num_fused_calls++;
+    *out = sin(x);
+    *out_cofunction = cos(x);
+}
+
+static void fused_cos_sin(double x, double *out, double *out_cofunction)
+{
+    fused_sin_cos(x, out_cofunction, out);
+}
+
+static OpInfo trig_classifier(const Operator *op)
+{
+    if (op == &sin_op)
+    {
+        return (OpInfo){ .kind = OPKIND_UNARY, .unary = sin, .cofunction = &cos_op, .fused = fused_sin_cos };
+    }
+    if (op == &cos_op)
+    {
+        return (OpInfo){ .kind = OPKIND_UNARY, .unary = cos, .cofunction = &sin_op, .fused = fused_cos_sin };
+    }
+    return (OpInfo){ .kind = OPKIND_CALL };
+}
+
+static Operator min_op;
+static Operator max_op;
+static size_t num_shared_calls = 0;
+
+// Bit 1 selects min, bit 2 selects max
+static void shared_min_max(const double *args, size_t num_args, uint32_t selection, double *out_results)
+{
+    num_shared_calls++;
+    double min = INFINITY;
+    double max = -INFINITY;
+    for (size_t i = 0; i < num_args; i++)
+    {
+        min = fmin(min, args[i]);
+        max = fmax(max, args[i]);
+    }
+    if (selection & 1) *out_results++ = min;
+    if (selection & 2) *out_results = max;
+}
+
+static OpInfo min_max_classifier(const Operator *op)
+{
+    if (op == &min_op) return (OpInfo){ .kind = OPKIND_CALL, .shared = shared_min_max, .shared_bit = 1 };
+    if (op == &max_op) return (OpInfo){ .kind = OPKIND_CALL, .shared = shared_min_max, .shared_bit = 2 };
+    return (OpInfo){ .kind = OPKIND_CALL };
+}
 
 bool tree_util_test(StringBuilder *error_builder)
 {
@@ -98,6 +188,191 @@ bool tree_util_test(StringBuilder *error_builder)
         ERROR("Unexpected replacement by replace_variable_nodes (or tree_copy broken).\n");
     }
 
+    // Case 6
+    // Cached infos of ancestors must be invalidated when a visitor replaces a descendant
+    update_info(root);
+    update_info(root_copy);
+    Node **grandchild = get_child_addr(get_child(root_copy, 1), 0);
+    if (!has_info(root_copy) || get_hash(root) != get_hash(root_copy))
+    {
+        ERROR("Equal trees have different hashes.\n");
+    }
+    struct SlotReplacement slot_replacement = { .slot = grandchild, .replacement = malloc_constant_node(1, 0) };
+    tree_traverse(&root_copy, NULL, replace_slot_post, &slot_replacement);
+    if (has_info(root_copy) || get_hash(root) == get_hash(root_copy) || tree_equals(root, root_copy))
+    {
+        ERROR("Hash not invalidated after replacement.\n");
+    }
+    update_info(root_copy);
+    slot_replacement.replacement = malloc_variable_node("x", 0, 0);
+    tree_traverse(&root_copy, NULL, replace_slot_post, &slot_replacement);
+    if (get_hash(root) != get_hash(root_copy) || !tree_equals(root, root_copy))
+    {
+        ERROR("Hash not recomputed after replacement.\n");
+    }
+
+    // Case 7
+    // Summary of test(x, test(x, test(x, y)), test(x, y), 42, x)
+    NodeInfo info = get_info(root);
+    if (info.num_nodes != 12 || info.num_variables != 7 || info.depth != 4 || info.op_mask != OP_MASK_BIT(&op))
+    {
+        ERROR("Unexpected summary of tree: %u nodes, %u variables, depth %u.\n",
+            info.num_nodes, info.num_variables, info.depth);
+    }
+
+    // Case 8
+    // Variable names are interned, copies share the symbol
+    size_t num_symbols = symbol_count();
+    Node *var_copy = tree_copy(get_child(root, 0));
+    if (get_var_symbol(var_copy) != symbol_intern("x")
+        || strcmp(symbol_get_name(get_var_symbol(var_copy)), "x") != 0
+        || symbol_count() != num_symbols)
+    {
+        ERROR("Unexpected symbol of variable node.\n");
+    }
+    free_tree(var_copy);
+
+    // Case 9
+    // Traversals do not recurse, a degenerated tree test(test(...test(x, 1)..., 1), 1) must not overflow the stack
+    const size_t deep_depth = 1000000;
+    Node *deep = malloc_variable_node("x", 0, 0);
+    for (size_t i = 0; i < deep_depth; i++)
+    {
+        Node *parent = malloc_operator_node(&op, 2, 0);
+        set_child(parent, 0, deep);
+        set_child(parent, 1, malloc_constant_node(1, 0));
+        deep = parent;
+    }
+    Node *deep_copy = tree_copy(deep);
+    Node *one = malloc_constant_node(1, 0);
+    double deep_res = 0;
+    if (!tree_equals(deep, deep_copy)
+        || get_info(deep).depth != deep_depth + 1
+        || replace_variable_nodes(&deep_copy, one, "x") != 1
+        || tree_equals(deep, deep_copy)
+        || tree_reduce(deep_copy, sum_listener, &deep_res, NULL) != LISTENERERR_SUCCESS
+        || deep_res != deep_depth + 1)
+    {
+        ERROR("Unexpected result of traversing deep tree.\n");
+    }
+    free_tree(one);
+    free_tree(deep);
+    free_tree(deep_copy);
+
+    // Case 10
+    // Freed nodes are recycled by size class: test(x, test(x, y), y, 42, x) has one operator with 2 children
+    node_trim_free_lists();
+    node_reset_alloc_stats();
+    Node *recycled_copy = tree_copy(root);
+    free_tree(recycled_copy);
+    recycled_copy = tree_copy(root);
+    NodeAllocStats stats = node_get_alloc_stats();
+    if (stats.recycled != 12
+        || stats.class_recycled[NODE_CLASS_OP_2] != 3
+        || stats.class_recycled[NODE_CLASS_OP_N] != 1
+        || stats.peak_live != stats.live
+        || stats.cached != 0)
+    {
+        ERROR("Unexpected allocation stats: %zu recycled, %zu live, %zu at peak, %zu cached.\n",
+            stats.recycled, stats.live, stats.peak_live, stats.cached);
+    }
+    free_tree(recycled_copy);
+
+    // Case 11
+    // Common subexpression test(x, y) of test(x, test(x, test(x, y)), test(x, y), 42, x) is computed once, x = 1, y = 2
+    Bytecode bytecode;
+    if (!bytecode_compile(root, pure_classifier, &bytecode))
+    {
+        ERROR("Could not compile tree.\n");
+    }
+    num_listener_calls = 0;
+    double var_values[] = { 1, 2 };
+    double result = 0;
+    if (bytecode_run(&bytecode, sum_listener, var_values, &result, NULL) != LISTENERERR_SUCCESS
+        || result != 51
+        || bytecode.num_temps != 1
+        || num_listener_calls != 3)
+    {
+        ERROR("Unexpected result of evaluation with common subexpression: %zu listener calls.\n", num_listener_calls);
+    }
+    bytecode_destroy(&bytecode);
+
+    // Case 12
+    // sin and cos of x in test(cos(x), 42, sin(x)) are computed by one fused call, for single rows and batches
+    sin_op = op_get_function("sin", 1);
+    cos_op = op_get_function("cos", 1);
+    // Operators are distinguished by id when trees are compared
+    sin_op.id = 1;
+    cos_op.id = 2;
+    Node *trig = malloc_operator_node(&op, 3, 0);
+    set_child(trig, 0, malloc_operator_node(&cos_op, 1, 0));
+    set_child(get_child(trig, 0), 0, malloc_variable_node("x", 0, 0));
+    set_child(trig, 1, malloc_constant_node(42, 0));
+    set_child(trig, 2, malloc_operator_node(&sin_op, 1, 0));
+    set_child(get_child(trig, 2), 0, malloc_variable_node("x", 0, 0));
+    if (!bytecode_compile(trig, trig_classifier, &bytecode))
+    {
+        ERROR("Could not compile tree.\n");
+    }
+    num_fused_calls = 0;
+    result = 0;
+    double x_column[] = { 1, 2 };
+    const double *columns[] = { x_column };
+    double batch_results[2];
+    ListenerError batch_errors[2];
+    if (bytecode_run(&bytecode, sum_listener, var_values, &result, NULL) != LISTENERERR_SUCCESS
+        || result != cos(1) + 42 + sin(1)
+        || bytecode.num_temps != 1
+        || num_fused_calls != 1
+        || bytecode_run_batch(&bytecode, sum_listener, columns, 2, batch_results, batch_errors) != 0
+        || batch_results[1] != cos(2) + 42 + sin(2)
+        || num_fused_calls != 3)
+    {
+        ERROR("Unexpected result of evaluation with fused functions: %zu fused calls.\n", num_fused_calls);
+    }
+    bytecode_destroy(&bytecode);
+    free_tree(trig);
+
+    // Case 13
+    // min and max of (x, 3) in test(max(x, 3), min(x, 3), min(3, x)) are computed by one shared call,
+    // min(3, x) has another argument list
+    min_op = op_get_function("min", OP_DYNAMIC_ARITY);
+    max_op = op_get_function("max", OP_DYNAMIC_ARITY);
+    min_op.id = 1;
+    max_op.id = 2;
+    Node *min_max = malloc_operator_node(&op, 3, 0);
+    set_child(min_max, 0, malloc_operator_node(&max_op, 2, 0));
+    set_child(min_max, 1, malloc_operator_node(&min_op, 2, 0));
+    set_child(min_max, 2, malloc_operator_node(&min_op, 2, 0));
+    for (size_t i = 0; i < 3; i++)
+    {
+        Node *aggregate = get_child(min_max, i);
+        set_child(aggregate, i == 2 ? 1 : 0, malloc_variable_node("x", 0, 0));
+        set_child(aggregate, i == 2 ? 0 : 1, malloc_constant_node(3, 0));
+    }
+    if (!bytecode_compile(min_max, min_max_classifier, &bytecode))
+    {
+        ERROR("Could not compile tree.\n");
+    }
+    num_listener_calls = 0;
+    num_shared_calls = 0;
+    result = 0;
+    x_column[1] = 5;
+    if (bytecode_run(&bytecode, sum_listener, var_values, &result, NULL) != LISTENERERR_SUCCESS
+        || result != 3 + 1 + 4
+        || bytecode.num_temps != 2
+        || num_shared_calls != 1
+        || num_listener_calls != 2
+        || bytecode_run_batch(&bytecode, sum_listener, columns, 2, batch_results, batch_errors) != 0
+        || batch_results[0] != 3 + 1 + 4
+        || batch_results[1] != 5 + 3 + 8
+        || num_shared_calls != 3)
+    {
+        ERROR("Unexpected result of evaluation with shared function: %zu shared calls.\n", num_shared_calls);
+    }
+    bytecode_destroy(&bytecode);
+    free_tree(min_max);
+
     free_tree(root);
     free_tree(root_copy);
     free_tree(child_copy);